@@ -30,7 +30,12 @@
 #include "libfolia/folia_utils.h"
 #include "libfolia/folia_impl.h"
 #include "libfolia/folia_document.h"
+#include "libfolia/folia_xmlwriter.h"
+#include "libfolia/folia_compress.h"
 #include "libfolia/folia_engine.h"
+#include "libfolia/folia_index.h"
+#include "libfolia/folia_columns.h"
+#include "libfolia/folia_export.h"
 #include "libfolia/folia_provenance.h"
 
 #endif
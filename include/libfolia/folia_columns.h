@@ -0,0 +1,123 @@
+/*
+  Copyright (c) 2006 - 2021
+  CLST  - Radboud University
+  ILK   - Tilburg University
+
+  This file is part of libfolia
+
+  libfolia is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  libfolia is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, see <http://www.gnu.org/licenses/>.
+
+  For questions and suggestions, see:
+      https://github.com/LanguageMachines/ticcutils/issues
+  or send mail to:
+      lamasoftware (at ) science.ru.nl
+
+*/
+
+
+#ifndef FOLIA_COLUMNS_H
+#define FOLIA_COLUMNS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "libfolia/folia.h"
+
+namespace folia {
+
+  class string_table {
+    /// a table of unique strings, each identified by a small integer
+  public:
+    int32_t lookup( const std::string& ) const;
+    int32_t intern( const std::string& );
+    /// return the string with id i
+    const std::string& operator[]( size_t i ) const { return _strings[i]; };
+    /// return the number of strings in the table
+    size_t size() const { return _strings.size(); };
+    /// return all strings, in order of their id
+    const std::vector<std::string>& strings() const { return _strings; };
+    void clear();
+  private:
+    std::vector<std::string> _strings;
+    std::unordered_map<std::string,int32_t> _ids;
+  };
+
+  class column {
+    /// one column of a word_columns table
+    /*!
+      A string valued column holds for every row an id into its string
+      table, or -1 when the row has no value. A numeric column holds the
+      values themselves, again using -1 for a missing value.
+    */
+  public:
+    /// the kind of values in the column
+    enum kind { STRINGS, //!< ids into the string table
+		NUMBERS  //!< plain integer values
+    };
+  column( const std::string& n, kind k,
+	  ElementType et = BASE, const std::string& st = "" ):
+    name(n), type(k), element(et), set(st) {};
+    std::string name;      //!< the name of the column
+    kind type;             //!< string valued or numeric
+    ElementType element;   //!< for annotation columns: the annotation type
+    std::string set;       //!< for annotation columns: the set. May be empty
+    string_table table;    //!< the strings, for a STRINGS column
+    std::vector<int32_t> values; //!< the ids or values, one per row
+    /// return the string value of row i, or "" when not present
+    const std::string& str( size_t i ) const {
+      static const std::string empty;
+      return values[i] < 0 ? empty : table[values[i]];
+    };
+  };
+
+  class word_columns {
+    /// a columnar view on the Words of a Document
+    /*!
+      One call to extract() walks all Words of a Document once, and fills
+      a row per Word. The fixed columns are:
+      - text: the text of the Word
+      - sentence: the xml:id of the Sentence the Word belongs to
+      - offset: the offset of the text of the Word, when available
+      - length: the length in characters (code points) of the text of the
+      Word
+      Further columns hold the class of an annotation of a given type and
+      (optionally) set, found like annotation<>() does. So also inside a
+      Correction, but not in Alternatives or Suggestions. By default pos
+      and lemma are added.
+
+      The table can be written to a simple binary file using write()
+    */
+  public:
+    word_columns();
+    void add_column( ElementType,
+		     const std::string& = "",
+		     const std::string& = "" );
+    void clear_annotation_columns();
+    size_t extract( const Document&, const std::string& = "current" );
+    void clear();
+    /// return the number of rows
+    size_t rows() const { return _rows; };
+    /// return all columns
+    const std::vector<column>& columns() const { return _columns; };
+    const column& operator[]( const std::string& ) const;
+    void write( const std::string& ) const;
+    void write( std::ostream& ) const;
+  private:
+    std::vector<column> _columns;
+    size_t _rows;
+  };
+
+}
+#endif // FOLIA_COLUMNS_H
@@ -0,0 +1,97 @@
+/*
+  Copyright (c) 2006 - 2021
+  CLST  - Radboud University
+  ILK   - Tilburg University
+
+  This file is part of libfolia
+
+  libfolia is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  libfolia is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, see <http://www.gnu.org/licenses/>.
+
+  For questions and suggestions, see:
+      https://github.com/LanguageMachines/ticcutils/issues
+  or send mail to:
+      lamasoftware (at ) science.ru.nl
+
+*/
+
+#ifndef FOLIA_COMPRESS_H
+#define FOLIA_COMPRESS_H
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <streambuf>
+
+namespace folia {
+
+  /// the compression formats for output
+  enum class COMPRESSION {
+    NONE,  //!< no compression
+    GZIP,  //!< gzip format (.gz)
+    BZIP2, //!< bzip2 format (.bz2)
+    XZ,    //!< xz format (.xz) Only when built with liblzma
+    ZSTD   //!< zstandard format (.zst) Only when built with libzstd
+  };
+
+  COMPRESSION compression_for( const std::string& );
+  bool compression_available( COMPRESSION );
+
+  class compressor;
+
+  /// a std::streambuf that compresses everything written to it, on the fly,
+  /// into another std::streambuf
+  ///
+  /// The data is handed to the compressor in blocks. A sync() (flush) only
+  /// passes the buffered data on to the compressor. The compressed stream
+  /// is only complete after finish().
+  class compressing_streambuf: public std::streambuf {
+  public:
+    compressing_streambuf( std::streambuf *,
+			   COMPRESSION,
+			   int = -1,
+			   size_t = 0 );
+    ~compressing_streambuf();
+    bool finish();
+  protected:
+    int_type overflow( int_type );
+    int sync();
+  private:
+    compressing_streambuf( const compressing_streambuf& ); // inhibit copies
+    compressing_streambuf& operator=( const compressing_streambuf& ); // inhibit copies
+    bool compress_buffer( bool );
+    std::streambuf *_dest;
+    compressor *_compressor;
+    std::vector<char> _buffer;
+    bool _finished;
+  };
+
+  /// an output file stream, which compresses the data on the fly
+  class compressed_ofstream: public std::ostream {
+  public:
+    explicit compressed_ofstream( const std::string&,
+				  COMPRESSION = COMPRESSION::NONE,
+				  int = -1,
+				  size_t = 0 );
+    ~compressed_ofstream();
+    bool is_open() const { return _file.is_open(); };
+    void close();
+  private:
+    std::filebuf _file;
+    compressing_streambuf *_zbuf;
+  };
+
+} // namespace folia
+
+#endif // FOLIA_COMPRESS_H
@@ -51,23 +51,46 @@ namespace folia {
   class Pattern {
     friend std::ostream& operator<<( std::ostream&, const Pattern& );
   public:
+    /// the different kinds of terms a Pattern sequence can hold
+    enum term_kind {
+      LITERAL, //!< match a (possibly lowercased) string
+      REGEX,   //!< match a regular expression
+      ANY,     //!< "*:1" match exactly one arbitrary word
+      GAP      //!< "*" match a gap of upto maxgapsize arbitrary words
+    };
     Pattern( const std::vector<std::string>&,
 	     const ElementType = BASE,
 	     const std::string& = "" );
     Pattern( const std::vector<std::string>&,  const std::string& );
-
+    Pattern( const Pattern& );
+    Pattern& operator=( const Pattern& );
     ~Pattern();
     bool match( const UnicodeString& , size_t&, int&, bool&, bool& ) const;
+    bool step( const UnicodeString&, const UnicodeString&,
+	       size_t&, int&, bool&, bool& ) const;
+    term_kind kind( size_t pos ) const {
+      /// return the kind of the term at position \e pos
+      return kinds[pos];
+    };
+    const UnicodeString& term( size_t pos ) const {
+      /// return the literal value of the term at position \e pos
+      return sequence[pos];
+    };
     size_t size() const { return sequence.size(); };
+    int max_gap() const { return maxgapsize; };
+    bool is_case_sensitive() const { return case_sensitive; };
     void unsetwild();
     bool variablesize() const;
     std::set<int> variablewildcards() const;
     ElementType matchannotation;
     bool regexp;
   private:
+    void init( const std::vector<std::string>&, const std::string& );
+    void clear_matchers();
     bool case_sensitive;
     int maxgapsize;
     std::vector<UnicodeString> sequence;
+    std::vector<term_kind> kinds;
     std::vector<RegexMatcher*> matchers;
     std::string matchannotationset;
   };
@@ -76,8 +99,21 @@ namespace folia {
   class Word;
   class Sentence;
   class Paragraph;
+  class Utterance;
   class processor;
   class Provenance;
+  class XmlWriter;
+
+  /// the position of a Word, String or TextContent in the text of its
+  /// reference element, as returned by Document::text_spans()
+  struct text_span {
+    FoliaElement *element;   //!< the Word, String or TextContent
+    FoliaElement *reference; //!< the element whose text contains it
+    size_t begin;            //!< start, in code points
+    size_t end;              //!< end (exclusive), in code points
+    size_t byte_begin;       //!< start, in UTF-8 bytes
+    size_t byte_end;         //!< end (exclusive), in UTF-8 bytes
+  };
 
   class Document {
     friend std::ostream& operator<<( std::ostream& os, const Document *d );
@@ -93,7 +129,9 @@ namespace folia {
       STRIP=8,         //!< on output, strip
       CANONICAL=16,    //!< sort ouput in a reproducable way.
       AUTODECLARE=32,  //!< Automagicly add missing Annotation Declarations
-      EXPLICIT=64      //!< add all set information
+      EXPLICIT=64,     //!< add all set information
+      KEEPSOURCE=128,  //!< keep the source, to reuse it for unmodified nodes
+      COMPACT=256      //!< on output, don't indent
     };
     friend class Engine;
   public:
@@ -124,6 +162,9 @@ namespace folia {
       return save( s, "", canonical );
     }
     std::string xmlstring( bool = false ) const;
+    void save_binary( std::ostream& ) const;
+    bool save_binary( const std::string& ) const;
+    bool read_from_binary( const std::string& );
 
     FoliaElement* doc() const {
       /// return a pointer to the internal FoLiA tree
@@ -157,6 +198,21 @@ namespace folia {
     UnicodeString text( const std::string& = "current",
 			bool = false,
 			bool = false ) const;
+    UnicodeString parallel_text( const std::string& = "current",
+				 bool = false,
+				 bool = false,
+				 unsigned int = 0 ) const;
+    UnicodeString corrected_text( CORRECTION_HANDLING,
+				  size_t = 0,
+				  const std::string& = "current",
+				  bool = false ) const;
+    void parallel_for_each( ElementType,
+			    const std::function<void(FoliaElement*)>&,
+			    unsigned int = 0 ) const;
+    std::vector<std::pair<Utterance*,UnicodeString> >
+      utterance_transcriptions( const std::string& = "current",
+				unsigned int = 1 ) const;
+    std::vector<text_span> text_spans( const std::string& = "current" ) const;
     std::vector<Paragraph*> paragraphs() const;
     std::vector<Sentence*> sentences() const;
     std::vector<Sentence*> sentenceParts() const;
@@ -165,6 +221,8 @@ namespace folia {
 						const std::string& ="" ) const;
     std::vector<std::vector<Word*> > findwords( std::list<Pattern>&,
 						const std::string& = "" ) const;
+    std::vector<std::vector<std::vector<Word*> > > findwords_per_pattern( const std::list<Pattern>&,
+									    const std::string& = "" ) const;
     Word *words( size_t ) const;
     Word *rwords( size_t ) const;
     Paragraph *paragraphs( size_t ) const;
@@ -186,6 +244,8 @@ namespace folia {
     void del_doc_index( const std::string& );
 
     FoliaElement *index( const std::string& ) const; //retrieve element with specified ID
+    FoliaElement *index( const char *, size_t ) const;
+    std::vector<FoliaElement*> index_prefix( const std::string& ) const;
     FoliaElement* operator []( const std::string& ) const ; //index as operator
     bool declared( const AnnotationType&,
 		   const std::string&,
@@ -273,6 +333,13 @@ namespace folia {
     };
     void resolveExternals();
     int debug; //!< the debug level. 0 means NO debugging.
+    unsigned int threads; //!< the number of threads to use for offset
+    //!< validation and for saving. 1 (the default) means sequential,
+    //!< 0 one per core.
+    int compression_level; //!< the compression level for compressed output
+    //!< files. -1 (the default) means the default for the format
+    size_t compression_blocksize; //!< the size of the blocks handed to the
+    //!< compressor. 0 (the default) means 64 KiB
 
     /// is the PERMISSIVE mode set?
     bool permissive() const { return mode & PERMISSIVE; };
@@ -287,6 +354,10 @@ namespace folia {
     /// is the AUTODECLARE mode set?
     bool autodeclare() const { return mode & AUTODECLARE; };
     bool has_explicit() const { return mode & EXPLICIT; };
+    /// is the KEEPSOURCE mode set?
+    bool keepsource() const { return mode & KEEPSOURCE; };
+    /// is the COMPACT mode set?
+    bool compact() const { return mode & COMPACT; };
     bool set_permissive( bool ) const; // defined const, but the mode is mutable!
     bool set_checktext( bool ) const; // defined const, but the mode is mutable!
     bool set_fixtext( bool ) const; // defined const, but the mode is mutable!
@@ -294,6 +365,8 @@ namespace folia {
     bool set_canonical( bool ) const; // defined const, but the mode is mutable!
     bool set_autodeclare( bool ) const; // defined const, but the mode is mutable!
     bool set_explicit( bool ) const; // defined const, but the mode is mutable!
+    bool set_keepsource( bool ) const; // defined const, but the mode is mutable!
+    bool set_compact( bool ) const; // defined const, but the mode is mutable!
     /// this class holds annotation declaration information
     class at_t {
       friend std::ostream& operator<<( std::ostream& os, const at_t& at );
@@ -423,15 +496,24 @@ namespace folia {
     void parse_styles();
     void add_annotations( xmlNode * ) const;
     void add_provenance( xmlNode * ) const;
-    void add_metadata( xmlNode * ) const;
-    void add_submetadata( xmlNode *) const;
+    /// placeholder nodes in the skeleton, and the ForeignData they stand for
+    typedef std::map<const xmlNode*,const FoliaElement*> foreign_map;
+    xmlNode *foreign_node( const FoliaElement *, foreign_map * ) const;
+    void add_metadata( xmlNode *, foreign_map * =0 ) const;
+    void add_submetadata( xmlNode *, foreign_map * =0 ) const;
     void add_styles( xmlDoc* ) const;
     void append_processor( xmlNode *, const processor * ) const;
+    xmlDoc *xml_skeleton( const std::string&, foreign_map * =0 ) const;
     xmlDoc *to_xmlDoc( const std::string& ="" ) const;
+    void write_header( XmlWriter&, const std::string& ="" ) const;
+    void write_xml( XmlWriter&, const std::string& ="" ) const;
+    void save_source_state();
+    bool source_usable() const;
+    std::string declaration_state( AnnotationType ) const;
     void add_one_anno( const std::pair<AnnotationType,std::string>&,
 		       xmlNode *,
 		       std::set<std::string>& ) const;
-    std::map<std::string, FoliaElement* > sindex; ///< the lookup table
+    id_index sindex; ///< the lookup table
     ///< for FoliaElements by index (xml:id) (not all nodes do have an index)
     //    std::vector<FoliaElement*> data;
     std::vector<External*> _externals;
@@ -456,6 +538,11 @@ namespace folia {
     std::string patch_version;
     bool _external_document;
     bool _incremental_parse;
+    std::string _source; ///< the source XML, in KEEPSOURCE mode
+    std::map<AnnotationType,std::string> _source_declarations; ///< the
+    ///< declarations as they were after reading the source
+    Mode _source_mode; ///< the output related modes after reading the source
+    std::string _source_version; ///< the version after reading the source
     Document( const Document& ); // inhibit copies
     Document& operator=( const Document& ); // inhibit copies
   };
@@ -492,6 +579,7 @@ namespace folia {
 
   std::string library_version();
   std::string folia_version();
+  bool is_binary_folia( std::istream& );
 
 } // namespace folia
 
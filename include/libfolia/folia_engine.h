@@ -30,9 +30,12 @@
 
 #include <string>
 #include <set>
+#include <map>
 #include <vector>
 #include <iostream>
+#include <chrono>
 #include "ticcutils/LogStream.h"
+#include "ticcutils/Unicode.h"
 #include "libfolia/folia.h"
 #include "libxml/xmlreader.h"
 
@@ -61,6 +64,11 @@ namespace folia {
     enum doctype { TEXT, //!< the topnode is \<text>
 		   SPEECH //!< the topnode is \<speech>
     };
+    /// when the output of flush() is passed on to the output stream
+    enum flush_policy { FLUSH_BYTES, //!< when more than N bytes are waiting
+			FLUSH_ELEMENTS, //!< after every N elements
+			FLUSH_TIME //!< when N milliseconds have passed
+    };
     Engine(); //!< default constructor. needs a call to init_doc() to get started
   Engine( const std::string& i, const std::string& o="" ):
     Engine() {
@@ -81,6 +89,7 @@ namespace folia {
     bool output_footer();
     bool flush();
     bool finish();
+    void set_flush_policy( flush_policy, size_t );
     /// return the status of the Engine. True when still valid. False otherwise.
     bool ok() const { return _ok; };
     void un_declare( const AnnotationType&,
@@ -116,9 +125,13 @@ namespace folia {
     doctype _doc_type;      //!< do we process TEXT or SPEECH?
     TiCC::LogStream *_dbg_file; //!< the debugging stream
     std::ostream *_os;      //!< optional outputstream
+    XmlWriter *_writer;     //!< the buffered serializer on _os
+    flush_policy _flush_policy; //!< when to pass output on to _os
+    size_t _flush_limit;    //!< the N of the _flush_policy
+    size_t _pending;        //!< elements written since the last sync
+    std::chrono::steady_clock::time_point _last_sync; //!< time of the last sync
     std::string _out_name;  //!< the name of the output file connected to _os
     std::string ns_prefix;  //!< a namespace name to use. (copied from the input file)
-    std::string _footer;    //!< the constructed string to output at the end
     bool _ok;               //!< are we fine?
     bool _done;             //!< are we done parsing?
     bool _header_done;      //!< is the header outputed yet?
@@ -132,6 +145,7 @@ namespace folia {
     void add_comment( int );
     void add_text( int );
     void append_node( FoliaElement *, int );
+    void sync_output( bool );
   };
 
   class TextEngine: public Engine {
@@ -166,5 +180,63 @@ namespace folia {
     bool _is_setup;
   };
 
+  class TextExtractor {
+    /// a single pass extractor of the running text of a FoLiA file
+    /*!
+      The text of every element of a chosen type (e.g. Paragraph_t) is
+      assembled while reading the file with an xmlTextReader. No
+      FoliaElements are created. The result equals the text() of those
+      elements in a fully parsed Document: delimiters, space="no",
+      hidden words and corrections are handled the same way.
+    */
+  public:
+    TextExtractor();
+    TextExtractor( const std::string& i,
+		   ElementType unit = Paragraph_t,
+		   const std::string& textclass = "current" ):
+    TextExtractor(){
+      /// construct and initialize a TextExtractor
+      /*!
+	\param i the input file, or a buffer holding a complete document
+	\param unit the type of the elements to extract the text of
+	\param textclass the textclass to extract
+      */
+      init( i, unit, textclass );
+    }
+    ~TextExtractor();
+    bool init( const std::string&,
+	       ElementType = Paragraph_t,
+	       const std::string& = "current" );
+    bool next( std::string&, std::string& );
+    size_t count() const {
+      /// return the number of units returned by next() so far
+      return _count;
+    };
+  private:
+    TextExtractor( const TextExtractor& ); // inhibit copies
+    TextExtractor& operator=( const TextExtractor& ); // inhibit copies
+    struct tag_info;
+    struct frame;
+    const tag_info *info( const std::string& );
+    frame *new_frame();
+    void open_element();
+    void close_element();
+    void add_text();
+    void add_comment();
+    void add_child( frame&, const frame& );
+    const std::string& delimiter( const frame& ) const;
+    xmlTextReader *_reader;
+    ElementType _unit;
+    std::string _textclass;
+    std::map<std::string,tag_info*> _infos;
+    std::vector<frame*> _stack;
+    std::vector<frame*> _pool;
+    std::string _ready_id;
+    std::string _ready_text;
+    bool _has_ready;
+    size_t _count;
+    TiCC::UnicodeNormalizer _nfc;
+  };
+
 }
 #endif // FOLIA_ENGINE_H
@@ -0,0 +1,119 @@
+/*
+  Copyright (c) 2006 - 2021
+  CLST  - Radboud University
+  ILK   - Tilburg University
+
+  This file is part of libfolia
+
+  libfolia is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  libfolia is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, see <http://www.gnu.org/licenses/>.
+
+  For questions and suggestions, see:
+      https://github.com/LanguageMachines/ticcutils/issues
+  or send mail to:
+      lamasoftware (at ) science.ru.nl
+
+*/
+
+
+
+#ifndef FOLIA_EXPORT_H
+#define FOLIA_EXPORT_H
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <unordered_map>
+#include "libfolia/folia.h"
+
+namespace folia {
+
+  class TokenExporter {
+    /// export the Words of a FoLiA document in a token-per-line format
+    /*!
+      Every top level Sentence is visited once. While walking its subtree,
+      the Words are collected together with their pos, lemma and
+      morphological features, and the Dependencies found in its
+      DependenciesLayers are resolved to heads. No select() is used.
+
+      Two formats are supported:
+      - CONLLU: the 10 column CoNLL-U format, with a '# sent_id' and a
+      '# text' comment per sentence and an empty line after it.
+      - TSV: one header line, then one line per Word with the columns
+      sentence, id, form, lemma, upos, xpos, feats, head and deprel.
+
+      Values that are not available are written as '_'. A Word is only
+      written as the root (head 0) when a Dependency without a head has it
+      as dependent. Sentences nested
+      in e.g. a Quote are part of the enclosing sentence, Words in an
+      Original, Suggestion or Alternative are skipped.
+    */
+  public:
+    /// the output format
+    enum format { CONLLU, //!< CoNLL-U
+		  TSV     //!< tab separated values with a header line
+    };
+    explicit TokenExporter( format = CONLLU );
+    void set_upos_set( const std::string& s ) {
+      /// set the pos set for the UPOS column. Empty means: any set
+      _upos_set = s;
+    };
+    void set_xpos_set( const std::string& s ) {
+      /// set the pos set for the XPOS column. Empty means: no XPOS
+      _xpos_set = s;
+    };
+    void set_lemma_set( const std::string& s ) {
+      /// set the lemma set. Empty means: any set
+      _lemma_set = s;
+    };
+    void set_dependency_set( const std::string& s ) {
+      /// set the dependency set. Empty means: any set
+      _dep_set = s;
+    };
+    void set_textclass( const std::string& s ) {
+      /// set the textclass for the forms and the sentence text
+      _textclass = s;
+    };
+    size_t export_sentence( std::ostream&, const FoliaElement * );
+    size_t export_document( std::ostream&, const Document& );
+    size_t export_engine( std::ostream&, Engine& );
+    /// return the number of sentences exported so far
+    size_t sentences() const { return _sentences; };
+  private:
+    struct token {
+      /// the annotations of one Word of the current sentence
+      const FoliaElement *word;
+      const FoliaElement *upos;
+      const FoliaElement *xpos;
+      const FoliaElement *lemma;
+      size_t head;         //!< 1-based position of the head, 0 for the root
+      std::string deprel;
+      bool attached;       //!< a Dependency gave us a head, or made us root
+    };
+    void collect( const FoliaElement * );
+    void add_word( const FoliaElement * );
+    void add_dependencies( const FoliaElement * );
+    format _format;
+    std::string _upos_set;
+    std::string _xpos_set;
+    std::string _lemma_set;
+    std::string _dep_set;
+    std::string _textclass;
+    size_t _sentences;
+    std::vector<token> _tokens;
+    std::unordered_map<const FoliaElement*,size_t> _positions;
+    std::vector<const FoliaElement*> _dependencies;
+  };
+
+}
+#endif // FOLIA_EXPORT_H
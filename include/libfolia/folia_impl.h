@@ -42,6 +42,7 @@ using namespace icu;
 
 namespace folia {
   class Document;
+  class XmlWriter;
   class AbstractSpanAnnotation;
   class Alternative;
   class PosAnnotation;
@@ -106,6 +107,17 @@ namespace folia {
       TOP_HIT=2 //!< like recurse, but do NOT recurse into sibblings of matching nodes
       };
 
+  /// class used to steer which text of a Correction 'text()' returns
+  enum class CORRECTION_HANDLING {
+    NEW=0,        /*!< the text of the New node, or else the Current, or
+		    else the Original. This is the default.
+		  */
+      ORIGINAL=1, //!< the text of the Original node, or else the Current
+      SUGGESTION=2 /*!< the text of a given Suggestion node. Corrections
+		     without that Suggestion use the default.
+		   */
+      };
+
 #define NOT_IMPLEMENTED {						\
     throw NotImplementedError( xmltag() + "::" + std::string(__func__) ); \
   }
@@ -320,11 +332,13 @@ namespace folia {
     const std::string xmlstring( bool=true ) const; // serialize to a string (XML fragment)
     const std::string xmlstring( bool, int=0, bool=true ) const; // serialize to a string (XML fragment)
     virtual xmlNode *xml( bool, bool = false ) const = 0; //serialize to XML
+    virtual void write_xml( XmlWriter&, bool = false ) const = 0; //serialize to XML text
 
     // text/string content
     bool hastext( const std::string& = "current" ) const;
     bool hasphon( const std::string& = "current" ) const;
     virtual void check_text_consistency(bool = true) const = 0;
+    virtual void precheck_text_consistency() const = 0;
     virtual void check_text_consistency_while_parsing(bool = true) = 0; //can't we merge these two somehow?
     virtual void check_append_text_consistency( const FoliaElement * ) const = 0;
 
@@ -339,16 +353,36 @@ namespace folia {
     virtual const UnicodeString text( const std::string&,
 				      TEXT_FLAGS = TEXT_FLAGS::NONE ) const = 0;
     virtual const UnicodeString text( TEXT_FLAGS = TEXT_FLAGS::NONE ) const = 0;
+    virtual bool try_text( UnicodeString&,
+			   const std::string& = "current",
+			   TEXT_FLAGS = TEXT_FLAGS::NONE ) const = 0;
+    virtual const std::string *text_view( const std::string& = "current" ) const = 0;
+    virtual void clear_text_cache() const = 0;
+    void invalidate_text_cache() const;
+    virtual unsigned int text_generation() const = 0;
+    virtual void count_modification() const = 0;
+    void mark_modified() const;
     const UnicodeString stricttext( const std::string& = "current", bool = true ) const;
+    const UnicodeString parallel_text( const std::string& = "current",
+				       TEXT_FLAGS = TEXT_FLAGS::NONE,
+				       unsigned int = 0 ) const;
+    const UnicodeString corrected_text( CORRECTION_HANDLING,
+					size_t = 0,
+					const std::string& = "current",
+					TEXT_FLAGS = TEXT_FLAGS::NONE ) const;
     const UnicodeString toktext( const std::string& = "current", bool = true ) const;
     virtual const UnicodeString phon( const std::string&,
 				      TEXT_FLAGS = TEXT_FLAGS::NONE ) const = 0;
     virtual const UnicodeString phon( TEXT_FLAGS = TEXT_FLAGS::NONE ) const = 0;
+    virtual bool try_phon( UnicodeString&,
+			   const std::string& = "current",
+			   TEXT_FLAGS = TEXT_FLAGS::NONE ) const = 0;
     virtual bool printable() const = 0;
     virtual bool speakable() const = 0;
     virtual bool referable() const = 0;
     virtual bool is_textcontainer() const = 0;
     virtual bool is_phoncontainer() const = 0;
+    virtual bool hidden() const = 0;
     virtual bool space() const NOT_IMPLEMENTED;
 
     // Word
@@ -403,6 +437,8 @@ namespace folia {
     // TextContent
     virtual const TextContent *text_content( const std::string& = "current",
 					     bool = false ) const = 0;
+    virtual const TextContent *find_text_content( const std::string& = "current",
+						  bool = false ) const = 0;
     TextContent *settext( const std::string&,
 			  const std::string& = "current" );
     TextContent *settext( const std::string&,
@@ -420,6 +456,8 @@ namespace folia {
     // PhonContent
     virtual const PhonContent *phon_content( const std::string& = "current",
 					     bool = false ) const = 0;
+    virtual const PhonContent *find_phon_content( const std::string& = "current",
+						  bool = false ) const = 0;
 
     // properties
     virtual const std::string& get_delimiter( bool=false ) const = 0;
@@ -448,6 +486,7 @@ namespace folia {
     virtual Attrib optional_attributes() const = 0;
     virtual const std::string& xmltag() const = 0;
     const std::string& classname() const { return xmltag(); }; //synomym
+    virtual const std::string& text_delimiter() const = 0;
     virtual const std::string& default_subset() const = 0;
     virtual const std::string subset() const NOT_IMPLEMENTED;
     virtual bool setonly() const = 0;
@@ -492,8 +531,14 @@ namespace folia {
     virtual bool checkAtts() = 0;
     virtual const UnicodeString deeptext( const std::string& = "current",
 					  TEXT_FLAGS = TEXT_FLAGS::NONE ) const NOT_IMPLEMENTED;
+    virtual bool try_deeptext( UnicodeString&,
+			       const std::string& = "current",
+			       TEXT_FLAGS = TEXT_FLAGS::NONE ) const NOT_IMPLEMENTED;
     virtual const UnicodeString deepphon( const std::string& = "current",
 					  TEXT_FLAGS = TEXT_FLAGS::NONE ) const NOT_IMPLEMENTED;
+    virtual bool try_deepphon( UnicodeString&,
+			       const std::string& = "current",
+			       TEXT_FLAGS = TEXT_FLAGS::NONE ) const NOT_IMPLEMENTED;
 
 
     virtual std::vector<FoliaElement*> select( ElementType,
@@ -642,11 +687,20 @@ namespace folia {
     }
 
     const std::string annotator( ) const { return _annotator; };
-    void annotator( const std::string& a ) { _annotator = a; };
+    void annotator( const std::string& a ) {
+      _annotator = a;
+      mark_modified();
+    };
     const std::string processor( ) const { return _processor; };
-    void processor( const std::string& p ) { _processor = p; };
+    void processor( const std::string& p ) {
+      _processor = p;
+      mark_modified();
+    };
     AnnotatorType annotatortype() const { return _annotator_type; };
-    void annotatortype( AnnotatorType t ) { _annotator_type =  t; };
+    void annotatortype( AnnotatorType t ) {
+      _annotator_type =  t;
+      mark_modified();
+    };
 
     template <typename F>
       F *addAnnotation( const KWargs& args ) {
@@ -671,22 +725,50 @@ namespace folia {
 				      bool = false,
 				      bool = false,
                                       bool = true) const;
+    virtual bool private_try_text( UnicodeString&,
+				   const std::string& = "current",
+				   bool = false,
+				   bool = false,
+				   bool = false,
+				   bool = true ) const;
+    virtual void throw_no_text( const std::string&,
+				bool, bool, bool ) const;
+    virtual bool private_try_phon( UnicodeString&,
+				   const std::string& = "current",
+				   TEXT_FLAGS = TEXT_FLAGS::NONE ) const;
     const UnicodeString text( const std::string&,
 			      TEXT_FLAGS = TEXT_FLAGS::NONE ) const;
     const UnicodeString text( TEXT_FLAGS flags = TEXT_FLAGS::NONE ) const {
       return text( "current", flags );
     }
+    bool try_text( UnicodeString&,
+		   const std::string& = "current",
+		   TEXT_FLAGS = TEXT_FLAGS::NONE ) const;
+    const std::string *text_view( const std::string& = "current" ) const;
 
     const UnicodeString phon( const std::string&,
 			      TEXT_FLAGS = TEXT_FLAGS::NONE ) const;
     const UnicodeString phon( TEXT_FLAGS flags = TEXT_FLAGS::NONE ) const {
       return phon( "current", flags );
     }
+    bool try_phon( UnicodeString&,
+		   const std::string& = "current",
+		   TEXT_FLAGS = TEXT_FLAGS::NONE ) const;
 
     const UnicodeString deeptext( const std::string& = "current",
 				  TEXT_FLAGS = TEXT_FLAGS::NONE ) const;
+    bool try_deeptext( UnicodeString&,
+		       const std::string& = "current",
+		       TEXT_FLAGS = TEXT_FLAGS::NONE ) const;
     const UnicodeString deepphon( const std::string& = "current",
 				  TEXT_FLAGS = TEXT_FLAGS::NONE ) const;
+    bool try_deepphon( UnicodeString&,
+		       const std::string& = "current",
+		       TEXT_FLAGS = TEXT_FLAGS::NONE ) const;
+    void clear_text_cache() const;
+    unsigned int text_generation() const { return _text_generation; };
+    void count_modification() const;
+    void mark_text_checked() const;
 
     // Word
     const Word* resolveword( const std::string& ) const { return 0; };
@@ -695,9 +777,13 @@ namespace folia {
     // TextContent
     const TextContent *text_content( const std::string& = "current",
 				    bool = false ) const;
+    const TextContent *find_text_content( const std::string& = "current",
+					  bool = false ) const;
     // PhonContent
     const PhonContent *phon_content( const std::string& = "current",
 				    bool = false ) const;
+    const PhonContent *find_phon_content( const std::string& = "current",
+					  bool = false ) const;
 
     // properties
     const std::string& get_delimiter( bool=false ) const;
@@ -705,8 +791,14 @@ namespace folia {
     // attributes
     const std::string cls() const { return _class; };
     const std::string sett() const { return _set; };
-    void update_cls( const std::string& cls ) { _class = cls; };
-    void update_set( const std::string& st ) { _set = st; };
+    void update_cls( const std::string& cls ) {
+      _class = cls;
+      invalidate_text_cache();
+    };
+    void update_set( const std::string& st ) {
+      _set = st;
+      mark_modified();
+    };
     const std::string n() const { return _n; };
     const std::string id() const { return _id; };
     const std::string begintime() const { return _begintime; };
@@ -718,7 +810,10 @@ namespace folia {
     bool space() const { return _space; };
     const std::string src() const { return _src; };
     double confidence() const { return _confidence; };
-    void confidence( double d ) { _confidence = d; };
+    void confidence( double d ) {
+      _confidence = d;
+      mark_modified();
+    };
 
     // generic properties
     ElementType element_id() const;
@@ -728,6 +823,7 @@ namespace folia {
     Attrib optional_attributes() const;
     bool hidden() const;
     const std::string& xmltag() const;
+    const std::string& text_delimiter() const;
     const std::string& default_subset() const;
     AnnotationType annotation_type() const;
     const std::set<ElementType>& accepted_data() const;
@@ -762,6 +858,10 @@ namespace folia {
 
   protected:
     xmlNode *xml( bool, bool = false ) const;
+    void write_xml( XmlWriter&, bool = false ) const;
+    KWargs xml_attributes( std::set<FoliaElement*>& ) const;
+    std::vector<FoliaElement*> xml_children( const std::set<FoliaElement*>&,
+					     bool ) const;
     void setAttributes( KWargs& );
     bool checkAtts();
     void set_typegroup( KWargs& ) const;
@@ -770,18 +870,43 @@ namespace folia {
     void increfcount() { ++_refcount; };
     void decrefcount() { --_refcount; };
     void resetrefcount() { _refcount = 0; };
-    void setAuth( bool b ){ _auth = b; };
+    void setAuth( bool b ){
+      _auth = b;
+      mark_modified();
+    };
     xmlNs *foliaNs() const;
     bool acceptable( ElementType ) const;
     bool addable( const FoliaElement * ) const;
     void setDateTime( const std::string& );
     const std::string getDateTime() const;
     void check_text_consistency(bool = true) const;
+    void precheck_text_consistency() const;
     void check_text_consistency_while_parsing(bool = true); //can't we merge these two somehow?
     void check_append_text_consistency( const FoliaElement * ) const;
     void check_declaration();
   private:
     void addFeatureNodes( const KWargs& args );
+    bool text_cacheable() const;
+    bool text_checked() const;
+    bool parent_text_matches( bool,
+			      UnicodeString&,
+			      UnicodeString& ) const;
+    struct text_cache_entry;
+    mutable std::vector<text_cache_entry> *_text_cache; ///< the memoized
+    ///< results of text(), per textclass and flags. 0 when empty
+    mutable unsigned int _text_generation; ///< incremented on every
+    ///< modification of this node or its descendants
+    mutable const FoliaElement *_checked_parent; ///< the parent our text was
+    ///< last found consistent with. 0 when not checked
+    mutable unsigned int _checked_generation; ///< the text_generation() of
+    ///< _checked_parent at that moment
+    size_t _source_begin; ///< the start of our XML in the source of the
+    ///< Document, in KEEPSOURCE mode
+    size_t _source_end; ///< the end of our XML in the source. 0 when unknown
+    mutable unsigned int _modifications; ///< incremented on every
+    ///< modification of this node or its descendants that changes the XML
+    unsigned int _source_generation; ///< our _modifications when parsed.
+    ///< when it changed, we are modified and the source is outdated
     Document *_mydoc;
     FoliaElement *_parent;
     bool _auth;
@@ -1084,6 +1209,7 @@ namespace folia {
       AbstractSpanAnnotation( PROPS, d ){};
     public:
       xmlNode *xml( bool, bool=false ) const;
+      void write_xml( XmlWriter&, bool=false ) const;
       FoliaElement *append( FoliaElement* );
 
       std::vector<FoliaElement*> wrefs() const;
@@ -1114,6 +1240,7 @@ namespace folia {
 
     FoliaElement* parseXml( const xmlNode * );
     xmlNode *xml( bool, bool=false ) const;
+    void write_xml( XmlWriter&, bool=false ) const;
     void set_data( const xmlNode * );
     xmlNode* get_data() const;
   private:
@@ -1121,7 +1248,9 @@ namespace folia {
     AbstractElement( props, d ){ classInit(); };
     void init();
     static properties PROPS;
-    xmlNode *_foreign_data;
+    std::string _data;      //!< the data, as unformatted XML text
+    std::string _formatted; //!< the data formatted at level _level, if it differs
+    size_t _level;
   };
 
 #define META_NOT_IMPLEMENTED {						\
@@ -1249,6 +1378,12 @@ namespace folia {
 				      bool = false,
 				      bool = false,
                                       bool = true) const;
+    bool private_try_text( UnicodeString&,
+			   const std::string& = "current",
+			   bool = false,
+			   bool = false,
+			   bool = false,
+			   bool = true ) const;
     static properties PROPS;
     std::string _original;
   };
@@ -1344,11 +1479,16 @@ namespace folia {
       }
       FoliaElement *postappend();
       FoliaElement *get_reference() const;
+      FoliaElement *find_reference() const;
+      FoliaElement *find_default_reference() const;
+      void check_offset( const FoliaElement *, const UnicodeString& ) const;
       std::string ref() const { return _ref; };
     private:
       void init();
-      FoliaElement *find_default_reference() const;
-      void set_offset( int o ) const { _offset = o; }; // this MUST be const,
+      void set_offset( int o ) const { // this MUST be const,
+	_offset = o;
+	mark_modified();
+      };
       // only used for 'fixing up' invalid offsets. keep it private!
       // therefore _offset  has to be mutable!
       static properties PROPS;
@@ -1365,16 +1505,22 @@ namespace folia {
     AbstractContentAnnotation(PROPS,d){ classInit( a ); }
     void setAttributes( KWargs& );
     KWargs collectAttributes() const;
-    const UnicodeString phon( const std::string& = "current",
-			      TEXT_FLAGS = TEXT_FLAGS::NONE ) const;
+    bool private_try_phon( UnicodeString&,
+			   const std::string& = "current",
+			   TEXT_FLAGS = TEXT_FLAGS::NONE ) const;
     int offset() const { return _offset; };
     FoliaElement *postappend();
     FoliaElement *get_reference() const;
+    FoliaElement *find_reference() const;
+    void check_offset( const FoliaElement *, const UnicodeString& ) const;
     std::string ref() const { return _ref; };
   private:
     void init();
     FoliaElement *find_default_reference() const;
-    void set_offset( int o ) const { _offset = o; }; // this MUST be const,
+    void set_offset( int o ) const { // this MUST be const,
+      _offset = o;
+      mark_modified();
+    };
     // only used for 'fixing up' invalid offsets. keep it private!
     // therefore _offset  has to be mutable!
     static properties PROPS;
@@ -1398,6 +1544,13 @@ namespace folia {
 				      bool = false,
 				      bool = false,
                                       bool = true) const;
+    bool private_try_text( UnicodeString&,
+			   const std::string& = "current",
+			   bool = false,
+			   bool = false,
+			   bool = false,
+			   bool = true ) const;
+    void throw_no_text( const std::string&, bool, bool, bool ) const;
     static properties PROPS;
 
   };
@@ -1494,6 +1647,7 @@ namespace folia {
 
     FoliaElement* parseXml( const xmlNode * );
     xmlNode *xml( bool, bool = false ) const;
+    void write_xml( XmlWriter&, bool = false ) const;
     const std::string content() const { return value; };
     void setAttributes( KWargs& );
   private:
@@ -1546,6 +1700,15 @@ namespace folia {
                                         bool = true) const {
 	return "\n";
       }
+      bool private_try_text( UnicodeString& result,
+			   const std::string& = "current",
+			   bool = false,
+			   bool = false,
+			   bool = false,
+			   bool = true ) const {
+        result = "\n";
+        return true;
+      }
       static properties PROPS;
       std::string _pagenr;
       std::string _linenr;
@@ -1569,6 +1732,15 @@ namespace folia {
                                       bool = true) const {
       return "\n\n";
     }
+    bool private_try_text( UnicodeString& result,
+			   const std::string& = "current",
+			   bool = false,
+			   bool = false,
+			   bool = false,
+			   bool = true ) const {
+      result = "\n\n";
+      return true;
+    }
     static properties PROPS;
   };
 
@@ -2559,6 +2731,7 @@ namespace folia {
     void setAttributes( KWargs& );
     FoliaElement* parseXml( const xmlNode * );
     xmlNode *xml( bool, bool=false ) const;
+    void write_xml( XmlWriter&, bool=false ) const;
 
   private:
     static properties PROPS;
@@ -2577,6 +2750,7 @@ namespace folia {
     void setAttributes( KWargs& );
     FoliaElement* parseXml( const xmlNode * );
     xmlNode *xml( bool, bool=false ) const;
+    void write_xml( XmlWriter&, bool=false ) const;
 
   private:
     static properties PROPS;
@@ -2593,6 +2767,7 @@ namespace folia {
 
     FoliaElement* parseXml( const xmlNode * );
     xmlNode *xml( bool, bool=false ) const;
+    void write_xml( XmlWriter&, bool=false ) const;
 
   private:
     const UnicodeString private_text( const std::string& = "current",
@@ -2600,6 +2775,15 @@ namespace folia {
 				      bool = false,
 				      bool = false,
                                       bool = true) const { return ""; };
+    bool private_try_text( UnicodeString& result,
+			   const std::string& = "current",
+			   bool = false,
+			   bool = false,
+			   bool = false,
+			   bool = true ) const {
+      result = "";
+      return true;
+    }
     static properties PROPS;
     std::string _value;
   };
@@ -2614,7 +2798,9 @@ namespace folia {
 
     FoliaElement* parseXml( const xmlNode * );
     xmlNode *xml( bool, bool=false ) const;
+    void write_xml( XmlWriter&, bool=false ) const;
     bool setvalue( const std::string& );
+    const std::string& value() const { return _value; };
     const std::string& get_delimiter( bool ) const { return EMPTY_STRING; };
   private:
     const UnicodeString private_text( const std::string& = "current",
@@ -2622,6 +2808,12 @@ namespace folia {
 				      bool = false,
 				      bool = false,
                                       bool = true) const;
+    bool private_try_text( UnicodeString&,
+			   const std::string& = "current",
+			   bool = false,
+			   bool = false,
+			   bool = false,
+			   bool = true ) const;
     static properties PROPS;
     std::string _value; //UTF8 value
   };
@@ -2747,8 +2939,12 @@ namespace folia {
     Suggestion *suggestions( size_t ) const;
     const TextContent *text_content( const std::string& = "current",
 				    bool = false ) const;
+    const TextContent *find_text_content( const std::string& = "current",
+					  bool = false ) const;
     const PhonContent *phon_content( const std::string& = "current",
 				    bool = false ) const;
+    const PhonContent *find_phon_content( const std::string& = "current",
+					  bool = false ) const;
     const std::string& get_delimiter( bool=false) const;
     Correction *correct( const std::vector<FoliaElement*>&,
 			 const std::vector<FoliaElement*>&,
@@ -2762,6 +2958,23 @@ namespace folia {
 				      bool = false,
 				      bool = false,
                                       bool = true) const;
+    bool private_try_text( UnicodeString&,
+			   const std::string& = "current",
+			   bool = false,
+			   bool = false,
+			   bool = false,
+			   bool = true ) const;
+    void throw_no_text( const std::string&, bool, bool, bool ) const;
+    void init();
+    void resolve_children() const;
+    mutable New *_new_child; ///< the New child, resolved by resolve_children()
+    mutable Original *_original_child; ///< the Original child
+    mutable Current *_current_child; ///< the Current child
+    mutable std::vector<Suggestion*> _suggestion_children; ///< the
+    ///< Suggestion children
+    mutable unsigned int _resolved_generation; ///< the text_generation()
+    ///< the children were resolved in
+    mutable bool _resolved;
     static properties PROPS;
   };
 
@@ -0,0 +1,102 @@
+/*
+  Copyright (c) 2006 - 2021
+  CLST  - Radboud University
+  ILK   - Tilburg University
+
+  This file is part of libfolia
+
+  libfolia is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  libfolia is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, see <http://www.gnu.org/licenses/>.
+
+  For questions and suggestions, see:
+      https://github.com/LanguageMachines/ticcutils/issues
+  or send mail to:
+      lamasoftware (at ) science.ru.nl
+
+*/
+
+
+#ifndef FOLIA_INDEX_H
+#define FOLIA_INDEX_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include "libfolia/folia.h"
+
+namespace folia {
+
+  class posting {
+    /// a single entry in an Index: the location of one Word in a corpus
+  public:
+  posting( size_t f, const std::string& id, size_t o ):
+    file(f), word_id(id), ordinal(o){};
+    size_t file;          //!< the index of the file in the Index
+    std::string word_id;  //!< the xml:id of the Word. May be empty
+    size_t ordinal;       //!< the position of the Word in Document::words()
+  };
+
+  class Index {
+    /// a persistent inverted index over the Words of a set of FoLiA files
+    /*!
+      For every indexed field (the text of a Word or the class of one of its
+      annotations) the Index maps each value to a list of postings.
+
+      An Index is built in memory using add_file() or add_document() and
+      then written to disk using save(). When reading an Index back with
+      load(), only the term dictionary is read. The postings of a term are
+      read from disk on demand, and Documents are only parsed when a
+      posting is resolved to a Word.
+    */
+  public:
+    Index();
+    ~Index();
+    void add_field( ElementType, const std::string& = "" );
+    /// remove all fields. Use add_field() to set up new ones
+    void clear_fields() { _fields.clear(); };
+    size_t add_file( const std::string& );
+    size_t add_document( const Document&, const std::string& );
+    void save( const std::string& ) const;
+    void load( const std::string& );
+    std::vector<posting> lookup( const std::string&,
+				 const std::string& ) const;
+    std::vector<posting> lookup( const std::string& ) const;
+    Word *resolve( const posting& );
+    std::vector<Word*> resolve( const std::vector<posting>& );
+    void clear_cache();
+    /// return the names of all indexed files
+    const std::vector<std::string>& files() const { return _files; };
+    std::vector<std::string> fields() const;
+    size_t term_count() const;
+    static std::string field_name( ElementType, const std::string& = "" );
+  private:
+    /// the location of the postings of one term on disk
+    struct term_entry {
+      std::streamoff offset; //!< the start of the postings in the file
+      size_t count;          //!< the number of postings
+    };
+    typedef std::map<std::string,std::vector<posting>> posting_map;
+    typedef std::map<std::string,term_entry> term_map;
+    std::vector<std::pair<ElementType,std::string>> _fields; //!< what to index
+    std::vector<std::string> _files;   //!< the indexed files
+    std::map<std::string,posting_map> _postings; //!< in memory postings
+    std::map<std::string,term_map> _terms; //!< the on-disk dictionary
+    mutable std::ifstream _is;  //!< the opened Index file, after load()
+    std::map<size_t,Document*> _docs; //!< the Documents resolved so far
+    Index( const Index& ); // no copies
+    Index& operator=( const Index& ); // no copies
+  };
+
+}
+#endif // FOLIA_INDEX_H
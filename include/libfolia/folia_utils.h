@@ -30,6 +30,9 @@
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
 #include <iostream>
 #include <exception>
 #include <ctime>
@@ -45,6 +48,7 @@ namespace folia {
   enum AnnotationType : int;
   enum AnnotatorType : int;
   enum ElementType : unsigned int;
+  class FoliaElement;
 
   class ArgsError: public std::runtime_error {
   public:
@@ -143,6 +147,49 @@ namespace folia {
   KWargs getArgs( const std::string& );
   std::string toString( const KWargs& );
 
+  void parallel_for( size_t,
+		     const std::function<void(size_t)>&,
+		     unsigned int = 0 );
+
+  /// class used to find FoliaElements by their xml:id
+  ///
+  /// id_index is an open addressing hash table with linear probing.
+  /// Lookups can be done with a std::string, but also with a (pointer,length)
+  /// pair, so ids in a parser buffer need no conversion to std::string.
+  ///
+  class id_index {
+  public:
+    id_index();
+    bool insert( const std::string&, FoliaElement * );
+    bool erase( const std::string& );
+    FoliaElement *find( const char *, size_t ) const;
+    FoliaElement *find( const std::string& id ) const {
+      /// return the FoliaElement for id, or 0 when not present
+      return find( id.data(), id.size() );
+    };
+    std::vector<FoliaElement*> find_prefix( const std::string& ) const;
+    void reserve( size_t );
+    void clear();
+    /// return true when the index is empty
+    bool empty() const { return _size == 0; };
+    /// return the number of ids in the index
+    size_t size() const { return _size; };
+  private:
+    struct slot {
+      slot(): hash(0), value(0), state(EMPTY) {};
+      uint64_t hash;
+      std::string key;
+      FoliaElement *value;
+      enum { EMPTY, FULL, DELETED } state;
+    };
+    static uint64_t hash( const char *, size_t );
+    size_t probe( const char *, size_t, uint64_t ) const;
+    void rehash( size_t );
+    std::vector<slot> _slots; ///< the table. Its size is a power of 2
+    size_t _size;             ///< the number of FULL slots
+    size_t _used;             ///< the number of FULL and DELETED slots
+  };
+
   void addAttributes( xmlNode *, const KWargs& );
   KWargs getAttributes( const xmlNode * );
 
@@ -0,0 +1,123 @@
+/*
+  Copyright (c) 2006 - 2021
+  CLST  - Radboud University
+  ILK   - Tilburg University
+
+  This file is part of libfolia
+
+  libfolia is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  libfolia is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, see <http://www.gnu.org/licenses/>.
+
+  For questions and suggestions, see:
+      https://github.com/LanguageMachines/ticcutils/issues
+  or send mail to:
+      lamasoftware (at ) science.ru.nl
+
+*/
+
+#ifndef FOLIA_XMLWRITER_H
+#define FOLIA_XMLWRITER_H
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include "libxml/tree.h"
+#include "libfolia/folia_utils.h"
+
+namespace folia {
+
+  /// class used to serialize FoLiA as XML text, without an xmlDoc
+  ///
+  /// The XmlWriter produces exactly the same bytes as libxml2 does when
+  /// dumping an equivalent xmlDoc, formatted or not. The output goes
+  /// directly into a string, or into a buffer that is flushed to an
+  /// ostream once in a while.
+  class XmlWriter {
+  public:
+    /// the kind of content of an element, as far as formatting is concerned
+    enum content_kind {
+      EMPTY,    //!< no content at all: output as \<tag/>
+      ELEMENTS, //!< only elements and comments: formatted
+      MIXED     //!< also text or CDATA: the content is output unformatted
+    };
+    explicit XmlWriter( std::ostream&, bool = true );
+    explicit XmlWriter( std::string&, bool = true );
+    XmlWriter( std::string&, const XmlWriter& );
+    ~XmlWriter();
+    void set_prefix( const std::string& p ) {
+      /// set the namespace prefix for all following FoLiA elements
+      _prefix = p;
+    };
+    void set_threads( unsigned int t ) {
+      /// set the number of threads to use for rendering sibling elements.
+      /// 1 (the default) means sequential, 0 means one per core
+      _threads = t;
+    };
+    unsigned int threads() const { return _threads; };
+    void set_flush_size( size_t s ) {
+      /// write the buffer to the stream as soon as it holds more than s
+      /// bytes. 0 means: only on an explicit flush()
+      _flush_size = s;
+    };
+    /// return the number of bytes not yet written to the stream
+    size_t buffered() const { return _os ? _out->size() : 0; };
+    void set_source( const std::string *s ) {
+      /// set the source to use for splice()
+      _source = s;
+    };
+    /// return the source set with set_source(), if any
+    const std::string *source() const { return _source; };
+    /// is the output formatted?
+    bool formatting() const { return _format; };
+    void declaration( const std::string& );
+    void processing_instruction( const std::string&, const std::string& );
+    void start_element( const std::string&,
+			const KWargs&,
+			content_kind );
+    void start_node( const xmlNode *, content_kind );
+    void end_element();
+    void text( const std::string& );
+    void cdata( const std::string& );
+    void comment( const std::string& );
+    void node( xmlNode * );
+    size_t node_level() const;
+    void verbatim( const std::string& );
+    void append( const std::string& );
+    void splice( size_t, size_t );
+    void flush();
+  private:
+    XmlWriter( const XmlWriter& ); // inhibit copies
+    XmlWriter& operator=( const XmlWriter& ); // inhibit copies
+    void indent();
+    void after_node();
+    void open_tag( const std::string&, const std::string& );
+    void close_start( content_kind );
+    void attribute( const std::string&, const std::string& );
+    void escape_text( const char *, size_t );
+    void escape_attribute( const char *, size_t );
+    std::ostream *_os;
+    std::string _own_buffer;
+    std::string *_out;
+    bool _format;
+    std::string _prefix;
+    /// the open elements: their (prefixed) tag and formatting state
+    std::vector<std::pair<std::string,bool>> _open;
+    xmlDoc *_encoding_doc;
+    unsigned int _threads;
+    const std::string *_source;
+    size_t _flush_size;
+  };
+
+} // namespace folia
+
+#endif // FOLIA_XMLWRITER_H
@@ -0,0 +1,541 @@
+/*
+  Copyright (c) 2006 - 2021
+  CLST  - Radboud University
+  ILK   - Tilburg University
+
+  This file is part of libfolia
+
+  libfolia is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  libfolia is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, see <http://www.gnu.org/licenses/>.
+
+  For questions and suggestions, see:
+      https://github.com/LanguageMachines/ticcutils/issues
+  or send mail to:
+      lamasoftware (at ) science.ru.nl
+*/
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <iostream>
+#include <fstream>
+#include <stdexcept>
+#include "ticcutils/XMLtools.h"
+#include "libfolia/folia.h"
+#include "libfolia/folia_properties.h"
+
+using namespace std;
+
+namespace folia {
+
+  /// the first bytes of a binary FoLiA file
+  const string BINARY_MAGIC = "FoLiABIN";
+  /// the version of the binary format
+  const uint64_t BINARY_VERSION = 1;
+
+  /// the kinds of records in the node stream of a binary FoLiA file
+  enum binary_record : unsigned char {
+    BIN_ELEMENT = 0,  //!< an element: type, attributes and children
+    BIN_TEXT = 1,     //!< an XmlText value
+    BIN_WREF = 2,     //!< a reference to an earlier element (a wref)
+    BIN_FRAGMENT = 3  //!< an element stored as an XML fragment
+  };
+
+  /*
+    A binary FoLiA file looks like this:
+
+    magic "FoLiABIN", format version
+    header:  the XML of the document without a body. This holds the
+             processing instructions, declarations, provenance and metadata
+    strings: the string table, every string stored once
+    types:   the element types used, as string ids of their tags
+    counts:  the number of elements and xml:id's (size hints)
+    body:    the number of top level elements, followed by all nodes
+             in preorder
+
+    All numbers are stored as variable length unsigned integers (LEB128).
+    An element record holds its type, its attributes as pairs of string
+    ids, and its number of children. A wref holds the preorder number of
+    the element it refers to. The few elements with special content
+    (ForeignData, Content, Description etc.) are stored as XML fragments.
+  */
+
+  bool is_binary_folia( istream& is ){
+    /// check if a stream contains a FoLiA document in the binary format
+    /*!
+      \param is the stream to check. It is rewound to the start afterwards.
+      \return true when the stream starts with the binary FoLiA magic
+    */
+    string magic( BINARY_MAGIC.size(), '\0' );
+    is.read( &magic[0], magic.size() );
+    bool result = is && magic == BINARY_MAGIC;
+    is.clear();
+    is.seekg( 0 );
+    return result;
+  }
+
+  static void error_sink( void *mydata, xmlError * ){
+    /// count the libxml2 errors
+    int *cnt = (int*)mydata;
+    (*cnt)++;
+  }
+
+  static void put_number( string& out, uint64_t val ){
+    /// append an unsigned number in LEB128 encoding
+    while ( val >= 0x80 ){
+      out += (char)( ( val & 0x7F ) | 0x80 );
+      val >>= 7;
+    }
+    out += (char)val;
+  }
+
+  static void put_string( string& out, const string& s ){
+    /// append a length prefixed string
+    put_number( out, s.size() );
+    out += s;
+  }
+
+  static bool is_fragment_type( ElementType et ){
+    /// elements that are (de)serialized using their own XML code
+    switch ( et ){
+    case ForeignData_t:
+    case Description_t:
+    case Comment_t:
+    case Content_t:
+    case External_t:
+    case XmlComment_t:
+    case LinkReference_t:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  class binary_encoder {
+    /// the state needed to encode the body of a Document
+  public:
+    binary_encoder(): element_count(0), id_count(0) {};
+    void encode( const FoliaElement * );
+    string_table strings;
+    vector<ElementType> types;
+    string nodes;
+    size_t element_count;
+    size_t id_count;
+  private:
+    size_t type_index( ElementType );
+    unordered_map<const FoliaElement*,size_t> positions;
+    vector<int> type_indices;
+  };
+
+  size_t binary_encoder::type_index( ElementType et ){
+    /// return the index of et in the types table, adding it when new
+    if ( size_t(et) >= type_indices.size() ){
+      type_indices.resize( et+1, -1 );
+    }
+    if ( type_indices[et] < 0 ){
+      type_indices[et] = types.size();
+      types.push_back( et );
+    }
+    return type_indices[et];
+  }
+
+  void binary_encoder::encode( const FoliaElement *el ){
+    /// encode an element and all its children as node records
+    ElementType et = el->element_id();
+    if ( et == XmlText_t ){
+      nodes += (char)BIN_TEXT;
+      put_number( nodes, strings.intern( dynamic_cast<const XmlText*>(el)->value() ) );
+      return;
+    }
+    if ( is_fragment_type( et ) ){
+      string fragment;
+      {
+	XmlWriter w( fragment, false );
+	el->write_xml( w, false );
+      }
+      nodes += (char)BIN_FRAGMENT;
+      put_number( nodes, strings.intern( fragment ) );
+      return;
+    }
+    nodes += (char)BIN_ELEMENT;
+    put_number( nodes, type_index( et ) );
+    if ( el->refcount() > 0 ){
+      positions[el] = element_count;
+    }
+    ++element_count;
+    KWargs atts = el->collectAttributes();
+    put_number( nodes, atts.size() );
+    for ( const auto& att : atts ){
+      if ( att.first == "xml:id" ){
+	++id_count;
+      }
+      put_number( nodes, strings.intern( att.first ) );
+      put_number( nodes, strings.intern( att.second ) );
+    }
+    bool is_span = el->isSubClass( AbstractSpanAnnotation_t );
+    put_number( nodes, el->size() );
+    for ( const auto& child : el->data() ){
+      if ( is_span && child->refcount() > 0 ){
+	// a wref
+	auto it = positions.find( child );
+	if ( it == positions.end() ){
+	  throw runtime_error( "binary save: " + el->xmltag() + "("
+			       + el->id() + ") refers to element "
+			       + child->id() + " which comes later" );
+	}
+	nodes += (char)BIN_WREF;
+	put_number( nodes, it->second );
+      }
+      else {
+	encode( child );
+      }
+    }
+  }
+
+  void Document::save_binary( ostream& os ) const {
+    /// save the Document in the compact binary format
+    /*!
+      \param os the output stream. Should be opened in binary mode.
+
+      The binary format is meant as a fast way to hand over a Document
+      between programs or stages of a pipeline. read_from_binary() restores
+      exactly the same Document, so saving it as XML gives the same result
+      as saving the original.
+    */
+    if ( !foliadoc ){
+      throw runtime_error( "can't save, no doc" );
+    }
+    string header;
+    xmlDoc *skeleton = xml_skeleton( "" );
+    _foliaNsOut = 0;
+    xmlChar *buf = 0;
+    int size = 0;
+    xmlDocDumpFormatMemoryEnc( skeleton, &buf, &size, "UTF-8", 0 );
+    xmlFreeDoc( skeleton );
+    header.assign( (const char*)buf, size );
+    xmlFree( buf );
+
+    binary_encoder enc;
+    for ( const auto& el : foliadoc->data() ){
+      enc.encode( el );
+    }
+    string out = BINARY_MAGIC;
+    put_number( out, BINARY_VERSION );
+    put_string( out, header );
+    put_number( out, enc.strings.size() );
+    for ( const auto& s : enc.strings.strings() ){
+      put_string( out, s );
+    }
+    put_number( out, enc.types.size() );
+    for ( const auto& et : enc.types ){
+      put_string( out, toString( et ) );
+    }
+    put_number( out, enc.element_count );
+    put_number( out, enc.id_count );
+    put_number( out, foliadoc->size() );
+    os.write( out.data(), out.size() );
+    os.write( enc.nodes.data(), enc.nodes.size() );
+  }
+
+  bool Document::save_binary( const string& file_name ) const {
+    /// save the Document in the compact binary format to a file
+    /*!
+      \param file_name the name of the file to create
+      \return true on success, false when the file can't be created.
+      Throws on other errors, and then removes the file.
+    */
+    ofstream os( file_name, ios::binary );
+    if ( !os ){
+      return false;
+    }
+    try {
+      save_binary( os );
+    }
+    catch ( ... ){
+      os.close();
+      remove( file_name.c_str() );
+      throw;
+    }
+    os.close();
+    return os.good();
+  }
+
+  class binary_decoder {
+    /// the state needed to decode the body of a binary Document
+  public:
+    binary_decoder( const string& buffer, size_t pos ):
+      _pos( buffer.data() + pos ),
+      _end( buffer.data() + buffer.size() ),
+      _doc( 0 )
+    {};
+    uint64_t number();
+    uint64_t count();
+    string str();
+    void read_tables( Document * );
+    FoliaElement *decode( const FoliaElement * );
+    size_t id_count;
+    size_t top_count;
+  private:
+    void fail( const string& ) const;
+    const string& string_at( uint64_t ) const;
+    FoliaElement *decode_fragment( const string& );
+    const char *_pos;
+    const char *_end;
+    Document *_doc;
+    vector<string> _strings;
+    vector<ElementType> _types;
+    vector<FoliaElement*> _elements;
+    vector<bool> _completed;
+  };
+
+  void binary_decoder::fail( const string& what ) const {
+    /// throw on corrupt input
+    throw XmlError( "invalid binary FoLiA: " + what );
+  }
+
+  uint64_t binary_decoder::number(){
+    /// read an LEB128 encoded number
+    uint64_t result = 0;
+    for ( int shift = 0; shift < 64; shift += 7 ){
+      if ( _pos == _end ){
+	fail( "unexpected end of data" );
+      }
+      unsigned char c = *_pos++;
+      result |= uint64_t( c & 0x7F ) << shift;
+      if ( !( c & 0x80 ) ){
+	return result;
+      }
+    }
+    fail( "number too large" );
+    return 0;
+  }
+
+  uint64_t binary_decoder::count(){
+    /// read the number of records that follow
+    /*!
+     * every record takes at least one byte, so a count larger than the
+     * remaining data is corrupt, and is rejected before anything is
+     * allocated for it
+     */
+    uint64_t result = number();
+    if ( result > uint64_t( _end - _pos ) ){
+      fail( "count exceeds the remaining data" );
+    }
+    return result;
+  }
+
+  string binary_decoder::str(){
+    /// read a length prefixed string
+    uint64_t len = number();
+    if ( len > size_t( _end - _pos ) ){
+      fail( "unexpected end of data" );
+    }
+    string result( _pos, len );
+    _pos += len;
+    return result;
+  }
+
+  const string& binary_decoder::string_at( uint64_t i ) const {
+    /// return string i from the string table
+    if ( i >= _strings.size() ){
+      fail( "string index out of range" );
+    }
+    return _strings[i];
+  }
+
+  void binary_decoder::read_tables( Document *doc ){
+    /// read the string and type tables and the counts
+    _doc = doc;
+    uint64_t num = count();
+    _strings.reserve( num );
+    for ( uint64_t i=0; i < num; ++i ){
+      _strings.push_back( str() );
+    }
+    num = count();
+    for ( uint64_t i=0; i < num; ++i ){
+      _types.push_back( stringToElementType( str() ) );
+    }
+    uint64_t num_elements = count();
+    _elements.reserve( num_elements );
+    _completed.reserve( num_elements );
+    id_count = count();
+    top_count = count();
+  }
+
+  FoliaElement *binary_decoder::decode_fragment( const string& fragment ){
+    /// create an element from an XML fragment, using its parseXml()
+    string wrapped = "<FoLiA xmlns=\"" + NSFOLIA
+      + "\" xmlns:xlink=\"http://www.w3.org/1999/xlink\">"
+      + fragment + "</FoLiA>";
+    xmlDoc *xdoc = xmlReadMemory( wrapped.c_str(), wrapped.length(), 0, 0,
+				  XML_PARSER_OPTIONS );
+    if ( !xdoc ){
+      fail( "unparsable fragment" );
+    }
+    FoliaElement *result = 0;
+    try {
+      const xmlNode *node = xmlDocGetRootElement( xdoc )->children;
+      if ( !node ){
+	fail( "empty fragment" );
+      }
+      string tag;
+      if ( node->type == XML_COMMENT_NODE ){
+	tag = "_XmlComment";
+      }
+      else {
+	tag = TiCC::Name( node );
+      }
+      result = FoliaElement::createElement( tag, _doc );
+      result = result->parseXml( node );
+    }
+    catch ( ... ){
+      xmlFreeDoc( xdoc );
+      throw;
+    }
+    xmlFreeDoc( xdoc );
+    return result;
+  }
+
+  FoliaElement *binary_decoder::decode( const FoliaElement *parent ){
+    /// decode one node record, and all its children
+    /*!
+      \param parent the element the record will be appended to. 0 for the
+      top level records
+      \return the new element. For a wref, the refered element
+
+      The work done is the same as AbstractElement::parseXml() does, except
+      for the checking of the text consistency.
+    */
+    if ( _pos == _end ){
+      fail( "unexpected end of data" );
+    }
+    unsigned char kind = *_pos++;
+    switch ( kind ){
+    case BIN_TEXT: {
+      XmlText *t = new XmlText();
+      t->setvalue( string_at( number() ) );
+      return t;
+    }
+    case BIN_FRAGMENT:
+      return decode_fragment( string_at( number() ) );
+    case BIN_WREF: {
+      uint64_t pos = number();
+      if ( pos >= _elements.size() ){
+	fail( "wref to an unknown element" );
+      }
+      if ( !parent
+	   || !parent->isSubClass( AbstractSpanAnnotation_t ) ){
+	fail( "wref outside a span annotation" );
+      }
+      FoliaElement *ref = _elements[pos];
+      if ( !_completed[pos] ){
+	// an ancestor which is still being decoded
+	fail( "wref to an enclosing element" );
+      }
+      if ( !ref->referable() ){
+	fail( "wref to a non-referable element" );
+      }
+      ref->increfcount();
+      return ref;
+    }
+    case BIN_ELEMENT:
+      break;
+    default:
+      fail( "unknown record" );
+    }
+    uint64_t type = number();
+    if ( type >= _types.size() ){
+      fail( "type index out of range" );
+    }
+    FoliaElement *result = FoliaElement::createElement( _types[type], _doc );
+    size_t index = _elements.size();
+    _elements.push_back( result );
+    _completed.push_back( false );
+    try {
+      KWargs atts;
+      uint64_t num = count();
+      for ( uint64_t i=0; i < num; ++i ){
+	const string& key = string_at( number() );
+	atts[key] = string_at( number() );
+      }
+      result->setAttributes( atts );
+      num = count();
+      for ( uint64_t i=0; i < num; ++i ){
+	result->append( decode( result ) );
+      }
+    }
+    catch ( ... ){
+      _elements.resize( index );
+      _completed.resize( index );
+      delete result;
+      throw;
+    }
+    _completed[index] = true;
+    return result;
+  }
+
+  bool Document::read_from_binary( const string& buffer ){
+    /// read a FoLiA Document from a buffer in the binary format
+    /*!
+      \param buffer the complete contents of a file created by save_binary()
+      \return true on succes. Will throw otherwise.
+
+      The text of the Document is NOT checked again. It is assumed that
+      this was done when the Document was created.
+    */
+    if ( foliadoc ){
+      throw logic_error( "Document is already initialized" );
+    }
+    if ( buffer.compare( 0, BINARY_MAGIC.size(), BINARY_MAGIC ) != 0 ){
+      throw XmlError( "not a binary FoLiA document" );
+    }
+    binary_decoder dec( buffer, BINARY_MAGIC.size() );
+    uint64_t version = dec.number();
+    if ( version != BINARY_VERSION ){
+      throw XmlError( "unsupported binary FoLiA version: "
+		      + TiCC::toString( version ) );
+    }
+    string header = dec.str();
+    int cnt = 0;
+    xmlSetStructuredErrorFunc( &cnt, (xmlStructuredErrorFunc)error_sink );
+    _xmldoc = xmlReadMemory( header.c_str(), header.length(), 0, 0,
+			     XML_PARSER_OPTIONS );
+    if ( !_xmldoc || cnt > 0 ){
+      throw XmlError( "invalid binary FoLiA: bad header" );
+    }
+    try {
+      foliadoc = parseXml();
+      dec.read_tables( this );
+      sindex.reserve( dec.id_count );
+      for ( size_t i=0; i < dec.top_count; ++i ){
+	foliadoc->append( dec.decode( 0 ) );
+      }
+    }
+    catch ( ... ){
+      xmlFreeDoc( _xmldoc );
+      _xmldoc = 0;
+      throw;
+    }
+    xmlFreeDoc( _xmldoc );
+    _xmldoc = 0;
+    // no offset validation needed
+    t_offset_validation_buffer.clear();
+    p_offset_validation_buffer.clear();
+    if ( debug ){
+      cout << "successful read a binary doc" << endl;
+    }
+    return foliadoc != 0;
+  }
+
+} // namespace folia
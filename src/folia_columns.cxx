@@ -0,0 +1,278 @@
+/*
+  Copyright (c) 2006 - 2021
+  CLST  - Radboud University
+  ILK   - Tilburg University
+
+  This file is part of libfolia
+
+  libfolia is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  libfolia is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, see <http://www.gnu.org/licenses/>.
+
+  For questions and suggestions, see:
+      https://github.com/LanguageMachines/ticcutils/issues
+  or send mail to:
+      lamasoftware (at ) science.ru.nl
+*/
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <stdexcept>
+#include "ticcutils/Unicode.h"
+#include "libfolia/folia.h"
+
+using namespace std;
+
+namespace folia {
+
+  int32_t string_table::lookup( const string& s ) const {
+    /// return the id of a string
+    /*!
+      \param s the string to look for
+      \return the id of s, or -1 when it is not in the table
+    */
+    const auto& it = _ids.find( s );
+    if ( it == _ids.end() ){
+      return -1;
+    }
+    return it->second;
+  }
+
+  int32_t string_table::intern( const string& s ){
+    /// return the id of a string, adding it to the table when new
+    const auto& it = _ids.find( s );
+    if ( it != _ids.end() ){
+      return it->second;
+    }
+    int32_t id = _strings.size();
+    _strings.push_back( s );
+    _ids[s] = id;
+    return id;
+  }
+
+  void string_table::clear(){
+    /// remove all strings
+    _strings.clear();
+    _ids.clear();
+  }
+
+  /// the positions of the fixed columns
+  enum fixed_column { TEXT_COL=0, SENTENCE_COL, OFFSET_COL, LENGTH_COL,
+		      FIRST_ANNO_COL };
+
+  word_columns::word_columns(): _rows(0){
+    /// create a column table with text, sentence, offset, length, pos and
+    /// lemma columns
+    _columns.push_back( column( "text", column::STRINGS ) );
+    _columns.push_back( column( "sentence", column::STRINGS ) );
+    _columns.push_back( column( "offset", column::NUMBERS ) );
+    _columns.push_back( column( "length", column::NUMBERS ) );
+    add_column( PosAnnotation_t );
+    add_column( LemmaAnnotation_t );
+  }
+
+  void word_columns::add_column( ElementType et,
+				 const string& st,
+				 const string& name ){
+    /// add a column holding the class of an annotation
+    /*!
+      \param et the annotation type, like PosAnnotation_t
+      \param st the set. When empty, the first annotation of type et of
+      any set is used
+      \param name the name of the column. Defaults to the tag of et,
+      followed by '@set' when a set is given
+    */
+    if ( _rows > 0 ){
+      throw logic_error( "word_columns::add_column(): impossible after extract()" );
+    }
+    string col_name = name;
+    if ( col_name.empty() ){
+      col_name = toString( et );
+      if ( !st.empty() ){
+	col_name += "@" + st;
+      }
+    }
+    for ( const auto& col : _columns ){
+      if ( col.name == col_name ){
+	throw logic_error( "word_columns::add_column(): duplicate column name: "
+			   + col_name );
+      }
+    }
+    _columns.push_back( column( col_name, column::STRINGS, et, st ) );
+  }
+
+  void word_columns::clear_annotation_columns(){
+    /// remove all annotation columns, only keep the fixed ones
+    _columns.erase( _columns.begin() + FIRST_ANNO_COL, _columns.end() );
+    clear();
+  }
+
+  void word_columns::clear(){
+    /// remove all rows, keep the columns
+    for ( auto& col : _columns ){
+      col.values.clear();
+      col.table.clear();
+    }
+    _rows = 0;
+  }
+
+  const column& word_columns::operator[]( const string& name ) const {
+    /// return the column with the given name. Throws when not found
+    for ( const auto& col : _columns ){
+      if ( col.name == name ){
+	return col;
+      }
+    }
+    throw range_error( "word_columns: no column named: " + name );
+  }
+
+  size_t word_columns::extract( const Document& doc,
+				const string& textclass ){
+    /// append a row for every Word of a Document
+    /*!
+      \param doc the Document
+      \param textclass the textclass to use for the text and offset columns
+      \return the number of rows added
+
+      All Words are visited once, and for every Word its children are
+      visited once to fill all annotation columns. Only for a Word with a
+      Correction, the annotations are searched like annotation<>() does, so
+      the annotations inside the Correction are found too.
+    */
+    vector<Word*> wv = doc.words();
+    for ( auto& col : _columns ){
+      col.values.reserve( _rows + wv.size() );
+    }
+    const FoliaElement *last_parent = 0;
+    int32_t sentence_id = -1;
+    for ( const auto& w : wv ){
+      int32_t offset = -1;
+      int32_t length = -1;
+      int32_t text_id = -1;
+      try {
+	UnicodeString txt = w->text( textclass );
+	text_id = _columns[TEXT_COL].table.intern( TiCC::UnicodeToUTF8( txt ) );
+	length = txt.countChar32();
+	offset = w->text_content( textclass )->offset();
+      }
+      catch ( const NoSuchText& ){
+      }
+      if ( w->parent() != last_parent ){
+	last_parent = w->parent();
+	sentence_id = -1;
+	Sentence *s = w->sentence();
+	if ( s ){
+	  sentence_id = _columns[SENTENCE_COL].table.intern( s->id() );
+	}
+      }
+      _columns[TEXT_COL].values.push_back( text_id );
+      _columns[SENTENCE_COL].values.push_back( sentence_id );
+      _columns[OFFSET_COL].values.push_back( offset );
+      _columns[LENGTH_COL].values.push_back( length );
+      for ( size_t c=FIRST_ANNO_COL; c < _columns.size(); ++c ){
+	_columns[c].values.push_back( -1 );
+      }
+      bool corrected = false;
+      for ( const auto& child : w->data() ){
+	ElementType et = child->element_id();
+	if ( et == Correction_t ){
+	  corrected = true;
+	  break;
+	}
+	for ( size_t c=FIRST_ANNO_COL; c < _columns.size(); ++c ){
+	  column& col = _columns[c];
+	  if ( col.element == et
+	       && col.values.back() < 0
+	       && ( col.set.empty() || col.set == child->sett() ) ){
+	    col.values.back() = col.table.intern( child->cls() );
+	  }
+	}
+      }
+      if ( corrected ){
+	for ( size_t c=FIRST_ANNO_COL; c < _columns.size(); ++c ){
+	  column& col = _columns[c];
+	  vector<FoliaElement*> v = w->select( col.element, col.set,
+					       default_ignore_annotations );
+	  col.values.back() = v.empty() ? -1 : col.table.intern( v[0]->cls() );
+	}
+      }
+    }
+    _rows += wv.size();
+    return wv.size();
+  }
+
+  static void write_u32( ostream& os, uint32_t v ){
+    /// write v as 4 bytes, little endian
+    for ( int i=0; i < 4; ++i ){
+      os.put( static_cast<char>( (v >> (8*i)) & 0xff ) );
+    }
+  }
+
+  static void write_u64( ostream& os, uint64_t v ){
+    /// write v as 8 bytes, little endian
+    for ( int i=0; i < 8; ++i ){
+      os.put( static_cast<char>( (v >> (8*i)) & 0xff ) );
+    }
+  }
+
+  static void write_string( ostream& os, const string& s ){
+    /// write s as a 4 byte length followed by the (UTF-8) bytes
+    write_u32( os, s.size() );
+    os.write( s.data(), s.size() );
+  }
+
+  void word_columns::write( ostream& os ) const {
+    /// write the table in a simple binary columnar format
+    /*!
+      \param os the stream to write to. Should be opened in binary mode
+
+      All integers are little endian. The layout is:
+      - the 8 bytes "FOLIACOL", a u32 version (1), a u64 row count and a
+      u32 column count
+      - per column: the name (u32 length + bytes), a u32 kind (0 for
+      strings, 1 for numbers), for string columns a u32 string count
+      followed by the strings, and finally one i32 per row
+    */
+    os.write( "FOLIACOL", 8 );
+    write_u32( os, 1 );
+    write_u64( os, _rows );
+    write_u32( os, _columns.size() );
+    for ( const auto& col : _columns ){
+      write_string( os, col.name );
+      write_u32( os, col.type == column::STRINGS ? 0 : 1 );
+      if ( col.type == column::STRINGS ){
+	write_u32( os, col.table.size() );
+	for ( const auto& s : col.table.strings() ){
+	  write_string( os, s );
+	}
+      }
+      for ( const auto& v : col.values ){
+	write_u32( os, static_cast<uint32_t>( v ) );
+      }
+    }
+  }
+
+  void word_columns::write( const string& file_name ) const {
+    /// write the table to a file in a simple binary columnar format
+    ofstream os( file_name, ios::binary );
+    if ( !os ){
+      throw runtime_error( "word_columns::write(): unable to open: "
+			   + file_name );
+    }
+    write( os );
+    if ( !os ){
+      throw runtime_error( "word_columns::write(): failed writing: "
+			   + file_name );
+    }
+  }
+
+} // namespace folia
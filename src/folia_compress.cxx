@@ -0,0 +1,457 @@
+/*
+  Copyright (c) 2006 - 2021
+  CLST  - Radboud University
+  ILK   - Tilburg University
+
+  This file is part of libfolia
+
+  libfolia is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  libfolia is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, see <http://www.gnu.org/licenses/>.
+
+  For questions and suggestions, see:
+      https://github.com/LanguageMachines/ticcutils/issues
+  or send mail to:
+      lamasoftware (at ) science.ru.nl
+*/
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <stdexcept>
+#include "config.h"
+#include "zlib.h"
+#include "bzlib.h"
+#ifdef HAVE_LZMA
+#include "lzma.h"
+#endif
+#ifdef HAVE_ZSTD
+#include "zstd.h"
+#endif
+#include "ticcutils/StringOps.h"
+#include "libfolia/folia_compress.h"
+
+using namespace std;
+
+namespace folia {
+
+  /// the default size of the blocks handed to a compressor
+  const size_t DEFAULT_BLOCK_SIZE = 64*1024;
+
+  COMPRESSION compression_for( const string& file_name ){
+    /// determine the compression to use from the extension of a filename
+    /*!
+     * \param file_name the name of the file
+     * \return the COMPRESSION for .gz, .bz2, .xz or .zst files, otherwise
+     * COMPRESSION::NONE
+     */
+    if ( TiCC::match_back( file_name, ".gz" ) ){
+      return COMPRESSION::GZIP;
+    }
+    else if ( TiCC::match_back( file_name, ".bz2" ) ){
+      return COMPRESSION::BZIP2;
+    }
+    else if ( TiCC::match_back( file_name, ".xz" ) ){
+      return COMPRESSION::XZ;
+    }
+    else if ( TiCC::match_back( file_name, ".zst" ) ){
+      return COMPRESSION::ZSTD;
+    }
+    return COMPRESSION::NONE;
+  }
+
+  bool compression_available( COMPRESSION comp ){
+    /// is the compression \e comp supported by this build?
+    switch ( comp ){
+    case COMPRESSION::XZ:
+#ifdef HAVE_LZMA
+      return true;
+#else
+      return false;
+#endif
+    case COMPRESSION::ZSTD:
+#ifdef HAVE_ZSTD
+      return true;
+#else
+      return false;
+#endif
+    default:
+      return true;
+    }
+  }
+
+  /// the interface to a compression library
+  class compressor {
+  public:
+    explicit compressor( size_t size ): _out( size ) {};
+    virtual ~compressor(){};
+    /// compress a block of data and write the result to dest
+    /*!
+     * \param data the data
+     * \param len the size of the data
+     * \param finish when true, this is the last block, and the compressed
+     * stream is completed
+     * \param dest the streambuf to write the compressed data to
+     * \return false on errors
+     */
+    virtual bool compress( const char *data,
+			   size_t len,
+			   bool finish,
+			   streambuf *dest ) = 0;
+  protected:
+    bool output( size_t len, streambuf *dest ){
+      /// write len bytes of the output buffer to dest
+      return len == 0
+	|| dest->sputn( _out.data(), len ) == static_cast<streamsize>(len);
+    }
+    vector<char> _out; ///< the output buffer
+  };
+
+  /// pass the data on without compression
+  class copy_compressor: public compressor {
+  public:
+    copy_compressor(): compressor( 0 ){};
+    bool compress( const char *data, size_t len, bool, streambuf *dest ){
+      return len == 0
+	|| dest->sputn( data, len ) == static_cast<streamsize>(len);
+    }
+  };
+
+  /// gzip compression, using zlib
+  class gzip_compressor: public compressor {
+  public:
+    gzip_compressor( int level, size_t size ): compressor( size ){
+      _zs = z_stream();
+      if ( level < 0 ){
+	level = Z_BEST_COMPRESSION;
+      }
+      // windowBits 15 + 16: write a gzip header and trailer
+      if ( deflateInit2( &_zs, level, Z_DEFLATED, 15+16,
+			 8, Z_DEFAULT_STRATEGY ) != Z_OK ){
+	throw runtime_error( "gzip compression: initialization failed" );
+      }
+    }
+    ~gzip_compressor(){
+      deflateEnd( &_zs );
+    }
+    bool compress( const char *data, size_t len, bool finish, streambuf *dest ){
+      _zs.next_in = (Bytef*)data;
+      _zs.avail_in = len;
+      while ( true ){
+	_zs.next_out = (Bytef*)_out.data();
+	_zs.avail_out = _out.size();
+	int ret = deflate( &_zs, finish ? Z_FINISH : Z_NO_FLUSH );
+	if ( ret == Z_STREAM_ERROR
+	     || !output( _out.size() - _zs.avail_out, dest ) ){
+	  return false;
+	}
+	if ( finish ){
+	  if ( ret == Z_STREAM_END ){
+	    return true;
+	  }
+	}
+	else if ( _zs.avail_out != 0 ){
+	  return true;
+	}
+      }
+    }
+  private:
+    z_stream _zs;
+  };
+
+  /// bzip2 compression, using libbz2
+  class bzip2_compressor: public compressor {
+  public:
+    bzip2_compressor( int level, size_t size ): compressor( size ){
+      _bs = bz_stream();
+      if ( level < 1 || level > 9 ){
+	level = 9;
+      }
+      // for bzip2 the level is the block size in units of 100k
+      if ( BZ2_bzCompressInit( &_bs, level, 0, 0 ) != BZ_OK ){
+	throw runtime_error( "bzip2 compression: initialization failed" );
+      }
+    }
+    ~bzip2_compressor(){
+      BZ2_bzCompressEnd( &_bs );
+    }
+    bool compress( const char *data, size_t len, bool finish, streambuf *dest ){
+      _bs.next_in = const_cast<char*>(data);
+      _bs.avail_in = len;
+      while ( true ){
+	_bs.next_out = _out.data();
+	_bs.avail_out = _out.size();
+	int ret = BZ2_bzCompress( &_bs, finish ? BZ_FINISH : BZ_RUN );
+	if ( ret < 0
+	     || !output( _out.size() - _bs.avail_out, dest ) ){
+	  return false;
+	}
+	if ( finish ){
+	  if ( ret == BZ_STREAM_END ){
+	    return true;
+	  }
+	}
+	else if ( _bs.avail_in == 0 ){
+	  return true;
+	}
+      }
+    }
+  private:
+    bz_stream _bs;
+  };
+
+#ifdef HAVE_LZMA
+  /// xz compression, using liblzma
+  class xz_compressor: public compressor {
+  public:
+    xz_compressor( int level, size_t size ): compressor( size ){
+      _ls = LZMA_STREAM_INIT;
+      if ( level < 0 || level > 9 ){
+	level = LZMA_PRESET_DEFAULT;
+      }
+      if ( lzma_easy_encoder( &_ls, level, LZMA_CHECK_CRC64 ) != LZMA_OK ){
+	throw runtime_error( "xz compression: initialization failed" );
+      }
+    }
+    ~xz_compressor(){
+      lzma_end( &_ls );
+    }
+    bool compress( const char *data, size_t len, bool finish, streambuf *dest ){
+      _ls.next_in = (const uint8_t*)data;
+      _ls.avail_in = len;
+      while ( true ){
+	_ls.next_out = (uint8_t*)_out.data();
+	_ls.avail_out = _out.size();
+	lzma_ret ret = lzma_code( &_ls, finish ? LZMA_FINISH : LZMA_RUN );
+	if ( ( ret != LZMA_OK && ret != LZMA_STREAM_END )
+	     || !output( _out.size() - _ls.avail_out, dest ) ){
+	  return false;
+	}
+	if ( ret == LZMA_STREAM_END ){
+	  return true;
+	}
+	if ( !finish
+	     && _ls.avail_in == 0
+	     && _ls.avail_out != 0 ){
+	  return true;
+	}
+      }
+    }
+  private:
+    lzma_stream _ls;
+  };
+#endif
+
+#ifdef HAVE_ZSTD
+  /// zstandard compression, using libzstd
+  class zstd_compressor: public compressor {
+  public:
+    zstd_compressor( int level, size_t size ): compressor( size ){
+      _cs = ZSTD_createCStream();
+      if ( level < 1 || level > ZSTD_maxCLevel() ){
+	level = ZSTD_CLEVEL_DEFAULT;
+      }
+      if ( !_cs
+	   || ZSTD_isError( ZSTD_initCStream( _cs, level ) ) ){
+	ZSTD_freeCStream( _cs );
+	throw runtime_error( "zstd compression: initialization failed" );
+      }
+    }
+    ~zstd_compressor(){
+      ZSTD_freeCStream( _cs );
+    }
+    bool compress( const char *data, size_t len, bool finish, streambuf *dest ){
+      ZSTD_inBuffer in = { data, len, 0 };
+      while ( in.pos < in.size ){
+	ZSTD_outBuffer out = { _out.data(), _out.size(), 0 };
+	size_t ret = ZSTD_compressStream( _cs, &out, &in );
+	if ( ZSTD_isError( ret )
+	     || !output( out.pos, dest ) ){
+	  return false;
+	}
+      }
+      if ( finish ){
+	size_t remaining = 1;
+	while ( remaining != 0 ){
+	  ZSTD_outBuffer out = { _out.data(), _out.size(), 0 };
+	  remaining = ZSTD_endStream( _cs, &out );
+	  if ( ZSTD_isError( remaining )
+	       || !output( out.pos, dest ) ){
+	    return false;
+	  }
+	}
+      }
+      return true;
+    }
+  private:
+    ZSTD_CStream *_cs;
+  };
+#endif
+
+  static compressor *create_compressor( COMPRESSION comp,
+					int level,
+					size_t size ){
+    /// create a compressor for \e comp. Throws when not available
+    switch ( comp ){
+    case COMPRESSION::NONE:
+      return new copy_compressor();
+    case COMPRESSION::GZIP:
+      return new gzip_compressor( level, size );
+    case COMPRESSION::BZIP2:
+      return new bzip2_compressor( level, size );
+#ifdef HAVE_LZMA
+    case COMPRESSION::XZ:
+      return new xz_compressor( level, size );
+#endif
+#ifdef HAVE_ZSTD
+    case COMPRESSION::ZSTD:
+      return new zstd_compressor( level, size );
+#endif
+    default:
+      throw runtime_error( "compression format not supported in this build" );
+    }
+  }
+
+  compressing_streambuf::compressing_streambuf( streambuf *dest,
+						COMPRESSION comp,
+						int level,
+						size_t block_size ):
+    _dest(dest),
+    _compressor(0),
+    _finished(false)
+  {
+    /// create a compressing_streambuf
+    /*!
+     * \param dest the streambuf to write the compressed data to
+     * \param comp the compression format
+     * \param level the compression level. -1 (the default) means the
+     * default for the format: 9 for gzip and bzip2, 6 for xz and 3 for zstd.
+     * For bzip2 the level also determines the block size of the compressor.
+     * \param block_size the size of the blocks of data that are handed to
+     * the compressor at once. 0 (the default) means 64 KiB.
+     */
+    if ( block_size == 0 ){
+      block_size = DEFAULT_BLOCK_SIZE;
+    }
+    _compressor = create_compressor( comp, level, block_size );
+    _buffer.resize( block_size );
+    setp( _buffer.data(), _buffer.data() + _buffer.size() );
+  }
+
+  compressing_streambuf::~compressing_streambuf(){
+    /// destructor. Completes the compressed stream if that wasn't done yet
+    finish();
+    delete _compressor;
+  }
+
+  bool compressing_streambuf::compress_buffer( bool final ){
+    /// hand the buffered data to the compressor
+    /*!
+     * \param final when true, also complete the compressed stream
+     * \return false on errors
+     */
+    bool ok = _compressor->compress( pbase(), pptr() - pbase(), final, _dest );
+    setp( _buffer.data(), _buffer.data() + _buffer.size() );
+    return ok;
+  }
+
+  compressing_streambuf::int_type compressing_streambuf::overflow( int_type c ){
+    /// compress the full buffer, and store c
+    if ( _finished
+	 || !compress_buffer( false ) ){
+      return traits_type::eof();
+    }
+    if ( !traits_type::eq_int_type( c, traits_type::eof() ) ){
+      *pptr() = traits_type::to_char_type( c );
+      pbump( 1 );
+    }
+    return traits_type::not_eof( c );
+  }
+
+  int compressing_streambuf::sync(){
+    /// hand the buffered data to the compressor and flush the destination
+    if ( _finished ){
+      return 0;
+    }
+    if ( !compress_buffer( false ) ){
+      return -1;
+    }
+    return _dest->pubsync();
+  }
+
+  bool compressing_streambuf::finish(){
+    /// compress the remaining data and complete the compressed stream
+    /*!
+     * \return false on errors
+     *
+     * After finish() no more data can be written.
+     */
+    if ( _finished ){
+      return true;
+    }
+    _finished = true;
+    bool ok = compress_buffer( true );
+    return _dest->pubsync() == 0 && ok;
+  }
+
+  compressed_ofstream::compressed_ofstream( const string& file_name,
+					    COMPRESSION comp,
+					    int level,
+					    size_t block_size ):
+    ostream( 0 ),
+    _zbuf( 0 )
+  {
+    /// open an output file, writing compressed data
+    /*!
+     * \param file_name the name of the file
+     * \param comp the compression format. Use compression_for() to select
+     * it based on the file name
+     * \param level the compression level. -1 (default) means the default
+     * of the format.
+     * \param block_size the size of the data blocks handed to the
+     * compressor. 0 (default) means 64 KiB.
+     *
+     * When the file cannot be opened, the stream is in a failed state.
+     * Throws when the compression format is not supported.
+     */
+    // create the compressor first, so we don't create a file in vain
+    _zbuf = new compressing_streambuf( &_file, comp, level, block_size );
+    if ( !_file.open( file_name, ios::out|ios::binary|ios::trunc ) ){
+      setstate( ios::failbit );
+      return;
+    }
+    rdbuf( _zbuf );
+  }
+
+  compressed_ofstream::~compressed_ofstream(){
+    /// destructor. closes the file
+    close();
+    delete _zbuf;
+  }
+
+  void compressed_ofstream::close(){
+    /// complete the compressed data and close the file
+    /*!
+     * sets the failbit when anything went wrong
+     */
+    if ( !_file.is_open() ){
+      return;
+    }
+    if ( !_zbuf->finish() ){
+      setstate( ios::badbit );
+    }
+    if ( !_file.close() ){
+      setstate( ios::failbit );
+    }
+  }
+
+} // namespace folia
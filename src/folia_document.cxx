@@ -25,12 +25,15 @@
 */
 #include <cassert>
 #include <cstdlib>
+#include <cstring>
+#include <cctype>
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <algorithm>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <stdexcept>
 #include "config.h"
 #include "ticcutils/PrettyPrint.h"
@@ -41,6 +44,9 @@
 #include "libfolia/folia.h"
 #include "libfolia/folia_properties.h"
 #include "libxml/xmlstring.h"
+#include "zlib.h"
+#include "unicode/utf8.h"
+#include "unicode/utf16.h"
 
 using namespace std;
 using namespace icu;
@@ -72,7 +78,8 @@ namespace folia {
       \param kwargs a list of key-value pairs
 
       this function initializes a Document and can set the attributes
-      \e 'debug' and \e 'mode'
+      \e 'debug', \e 'mode', \e 'threads', \e 'compression_level' and
+      \e 'compression_blocksize'
 
       When the attributes \e 'file' or \e 'string' are found, the value is used
       to extract a complete FoLiA document from that file or string.
@@ -87,6 +94,18 @@ namespace folia {
     if ( !value.empty() ){
       setmode( value );
     }
+    value = args.extract( "threads" );
+    if ( !value.empty() ){
+      threads = TiCC::stringTo<unsigned int>( value );
+    }
+    value = args.extract( "compression_level" );
+    if ( !value.empty() ){
+      compression_level = TiCC::stringTo<int>( value );
+    }
+    value = args.extract( "compression_blocksize" );
+    if ( !value.empty() ){
+      compression_blocksize = TiCC::stringTo<size_t>( value );
+    }
     value = args.extract( "file" );
     if ( !value.empty() ){
       // extract a Document from a file
@@ -186,9 +205,13 @@ namespace folia {
     _foliaNsIn_prefix = 0;
     _foliaNsOut = 0;
     debug = 0;
+    threads = 1;
+    compression_level = -1;
+    compression_blocksize = 0;
     mode = Mode( CHECKTEXT|AUTODECLARE );
     _external_document = false;
     _incremental_parse = false;
+    _source_mode = NOMODE;
     major_version = 0;
     minor_version = 0;
     sub_version = 0;
@@ -229,7 +252,9 @@ namespace folia {
       The following modes can be set:
       '(no)permissive' (default is NO), '(no)strip' (default is NO),
       '(no)canonical (default is NO), '(no)checktext (default is checktext),
-      '(no)fixtext (default is NO), (no)autodeclare (default is NO)
+      '(no)fixtext (default is NO), (no)autodeclare (default is NO),
+      '(no)explicit (default is NO), (no)keepsource (default is NO),
+      '(no)compact (default is NO)
 
       example:
 
@@ -285,6 +310,18 @@ namespace folia {
       else if ( mod == "noexplicit" ){
 	mode = Mode( int(mode) & ~EXPLICIT );
       }
+      else if ( mod == "keepsource" ){
+	mode = Mode( int(mode) | KEEPSOURCE );
+      }
+      else if ( mod == "nokeepsource" ){
+	mode = Mode( int(mode) & ~KEEPSOURCE );
+      }
+      else if ( mod == "compact" ){
+	mode = Mode( int(mode) | COMPACT );
+      }
+      else if ( mod == "nocompact" ){
+	mode = Mode( int(mode) & ~COMPACT );
+      }
       else {
 	throw invalid_argument( "FoLiA::Document: unsupported mode value: "+ mod );
       }
@@ -328,6 +365,12 @@ namespace folia {
     if ( mode & EXPLICIT ){
       result += "explicit,";
     }
+    if ( mode & KEEPSOURCE ){
+      result += "keepsource,";
+    }
+    if ( mode & COMPACT ){
+      result += "compact,";
+    }
     return result;
   }
 
@@ -444,6 +487,46 @@ namespace folia {
     return old_val;
   }
 
+  bool Document::set_keepsource( bool new_val ) const{
+    /// sets the 'keepsource' mode to on/off
+    /*!
+      \param new_val the boolean to use for on/off
+      \return the previous value
+
+      Only effective when set before reading a document. The source is kept
+      and on output the source of unmodified nodes is reused.
+    */
+    bool old_val = (mode & KEEPSOURCE);
+    if ( new_val ){
+      mode = Mode( (int)mode | KEEPSOURCE );
+    }
+    else {
+      mode = Mode( (int)mode & ~KEEPSOURCE );
+    }
+    return old_val;
+  }
+
+  bool Document::set_compact( bool new_val ) const{
+    /// sets the 'compact' mode to on/off
+    /*!
+      \param new_val the boolean to use for on/off
+      \return the previous value
+
+      In compact mode, the output is not indented. Together with the
+      (default) implicit form, which leaves out set, processor, annotator
+      and datetime attributes that equal the declared defaults, this gives
+      the smallest files.
+    */
+    bool old_val = (mode & COMPACT);
+    if ( new_val ){
+      mode = Mode( (int)mode | COMPACT );
+    }
+    else {
+      mode = Mode( (int)mode & ~COMPACT );
+    }
+    return old_val;
+  }
+
   void Document::add_doc_index( FoliaElement* el, const string& id ){
     /// add a FoliaElement to the index
     /*!
@@ -454,11 +537,7 @@ namespace folia {
     if ( id.empty() ) {
       return;
     }
-    auto it = sindex.find( id );
-    if ( it == sindex.end() ){
-      sindex[id] = el;
-    }
-    else {
+    if ( !sindex.insert( id, el ) ){
       throw DuplicateIDError( id );
     }
   }
@@ -523,6 +602,215 @@ namespace folia {
     return;
   }
 
+  static string gz_read_file( const string& file_name ){
+    /// read a (possibly gzip compressed) file in a string
+    gzFile gz = gzopen( file_name.c_str(), "rb" );
+    if ( !gz ){
+      throw invalid_argument( "file not found: " + file_name );
+    }
+    string result;
+    char buf[64*1024];
+    int len;
+    while ( ( len = gzread( gz, buf, sizeof(buf) ) ) > 0 ){
+      result.append( buf, len );
+    }
+    gzclose( gz );
+    if ( len < 0 ){
+      throw runtime_error( "error reading: " + file_name );
+    }
+    return result;
+  }
+
+  static bool foreign_prefix( const char *name, size_t len,
+			      const string& folia_prefix ){
+    /// check if an xml name has a prefix we don't declare ourselves on output
+    const char *colon = (const char*)memchr( name, ':', len );
+    if ( !colon ){
+      return false;
+    }
+    string prefix( name, colon - name );
+    return prefix != folia_prefix
+      && prefix != "xml"
+      && prefix != "xlink"
+      && prefix != "xmlns";
+  }
+
+  static bool scan_source_ranges( const string& src,
+				  const string& folia_prefix,
+				  vector<pair<size_t,size_t>>& ranges,
+				  vector<bool>& usable ){
+    /// find the byte range of every element in an XML source
+    /*!
+      \param src the XML source
+      \param folia_prefix the prefix used for the FoLiA namespace
+      \param ranges returns the [begin,end) ranges, in document order
+      \param usable returns for every range whether it may be reused as is.
+      This is not the case for nodes holding wrefs, as the t attribute of a
+      wref depends on the refered word, or when they use namespace prefixes
+      that will not be declared in the output.
+      \return false for sources we can't handle: with a DOCTYPE, or broken
+    */
+    vector<size_t> open;
+    size_t pos = 0;
+    const size_t len = src.size();
+    while ( ( pos = src.find( '<', pos ) ) != string::npos ){
+      if ( src.compare( pos, 4, "<!--" ) == 0 ){
+	pos = src.find( "-->", pos+4 );
+	if ( pos == string::npos ){
+	  return false;
+	}
+	pos += 3;
+      }
+      else if ( src.compare( pos, 9, "<![CDATA[" ) == 0 ){
+	pos = src.find( "]]>", pos+9 );
+	if ( pos == string::npos ){
+	  return false;
+	}
+	pos += 3;
+      }
+      else if ( src.compare( pos, 2, "<?" ) == 0 ){
+	pos = src.find( "?>", pos+2 );
+	if ( pos == string::npos ){
+	  return false;
+	}
+	pos += 2;
+      }
+      else if ( src.compare( pos, 2, "<!" ) == 0 ){
+	// a DOCTYPE. might define entities: too complicated
+	return false;
+      }
+      else if ( src.compare( pos, 2, "</" ) == 0 ){
+	pos = src.find( '>', pos+2 );
+	if ( pos == string::npos || open.empty() ){
+	  return false;
+	}
+	pos += 1;
+	ranges[open.back()].second = pos;
+	open.pop_back();
+      }
+      else {
+	size_t begin = pos++;
+	size_t name = pos;
+	while ( pos < len && !isspace( (unsigned char)src[pos] )
+		&& src[pos] != '/' && src[pos] != '>' ){
+	  ++pos;
+	}
+	bool ok = !foreign_prefix( &src[name], pos - name, folia_prefix );
+	if ( src.compare( name, pos-name, "wref" ) == 0
+	     || ( pos - name > 5
+		  && src.compare( pos-5, 5, ":wref" ) == 0 ) ){
+	  ok = false;
+	}
+	bool empty = false;
+	while ( true ){
+	  while ( pos < len && isspace( (unsigned char)src[pos] ) ){
+	    ++pos;
+	  }
+	  if ( pos >= len ){
+	    return false;
+	  }
+	  if ( src[pos] == '>' ){
+	    ++pos;
+	    break;
+	  }
+	  if ( src.compare( pos, 2, "/>" ) == 0 ){
+	    pos += 2;
+	    empty = true;
+	    break;
+	  }
+	  size_t att = pos;
+	  while ( pos < len && src[pos] != '='
+		  && !isspace( (unsigned char)src[pos] ) ){
+	    ++pos;
+	  }
+	  if ( foreign_prefix( &src[att], pos - att, folia_prefix ) ){
+	    ok = false;
+	  }
+	  pos = src.find_first_of( "\"'", pos );
+	  if ( pos == string::npos ){
+	    return false;
+	  }
+	  pos = src.find( src[pos], pos+1 );
+	  if ( pos == string::npos ){
+	    return false;
+	  }
+	  ++pos;
+	}
+	if ( !ok ){
+	  // this node can't be reused, and neither can its ancestors
+	  for ( const auto& o : open ){
+	    usable[o] = false;
+	  }
+	}
+	ranges.push_back( make_pair( begin, empty ? pos : 0 ) );
+	usable.push_back( ok );
+	if ( !empty ){
+	  open.push_back( ranges.size()-1 );
+	}
+      }
+    }
+    return open.empty();
+  }
+
+  static bool map_source_ranges( const string& src,
+				 xmlDoc *xdoc,
+				 vector<pair<size_t,size_t>>& ranges ){
+    /// register the source ranges of the element nodes of a parsed document
+    /*!
+      \param src the XML source of xdoc
+      \param xdoc the parsed document
+      \param ranges the storage for the ranges
+      \return true when all went well
+
+      the _private field of every reusable xmlNode is set to point to its
+      range in the source. AbstractElement::parseXml() picks them up.
+    */
+    if ( xdoc->encoding
+	 && !xmlStrEqual( xdoc->encoding, (const xmlChar*)"UTF-8" )
+	 && !xmlStrEqual( xdoc->encoding, (const xmlChar*)"utf-8" ) ){
+      return false;
+    }
+    xmlNode *root = xmlDocGetRootElement( xdoc );
+    string folia_prefix;
+    if ( root && root->ns && root->ns->prefix ){
+      folia_prefix = (const char*)root->ns->prefix;
+    }
+    vector<bool> usable;
+    if ( !root
+	 || !scan_source_ranges( src, folia_prefix, ranges, usable ) ){
+      return false;
+    }
+    // walk the element nodes in document order, like the scanner did
+    vector<xmlNode*> nodes;
+    nodes.reserve( ranges.size() );
+    xmlNode *node = root;
+    while ( node ){
+      if ( node->type == XML_ELEMENT_NODE ){
+	nodes.push_back( node );
+	if ( node->children ){
+	  node = node->children;
+	  continue;
+	}
+      }
+      while ( node != root && !node->next ){
+	node = node->parent;
+      }
+      if ( node == root ){
+	break;
+      }
+      node = node->next;
+    }
+    if ( nodes.size() != ranges.size() ){
+      return false;
+    }
+    for ( size_t i=0; i < nodes.size(); ++i ){
+      if ( usable[i] ){
+	nodes[i]->_private = &ranges[i];
+      }
+    }
+    return true;
+  }
+
   bool Document::read_from_file( const string& file_name ){
     /// read a FoLiA document from a file
     /*!
@@ -530,9 +818,10 @@ namespace folia {
       \return true on succes. Will throw otherwise.
 
       This function also takes care of files in .bz2 or .gz format when the
-      right extension is given.
+      right extension is given. Files created with save_binary() are
+      recognized automaticly.
     */
-    ifstream is( file_name );
+    ifstream is( file_name, ios::binary );
     if ( !is.good() ){
       throw invalid_argument( "file not found: " + file_name );
     }
@@ -540,10 +829,19 @@ namespace folia {
       throw logic_error( "Document is already initialized" );
     }
     _source_filename = file_name;
+    if ( is_binary_folia( is ) ){
+      string buffer( (istreambuf_iterator<char>( is )),
+		     istreambuf_iterator<char>() );
+      return read_from_binary( buffer );
+    }
     if ( TiCC::match_back( file_name, ".bz2" ) ){
       string buffer = TiCC::bz2ReadFile( file_name );
       return read_from_string( buffer );
     }
+    if ( keepsource() ){
+      // we need the (decompressed) bytes ourselves
+      return read_from_string( gz_read_file( file_name ) );
+    }
     int cnt = 0;
     xmlSetStructuredErrorFunc( &cnt, (xmlStructuredErrorFunc)error_sink );
     _xmldoc = xmlReadFile( file_name.c_str(),
@@ -600,11 +898,20 @@ namespace folia {
       if ( debug ){
 	cout << "read a doc from string" << endl;
       }
+      vector<pair<size_t,size_t>> ranges;
+      if ( keepsource()
+	   && !fixtext()
+	   && map_source_ranges( buffer, _xmldoc, ranges ) ){
+	_source = buffer;
+      }
       foliadoc = parseXml();
       if ( !validate_offsets() ){
 	// cannot happen. validate_offsets() throws on error
 	throw InconsistentText("MEH");
       }
+      if ( !_source.empty() ){
+	save_source_state();
+      }
       if ( debug ){
 	if ( foliadoc ){
 	  cout << "successful parsed the doc" << endl;
@@ -652,9 +959,10 @@ namespace folia {
       \param canonical determines to output in canonical order. Default is no.
     */
     bool old_k = set_canonical(canonical);
-    os << toXml( ns_label );
-    // the toXml() string already ends with a newline (i hope....)
-    // but flush the stream
+    {
+      XmlWriter writer( os, !compact() );
+      write_xml( writer, ns_label );
+    }
     os.flush();
     set_canonical(old_k);
     return os.good();
@@ -670,8 +978,8 @@ namespace folia {
       FoLiA nodes in the default namespace.
       \param canonical determines to output in canonical order. Default is no.
 
-      This function also takes care of output to files in .bz2 or .gz format
-      when the right extension is given.
+      This function also takes care of output to files in .gz, .bz2, .xz or
+      .zst format when the right extension is given.
     */
     bool old_k = set_canonical(canonical);
     bool result = false;
@@ -692,15 +1000,10 @@ namespace folia {
       \return the complete document in an unformatted string
     */
     bool old_k = set_canonical(canonical);
-    xmlDoc *outDoc = to_xmlDoc( "" );
+    string result;
+    XmlWriter writer( result, false ); // no formatting
+    write_xml( writer, "" );
     set_canonical(old_k);
-    xmlChar *buf; int size;
-    xmlDocDumpFormatMemoryEnc( outDoc, &buf, &size,
-			       output_encoding, 0 ); // no formatting
-    string result = string( (const char *)buf, size );
-    xmlFree( buf );
-    xmlFreeDoc( outDoc );
-    _foliaNsOut = 0;
     return result;
   }
 
@@ -710,13 +1013,32 @@ namespace folia {
       \param id the id we search
       \return the FoliaElement with this \e id or 0, when not present
      */
-    const auto& it = sindex.find( id );
-    if ( it == sindex.end() ){
-      return 0;
-    }
-    else {
-      return it->second;
-    }
+    return sindex.find( id );
+  }
+
+  FoliaElement* Document::index( const char *id, size_t len ) const {
+    /// search for the element with xml:id id
+    /*!
+      \param id the id we search. Need not be 0 terminated
+      \param len the length of id
+      \return the FoliaElement with this \e id or 0, when not present
+
+      Unlike index( const string& ) this needs no std::string, so parsers
+      can look up an id directly in their buffer.
+     */
+    return sindex.find( id, len );
+  }
+
+  vector<FoliaElement*> Document::index_prefix( const string& prefix ) const {
+    /// search for all elements with an xml:id 'under' prefix
+    /*!
+      \param prefix an id, like "doc.p.3.s.7"
+      \return all FoliaElements with id \e prefix or with an id starting
+      with \e prefix followed by a '.', sorted on id.
+
+      This has to scan the whole index.
+    */
+    return sindex.find_prefix( prefix );
   }
 
   FoliaElement* Document::operator []( const string& id ) const {
@@ -755,6 +1077,286 @@ namespace folia {
     return foliadoc->text( cls, flags );
   }
 
+  UnicodeString Document::parallel_text( const std::string& cls,
+					 bool retaintok,
+					 bool strict,
+					 unsigned int threads ) const {
+    /// return the text content of the whole document, using several threads
+    /*!
+      \param cls The textclass to use fro searching.
+      \param retaintok Should we retain the tokenization. Default NO.
+      \param strict Should we perform a strict search? Default NO.
+      \param threads the number of threads to use. Default 0, meaning one
+      per core
+      \return the same text as text() would.
+     */
+    TEXT_FLAGS flags = TEXT_FLAGS::NONE;
+    if ( retaintok ){
+      flags = flags | TEXT_FLAGS::RETAIN;
+    }
+    if ( strict ){
+      flags = flags | TEXT_FLAGS::STRICT;
+    }
+    return foliadoc->parallel_text( cls, flags, threads );
+  }
+
+  UnicodeString Document::corrected_text( CORRECTION_HANDLING handling,
+					  size_t suggestion,
+					  const std::string& cls,
+					  bool retaintok ) const {
+    /// return the text content of the whole document, choosing the text of
+    /// all Corrections in the same way
+    /*!
+      \param handling which text of the Corrections to use: NEW, ORIGINAL or
+      SUGGESTION
+      \param suggestion the index of the Suggestion to use, when handling is
+      SUGGESTION. Corrections without that Suggestion use the default.
+      \param cls The textclass to use for searching.
+      \param retaintok Should we retain the tokenization. Default NO.
+      \return the complete text as an UnicodeString
+     */
+    TEXT_FLAGS flags = TEXT_FLAGS::NONE;
+    if ( retaintok ){
+      flags = flags | TEXT_FLAGS::RETAIN;
+    }
+    return foliadoc->corrected_text( handling, suggestion, cls, flags );
+  }
+
+  void Document::parallel_for_each( ElementType et,
+				    const function<void(FoliaElement*)>& func,
+				    unsigned int threads ) const {
+    /// call a function on all elements of a type, using several threads
+    /*!
+      \param et the type of the elements, e.g. Paragraph_t
+      \param func the function to call for every element
+      \param threads the number of threads to use. Default 0, meaning one
+      per core
+
+      The elements are selected like words() does, ignoring those within
+      structure annotation layers. \e func may use all const FoliaElement
+      functions, but may NOT modify the Document.
+    */
+    vector<FoliaElement*> elts = foliadoc->select( et,
+						   default_ignore_structure );
+    parallel_for( elts.size(),
+		  [&]( size_t i ){ func( elts[i] ); },
+		  threads );
+  }
+
+  vector<pair<Utterance*,UnicodeString> >
+  Document::utterance_transcriptions( const string& cls,
+				      unsigned int threads ) const {
+    /// return the phonetic content of all Utterances in the Document
+    /*!
+      \param cls the textclass of the phonetic content
+      \param threads the number of threads to use. Default 1. 0 means one
+      per core
+      \return a list of (Utterance, phon) pairs, in document order. The
+      phon is empty for Utterances without phonetic content.
+
+      The Utterances are selected like parallel_for_each() does. This
+      never throws NoSuchPhon, and uses the phon() cache of every node.
+    */
+    vector<Utterance*> utts
+      = foliadoc->select<Utterance>( default_ignore_structure );
+    vector<pair<Utterance*,UnicodeString> > result( utts.size() );
+    parallel_for( utts.size(),
+		  [&]( size_t i ){
+		    result[i].first = utts[i];
+		    utts[i]->try_phon( result[i].second, cls );
+		  },
+		  threads );
+    return result;
+  }
+
+  struct span_cursor {
+    /// a forward walker over the text of a reference element
+    /*!
+     * keeps the UTF-16, code point and UTF-8 byte positions in sync, so
+     * consecutive spans in the same text are located in linear time
+     */
+    UnicodeString text;
+    bool initialized = false;
+    bool valid = false;
+    int32_t unit = 0;
+    size_t cp = 0;
+    size_t byte = 0;
+    int32_t search_from = 0;
+    void seek( int32_t );
+  };
+
+  void span_cursor::seek( int32_t target ){
+    /// move the cursor to UTF-16 position \e target
+    if ( target < unit ){
+      unit = 0;
+      cp = 0;
+      byte = 0;
+    }
+    const char16_t *buf = text.getBuffer();
+    int32_t len = text.length();
+    while ( unit < target ){
+      UChar32 c;
+      U16_NEXT( buf, unit, len, c );
+      ++cp;
+      byte += U8_LENGTH( c );
+    }
+  }
+
+  static bool locate_span( span_cursor& cur,
+			   const UnicodeString& sub,
+			   int offset,
+			   text_span& span ){
+    /// locate \e sub in the text of \e cur and fill the positions of span
+    /*!
+     * \param cur the cursor of the reference text
+     * \param sub the text to find
+     * \param offset the declared offset of sub, or -1. Used when it matches
+     * \param span the text_span to fill
+     * \return true when sub is found
+     *
+     * Without a (valid) offset, we search forward from the end of the
+     * previous span, and only then from the start of the text.
+     */
+    int32_t len = sub.length();
+    int32_t pos = -1;
+    if ( offset >= 0
+	 && offset + len <= cur.text.length()
+	 && cur.text.compare( offset, len, sub ) == 0 ){
+      pos = offset;
+    }
+    else {
+      pos = cur.text.indexOf( sub, cur.search_from );
+      if ( pos < 0 && cur.search_from > 0 ){
+	pos = cur.text.indexOf( sub );
+      }
+    }
+    if ( pos < 0 ){
+      return false;
+    }
+    cur.seek( pos );
+    span.begin = cur.cp;
+    span.byte_begin = cur.byte;
+    cur.seek( pos + len );
+    span.end = cur.cp;
+    span.byte_end = cur.byte;
+    cur.search_from = pos + len;
+    return true;
+  }
+
+  static FoliaElement *span_reference( const FoliaElement *e ){
+    /// find the nearest Structure, String or Subtoken ancestor of \e e
+    FoliaElement *p = e->parent();
+    while ( p ){
+      if ( p->isSubClass( String_t )
+	   || p->isSubClass( AbstractStructureElement_t )
+	   || p->isSubClass( AbstractSubtokenAnnotation_t ) ){
+	return p;
+      }
+      p = p->parent();
+    }
+    return 0;
+  }
+
+  typedef unordered_map<const FoliaElement*,span_cursor> cursor_map;
+
+  static void add_text_span( FoliaElement *e,
+			     FoliaElement *ref,
+			     const string& cls,
+			     TEXT_FLAGS flags,
+			     int offset,
+			     cursor_map& cursors,
+			     vector<text_span>& result ){
+    /// add the span of \e e in the text of \e ref to result, when found
+    if ( !ref ){
+      return;
+    }
+    span_cursor& cur = cursors[ref];
+    if ( !cur.initialized ){
+      cur.initialized = true;
+      cur.valid = ref->try_text( cur.text, cls, flags );
+    }
+    UnicodeString sub;
+    if ( !cur.valid
+	 || !e->try_text( sub, cls, flags )
+	 || sub.isEmpty() ){
+      return;
+    }
+    text_span span;
+    span.element = e;
+    span.reference = ref;
+    if ( locate_span( cur, sub, offset, span ) ){
+      result.push_back( span );
+    }
+  }
+
+  static void collect_text_spans( const FoliaElement *e,
+				  const string& cls,
+				  cursor_map& deep,
+				  cursor_map& strict,
+				  vector<text_span>& result ){
+    /// recursively add the text_spans of all the children of \e e
+    for ( const auto& child : e->data() ){
+      if ( child->parent() != e ){
+	// a reference, like the Words in a Dependency
+	continue;
+      }
+      ElementType et = child->element_id();
+      if ( default_ignore.find( et ) != default_ignore.end() ){
+	continue;
+      }
+      if ( et == TextContent_t ){
+	if ( child->cls() == cls ){
+	  // a TextContent is located in the STRICT text of the element its
+	  // offset refers to. Like check_offset() does
+	  TextContent *tc = dynamic_cast<TextContent*>( child );
+	  FoliaElement *ref = 0;
+	  if ( tc->offset() >= 0 ){
+	    try {
+	      ref = tc->find_reference();
+	    }
+	    catch ( const UnresolvableTextContent& ){
+	    }
+	  }
+	  else {
+	    ref = tc->find_default_reference();
+	  }
+	  add_text_span( tc, ref, cls, TEXT_FLAGS::STRICT, tc->offset(),
+			 strict, result );
+	}
+	continue;
+      }
+      if ( et == Word_t || et == String_t ){
+	add_text_span( child, span_reference( child ), cls,
+		       TEXT_FLAGS::NONE, -1, deep, result );
+      }
+      collect_text_spans( child, cls, deep, strict, result );
+    }
+  }
+
+  vector<text_span> Document::text_spans( const string& cls ) const {
+    /// return the positions of all Words, Strings and TextContents
+    /*!
+      \param cls the textclass to use
+      \return a list of text_span records, in document order
+
+      Words and Strings are located in the text of their nearest
+      Structure, String or Subtoken ancestor. TextContents are located in
+      the STRICT text of the element they refer to, which is what their
+      offset attribute is relative to. Begin and end are given both in
+      code points and in UTF-8 bytes.
+
+      The whole Document is handled in one pass: every reference text is
+      resolved only once, and spans in it are searched forward from the
+      previous one. Elements inside the default_ignore set, and elements
+      without (findable) text are left out.
+    */
+    vector<text_span> result;
+    cursor_map deep;
+    cursor_map strict;
+    collect_text_spans( foliadoc, cls, deep, strict, result );
+    return result;
+  }
+
   static const set<ElementType> quoteSet = { Quote_t };
   static const set<ElementType> emptySet;
 
@@ -1041,17 +1643,14 @@ namespace folia {
     if ( !_foreign_metadata ){
       _foreign_metadata = new ForeignMetaData( "foreign" );
     }
-    ForeignData *add = new ForeignData();
     if ( TiCC::Name( node ) != "foreign-data" ){
       // we need an extra layer then
       xmlNode *n = TiCC::XmlNewNode( "foreign-data" );
       xmlAddChild( n, xmlCopyNode( node, 1 ) );
-      add->set_data( n );
       _foreign_metadata->add_foreign( n );
       xmlFreeNode (n );
     }
     else {
-      add->set_data( node );
       _foreign_metadata->add_foreign( node );
     }
   }
@@ -1541,7 +2140,7 @@ namespace folia {
 	if ( !_foreign_metadata ){
 	  _foreign_metadata = new ForeignMetaData( "imdi" );
 	}
-	_foreign_metadata->add_foreign( xmlCopyNode(m,1) );
+	_foreign_metadata->add_foreign( m );
       }
       else if ( TiCC::Name( m ) == "annotations" &&
 		checkNS( m, NSFOLIA ) ){
@@ -1583,16 +2182,10 @@ namespace folia {
       }
       else if ( TiCC::Name(m)  == "foreign-data" &&
 		checkNS( m, NSFOLIA ) ){
-	FoliaElement *t = AbstractElement::createElement( "foreign-data", this );
-	if ( t ){
-	  t = t->parseXml( m );
-	  if ( t ){
-	    if ( !_foreign_metadata ){
-	      _foreign_metadata = new ForeignMetaData( type );
-	    }
-	    _foreign_metadata->add_foreign( m );
-	  }
+	if ( !_foreign_metadata ){
+	  _foreign_metadata = new ForeignMetaData( type );
 	}
+	_foreign_metadata->add_foreign( m );
       }
       else if ( TiCC::Name(m)  == "submetadata" &&
 		checkNS( m, NSFOLIA ) ){
@@ -1689,6 +2282,109 @@ namespace folia {
     }
   }
 
+  static string offset_error( const TextContent *txt,
+			      const UnresolvableTextContent& e ){
+    /// construct the error message for an invalid offset in a \<t\>
+    string msg = "Text for " + txt->parent()->xmltag() + "(ID="
+      + txt->parent()->id() + ", textclass='" + txt->cls()
+      + "'), has incorrect offset " + TiCC::toString(txt->offset());
+    string ref = txt->ref();
+    if ( !ref.empty() ){
+      msg += " or invalid reference:" + ref;
+    }
+    msg += "\n\toriginal msg=";
+    msg += e.what();
+    return msg;
+  }
+
+  static string offset_error( const PhonContent *phon,
+			      const UnresolvableTextContent& e ){
+    /// construct the error message for an invalid offset in a \<ph\>
+    string msg = "Phoneme for " + phon->parent()->xmltag() + ", ID="
+      + phon->parent()->id() + ", textclass='" + phon->cls()
+      + "', has incorrect offset " + TiCC::toString(phon->offset());
+    string ref = phon->ref();
+    if ( !ref.empty() ){
+      msg += " or invalid reference:" + ref;
+    }
+    msg += "\n\toriginal msg=";
+    msg += e.what();
+    return msg;
+  }
+
+  static UnicodeString reference_content( const FoliaElement *ref,
+					  const TextContent *txt ){
+    /// return the text of ref the offset of txt refers to
+    return ref->text( txt->cls(), TEXT_FLAGS::STRICT );
+  }
+
+  static UnicodeString reference_content( const FoliaElement *ref,
+					  const PhonContent *phon ){
+    /// return the phonetic content of ref the offset of phon refers to
+    return ref->phon( phon->cls() );
+  }
+
+  template <class C>
+  static void validate_content_offsets( const vector<C*>& buffer,
+					bool check_text,
+					unsigned int threads ){
+    /// validate the offsets of a buffer of TextContent or PhonContent nodes
+    /*!
+      \param buffer the nodes to check
+      \param check_text when false, only the references are resolved
+      \param threads the number of threads to use. 0 means one per core
+
+      The nodes are grouped on their reference and class, so the content of
+      every reference is computed only once, and all nodes in a group are
+      checked against it. The groups are independent, so they may be
+      checked in parallel.
+    */
+    set<C*> done;
+    map<pair<const FoliaElement*,string>,size_t> group_of;
+    vector<const FoliaElement*> refs;
+    vector<vector<C*>> groups;
+    for ( const auto& c : buffer ){
+      if ( !done.insert( c ).second
+	   || c->offset() == -1 ){
+	continue;
+      }
+      FoliaElement *ref = 0;
+      try {
+	ref = c->find_reference();
+      }
+      catch( UnresolvableTextContent& e ){
+	throw UnresolvableTextContent( offset_error( c, e ) );
+      }
+      auto key = make_pair( (const FoliaElement*)ref, c->cls() );
+      auto it = group_of.find( key );
+      if ( it == group_of.end() ){
+	group_of[key] = groups.size();
+	refs.push_back( ref );
+	groups.push_back( vector<C*>( 1, c ) );
+      }
+      else {
+	groups[it->second].push_back( c );
+      }
+    }
+    if ( !check_text ){
+      return;
+    }
+    parallel_for( groups.size(),
+		  [&]( size_t g ){
+		    UnicodeString content = reference_content( refs[g],
+							       groups[g][0] );
+		    for ( const auto& c : groups[g] ){
+		      try {
+			c->check_offset( refs[g], content );
+		      }
+		      catch( UnresolvableTextContent& e ){
+			throw UnresolvableTextContent( offset_error( c, e ) );
+		      }
+		    }
+		  },
+		  threads );
+  }
+
   bool Document::validate_offsets() const {
     /// Validate all the offset values as found in all \<t\> and \<p\> nodes
     /*!
@@ -1696,59 +2392,50 @@ namespace folia {
       until the whole parsing is done.
 
       Then we are able to examine those nodes in their context and check the
-      offsets used.
+      offsets used. The text of every refered element is computed only once.
+      When the Document has a 'threads' setting other than 1, the refered
+      elements are handled in parallel. In that case, when there are several
+      errors, it is undefined which one is reported.
      */
-    set<TextContent*> t_done;
-    for ( const auto& txt : t_offset_validation_buffer ){
-      if ( t_done.find( txt ) != t_done.end() ){
-	continue;
-      }
-      t_done.insert(txt);
-      int offset = txt->offset();
-      if ( offset != -1 ){
-	try {
-	  txt->get_reference();
-	}
-	catch( UnresolvableTextContent& e ){
-	  string msg = "Text for " + txt->parent()->xmltag() + "(ID="
-	    + txt->parent()->id() + ", textclass='" + txt->cls()
-	    + "'), has incorrect offset " + TiCC::toString(offset);
-	  string ref = txt->ref();
-	  if ( !ref.empty() ){
-	    msg += " or invalid reference:" + ref;
+    bool check_text = checktext() || fixtext();
+    validate_content_offsets( t_offset_validation_buffer, check_text, threads );
+    validate_content_offsets( p_offset_validation_buffer, check_text, threads );
+    return true;
+  }
+
+  static size_t count_xml_ids( const xmlNode *root ){
+    /// count the nodes with an xml:id attribute in a tree
+    /*!
+      \param root the top of the tree
+      \return the number of xml:id attributes found
+      This is used as a size hint for the id index, before parsing
+    */
+    size_t result = 0;
+    const xmlNode *node = root;
+    while ( node ){
+      if ( node->type == XML_ELEMENT_NODE ){
+	for ( const xmlAttr *a = node->properties; a; a = a->next ){
+	  if ( a->ns
+	       && xmlStrEqual( a->name, (const xmlChar*)"id" )
+	       && xmlStrEqual( a->ns->href, XML_XML_NAMESPACE ) ){
+	    ++result;
+	    break;
 	  }
-	  msg += "\n\toriginal msg=";
-	  msg += e.what();
-	  throw UnresolvableTextContent( msg );
+	}
+	if ( node->children ){
+	  node = node->children;
+	  continue;
 	}
       }
-    }
-    set<PhonContent*> p_done;
-    for ( const auto& phon : p_offset_validation_buffer ){
-      if ( p_done.find( phon ) != p_done.end() ){
-	continue;
+      while ( node != root && !node->next ){
+	node = node->parent;
       }
-      p_done.insert(phon);
-      int offset = phon->offset();
-      if ( offset != -1 ){
-	try {
-	  phon->get_reference();
-	}
-	catch( UnresolvableTextContent& e ){
-	  string msg = "Phoneme for " + phon->parent()->xmltag() + ", ID="
-	    + phon->parent()->id() + ", textclass='" + phon->cls()
-	    + "', has incorrect offset " + TiCC::toString(offset);
-	  string ref = phon->ref();
-	  if ( !ref.empty() ){
-	    msg += " or invalid reference:" + ref;
-	  }
-	  msg += "\n\toriginal msg=";
-	  msg += e.what();
-	  throw UnresolvableTextContent( msg );
-	}
+      if ( node == root ){
+	break;
       }
+      node = node->next;
     }
-    return true;
+    return result;
   }
 
   FoliaElement* Document::parseXml( ){
@@ -1788,6 +2475,7 @@ namespace folia {
 	  throw XmlError( "Folia Document should have namespace declaration "
 			  + NSFOLIA + " but found: " + ns );
 	}
+	sindex.reserve( count_xml_ids( root ) );
 	try {
 	  FoLiA *folia = new FoLiA( this );
 	  result = folia->parseXml( root );
@@ -3019,9 +3707,30 @@ namespace folia {
     }
   }
 
-  void Document::add_submetadata( xmlNode *node ) const {
-    /// add a submetadata block to node
-    for ( const auto& it : submetadata ){
+  xmlNode *Document::foreign_node( const FoliaElement *foreign,
+				   foreign_map *placeholders ) const {
+    /// return the xmlNode tree of a ForeignData, or a placeholder for it
+    /*!
+      \param foreign the ForeignData element
+      \param placeholders when not 0, an empty placeholder node is returned
+      instead, and registered here. So we avoid building the tree.
+    */
+    if ( placeholders ){
+      xmlNode *result = TiCC::XmlNewNode( "foreign-data" );
+      (*placeholders)[result] = foreign;
+      return result;
+    }
+    return foreign->xml( true, false );
+  }
+
+  void Document::add_submetadata( xmlNode *node,
+				  foreign_map *placeholders ) const {
+    /// add a submetadata block to node
+    /*!
+      \param node the metadata node
+      \param placeholders when not 0, ForeignData is added as placeholders
+    */
+    for ( const auto& it : submetadata ){
       xmlNode *sm = TiCC::XmlNewNode( foliaNs(), "submetadata" );
       KWargs atts;
       atts["xml:id"] = it.first;
@@ -3051,15 +3760,19 @@ namespace folia {
       }
       else if ( md->datatype() == "ForeignMetaData" ){
 	for ( const auto& foreign : md->get_foreigners() ) {
-	  xmlNode *f = foreign->xml( true, false );
-	  xmlAddChild( sm, f );
+	  xmlAddChild( sm, foreign_node( foreign, placeholders ) );
 	}
       }
     }
   }
 
-  void Document::add_metadata( xmlNode *node ) const{
+  void Document::add_metadata( xmlNode *node,
+			       foreign_map *placeholders ) const{
     /// add a metadata block to node
+    /*!
+      \param node the metadata node
+      \param placeholders when not 0, ForeignData is added as placeholders
+    */
     if ( _metadata ){
       if ( _metadata->datatype() == "ExternalMetaData" ){
 	KWargs atts;
@@ -3091,8 +3804,7 @@ namespace folia {
 	addAttributes( node, atts );
       }
       for ( const auto& foreign : _foreign_metadata->get_foreigners() ) {
-	xmlNode *f = foreign->xml( true, false );
-	xmlAddChild( node, f );
+	xmlAddChild( node, foreign_node( foreign, placeholders ) );
       }
     }
     if ( !_metadata
@@ -3101,7 +3813,7 @@ namespace folia {
       atts["type"] = "native";
       addAttributes( node, atts );
     }
-    add_submetadata( node );
+    add_submetadata( node, placeholders );
   }
 
   void Document::add_styles( xmlDoc* doc ) const {
@@ -3118,10 +3830,16 @@ namespace folia {
     }
   }
 
-  xmlDoc *Document::to_xmlDoc( const string& ns_label ) const {
-    /// convert the Document to an xmlDoc
+  xmlDoc *Document::xml_skeleton( const string& ns_label,
+				  foreign_map *placeholders ) const {
+    /// create an xmlDoc with only the root node and the metadata
     /*!
       \param ns_label a namespace label to use. (default "")
+      \param placeholders when not 0, foreign metadata is added as
+      placeholders, registered here. (default 0)
+
+      Also sets the output namespace _foliaNsOut, which is to be cleared by
+      the caller after use.
     */
     xmlDoc *outDoc = xmlNewDoc( (const xmlChar*)"1.0" );
     add_styles( outDoc );
@@ -3168,7 +3886,17 @@ namespace folia {
     xmlNode *md = xmlAddChild( root, TiCC::XmlNewNode( foliaNs(), "metadata" ) );
     add_annotations( md );
     add_provenance( md );
-    add_metadata( md );
+    add_metadata( md, placeholders );
+    return outDoc;
+  }
+
+  xmlDoc *Document::to_xmlDoc( const string& ns_label ) const {
+    /// convert the Document to an xmlDoc
+    /*!
+      \param ns_label a namespace label to use. (default "")
+    */
+    xmlDoc *outDoc = xml_skeleton( ns_label );
+    xmlNode *root = xmlDocGetRootElement( outDoc );
     for ( size_t i=0; i < foliadoc->size(); ++i ){
       FoliaElement* el = foliadoc->index(i);
       xmlAddChild( root, el->xml( true, canonical() ) );
@@ -3176,6 +3904,173 @@ namespace folia {
     return outDoc;
   }
 
+  string Document::declaration_state( AnnotationType type ) const {
+    /// return a string describing all declarations for an AnnotationType
+    stringstream ss;
+    auto it = _annotationdefaults.find( type );
+    if ( it != _annotationdefaults.end() ){
+      for ( const auto& ann : it->second ){
+	ss << ann.first << "=" << ann.second << ann.second.f << ";";
+      }
+    }
+    auto ait = _set_alias.find( type );
+    if ( ait != _set_alias.end() ){
+      for ( const auto& al : ait->second ){
+	ss << al.first << "->" << al.second << ";";
+      }
+    }
+    return ss.str();
+  }
+
+  void Document::save_source_state(){
+    /// register the state that determines the output of the source nodes
+    /*!
+      This is the output related mode, the version, and the declarations of
+      all AnnotationTypes used.
+    */
+    _source_mode = Mode( int(mode) & (STRIP|EXPLICIT) );
+    _source_version = _version_string;
+    _source_declarations.clear();
+    for ( const auto& it : _annotationdefaults ){
+      _source_declarations[it.first] = declaration_state( it.first );
+    }
+  }
+
+  bool Document::source_usable() const {
+    /// may the source be reused for unmodified nodes?
+    /*!
+      This is the case when we are in KEEPSOURCE mode, have a source and
+      nothing changed that influences the output of unmodified nodes: the
+      output mode, the version or the declarations of any AnnotationType in
+      the source. Newly added AnnotationTypes don't matter. In canonical
+      mode the source is never used.
+    */
+    if ( !keepsource()
+	 || _source.empty()
+	 || canonical()
+	 || _source_mode != Mode( int(mode) & (STRIP|EXPLICIT) )
+	 || _source_version != _version_string ){
+      return false;
+    }
+    for ( const auto& it : _source_declarations ){
+      if ( declaration_state( it.first ) != it.second ){
+	return false;
+      }
+    }
+    return true;
+  }
+
+  static bool holds_placeholder( const xmlNode *node,
+				 const map<const xmlNode*,const FoliaElement*>& fm ){
+    /// does the tree under node contain a placeholder from fm?
+    if ( fm.find( node ) != fm.end() ){
+      return true;
+    }
+    for ( const xmlNode *p = node->children; p; p = p->next ){
+      if ( holds_placeholder( p, fm ) ){
+	return true;
+      }
+    }
+    return false;
+  }
+
+  static void write_skeleton( XmlWriter& writer,
+			      xmlNode *node,
+			      const map<const xmlNode*,const FoliaElement*>& fm ){
+    /// write a node of the skeleton, replacing the placeholders in fm
+    /// by the output of their ForeignData
+    auto it = fm.find( node );
+    if ( it != fm.end() ){
+      it->second->write_xml( writer );
+    }
+    else if ( !holds_placeholder( node, fm ) ){
+      writer.node( node );
+    }
+    else {
+      // only metadata and submetadata contain foreign data, so no text
+      writer.start_node( node, XmlWriter::ELEMENTS );
+      for ( xmlNode *p = node->children; p; p = p->next ){
+	write_skeleton( writer, p, fm );
+      }
+      writer.end_element();
+    }
+  }
+
+  void Document::write_header( XmlWriter& writer,
+				const string& ns_label ) const {
+    /// write the XML declaration, the FoLiA start tag and the metadata
+    /*!
+      \param writer the XmlWriter to use
+      \param ns_label a namespace label to use. (default "")
+
+      The FoLiA element is left open: the body should follow, and then a
+      call to writer.end_element(). Only the small metadata part is still
+      built as an xmlNode tree. Foreign metadata is written directly from
+      its stored XML.
+      Also sets the prefix of the writer to the namespace label used.
+    */
+    foreign_map placeholders;
+    xmlDoc *outDoc = xml_skeleton( ns_label, &placeholders );
+    // the encoding is needed to get the same attribute escaping as a dump
+    outDoc->encoding = xmlStrdup( (const xmlChar*)output_encoding );
+    try {
+      writer.declaration( output_encoding );
+      for ( const xmlNode *pi = outDoc->children; pi; pi = pi->next ){
+	if ( pi->type == XML_PI_NODE ){
+	  writer.processing_instruction( (const char*)pi->name,
+					 (const char*)pi->content );
+	}
+      }
+      xmlNode *root = xmlDocGetRootElement( outDoc );
+      string prefix;
+      if ( _foliaNsOut->prefix ){
+	prefix = (const char*)_foliaNsOut->prefix;
+      }
+      writer.set_prefix( prefix );
+      writer.start_node( root, XmlWriter::ELEMENTS );
+      for ( xmlNode *md = root->children; md; md = md->next ){
+	write_skeleton( writer, md, placeholders );
+      }
+    }
+    catch ( ... ){
+      xmlFreeDoc( outDoc );
+      _foliaNsOut = 0;
+      throw;
+    }
+    xmlFreeDoc( outDoc );
+    _foliaNsOut = 0;
+  }
+
+  void Document::write_xml( XmlWriter& writer,
+			    const string& ns_label ) const {
+    /// write the Document as XML text, without building an xmlDoc
+    /*!
+      \param writer the XmlWriter to use
+      \param ns_label a namespace label to use. (default "")
+
+      The output is the same as dumping to_xmlDoc() with libxml2.
+
+      When the Document has threads != 1, the body is rendered in parallel.
+      See XmlWriter::set_threads()
+
+      In KEEPSOURCE mode, the source of unmodified nodes is copied to the
+      output as is, when possible. See source_usable()
+    */
+    if ( !foliadoc ){
+      throw runtime_error( "can't save, no doc" );
+    }
+    write_header( writer, ns_label );
+    writer.set_threads( threads );
+    if ( writer.formatting()
+	 && source_usable() ){
+      writer.set_source( &_source );
+    }
+    for ( size_t i=0; i < foliadoc->size(); ++i ){
+      foliadoc->index(i)->write_xml( writer, canonical() );
+    }
+    writer.end_element();
+  }
+
   string Document::toXml( const string& ns_label ) const {
     /// dump the Document to a string
     /*!
@@ -3183,14 +4078,8 @@ namespace folia {
     */
     string result;
     if ( foliadoc ){
-      xmlDoc *outDoc = to_xmlDoc( ns_label );
-      xmlChar *buf; int size;
-      xmlDocDumpFormatMemoryEnc( outDoc, &buf, &size,
-				 output_encoding, 1 );
-      result = string( (const char *)buf, size );
-      xmlFree( buf );
-      xmlFreeDoc( outDoc );
-      _foliaNsOut = 0;
+      XmlWriter writer( result, !compact() );
+      write_xml( writer, ns_label );
     }
     else {
       throw runtime_error( "can't save, no doc" );
@@ -3205,39 +4094,32 @@ namespace folia {
       \param file_name the name of the file to create
       \param ns_label a namespace label to use. (default "")
       \return false on error, true otherwise
-      automaticly detects .gz and .bz2 filenames and will handle accordingly
+      automaticly detects .gz, .bz2, .xz and .zst filenames and compresses
+      the output on the fly, using compression_level and
+      compression_blocksize.
     */
-    if ( foliadoc ){
-      long int res = 0;
-      if ( TiCC::match_back( file_name, ".bz2" ) ){
-	string tmpname = file_name.substr( 0, file_name.length() - 3 ) + "tmp";
-	if ( toXml( tmpname, ns_label ) ){
-	  bool stat = TiCC::bz2Compress( tmpname, file_name );
-	  remove( tmpname.c_str() );
-	  if ( !stat ){
-	    res = -1;
-	  }
-	}
-      }
-      else {
-	xmlDoc *outDoc = to_xmlDoc( ns_label );
-	if ( TiCC::match_back( file_name, ".gz" ) ){
-	  xmlSetDocCompressMode(outDoc,9);
-	}
-	res = xmlSaveFormatFileEnc( file_name.c_str(),
-				    outDoc,
-				    output_encoding, 1 );
-	xmlFreeDoc( outDoc );
-	_foliaNsOut = 0;
-      }
-      if ( res == -1 ){
-	return false;
-      }
+    if ( !foliadoc ){
+      return false;
     }
-    else {
+    compressed_ofstream os( file_name,
+			    compression_for( file_name ),
+			    compression_level,
+			    compression_blocksize );
+    if ( !os ){
       return false;
     }
-    return true;
+    try {
+      XmlWriter writer( os, !compact() );
+      write_xml( writer, ns_label );
+    }
+    catch ( ... ){
+      // don't leave a truncated file behind
+      os.close();
+      remove( file_name.c_str() );
+      throw;
+    }
+    os.close();
+    return os.good();
   }
 
   Pattern::Pattern( const vector<string>& pat_vec,
@@ -3249,43 +4131,7 @@ namespace folia {
       \param et The kind of elements to match on
       \param args additionale search options as attribute/value pairs
     */
-    regexp = false;
-    case_sensitive = false;
-    KWargs kw = getArgs( args );
-    matchannotationset = kw["matchannotationset"];
-    if (kw["regexp"] != "" ){
-      regexp = TiCC::stringTo<bool>( kw["regexp"] );
-    }
-    if (kw["maxgapsize"] != "" ){
-      maxgapsize = TiCC::stringTo<int>( kw["maxgapsize"] );
-    }
-    else {
-      maxgapsize = 10;
-    }
-    if ( kw["casesensitive"] != "" ){
-      case_sensitive = TiCC::stringTo<bool>( kw["casesensitive"] );
-    }
-    for ( const auto& pat : pat_vec ){
-      if ( pat.find( "regexp('" ) == 0 &&
-	   pat.rfind( "')" ) == pat.length()-2 ){
-	string tmp = pat.substr( 8, pat.length() - 10 );
-	UnicodeString us = TiCC::UnicodeFromUTF8( tmp );
-	UErrorCode u_stat = U_ZERO_ERROR;
-	RegexMatcher *matcher = new RegexMatcher(us, 0, u_stat);
-	if ( U_FAILURE(u_stat) ){
-	  throw runtime_error( "failed to create a regexp matcher with '" + tmp + "'" );
-	}
-	matchers.push_back( matcher );
-	sequence.push_back( "" );
-      }
-      else {
-	sequence.push_back( TiCC::UnicodeFromUTF8(pat) );
-	matchers.push_back( 0 );
-	if ( !case_sensitive ){
-	  sequence.back().toLower();
-	}
-      }
-    }
+    init( pat_vec, args );
   }
 
   Pattern::Pattern( const std::vector<std::string>& pat_vec,
@@ -3295,6 +4141,23 @@ namespace folia {
       \param pat_vec a list if search terms (may be regular expressions)
       \param args additionale search options as attribute/value pairs
     */
+    init( pat_vec, args );
+  }
+
+  void Pattern::init( const vector<string>& pat_vec,
+		      const string& args ){
+    /// initialize a Pattern from a list of search terms
+    /*!
+      \param pat_vec a list if search terms (may be regular expressions)
+      \param args additionale search options as attribute/value pairs
+
+      A term of the form "regexp('...')" is always handled as a regular
+      expression. When the 'regexp' option is set, ALL terms, except the
+      wildcards "*" and "*:1", are handled as regular expressions.
+      The 'casesensitive' option only applies to literal terms. Regular
+      expressions are always case-sensitive, like before. Use the ICU
+      flag (?i) in the expression itself to match case-insensitive.
+    */
     regexp = false;
     case_sensitive = false;
     KWargs kw = getArgs( args );
@@ -3312,33 +4175,94 @@ namespace folia {
       case_sensitive = TiCC::stringTo<bool>( kw["casesensitive"] );
     }
     for ( const auto& pat : pat_vec ){
+      string re;
       if ( pat.find( "regexp('" ) == 0 &&
 	   pat.rfind( "')" ) == pat.length()-2 ){
-	string tmp = pat.substr( 8, pat.length() - 10 );
-	UnicodeString us = TiCC::UnicodeFromUTF8( tmp );
+	re = pat.substr( 8, pat.length() - 10 );
+      }
+      else if ( regexp && pat != "*" && pat != "*:1" ){
+	re = pat;
+      }
+      if ( !re.empty() ){
+	UnicodeString us = TiCC::UnicodeFromUTF8( re );
 	UErrorCode u_stat = U_ZERO_ERROR;
 	RegexMatcher *matcher = new RegexMatcher(us, 0, u_stat);
 	if ( U_FAILURE(u_stat) ){
-	  throw runtime_error( "failed to create a regexp matcher with '" + tmp + "'" );
+	  delete matcher;
+	  clear_matchers();
+	  throw runtime_error( "failed to create a regexp matcher with '" + re + "'" );
 	}
 	matchers.push_back( matcher );
 	sequence.push_back( "" );
+	kinds.push_back( REGEX );
       }
       else {
 	sequence.push_back( TiCC::UnicodeFromUTF8(pat) );
 	matchers.push_back( 0 );
-	if ( !case_sensitive ){
-	  sequence.back().toLower();
+	if ( pat == "*" ){
+	  kinds.push_back( GAP );
+	}
+	else if ( pat == "*:1" ){
+	  kinds.push_back( ANY );
+	}
+	else {
+	  kinds.push_back( LITERAL );
+	  if ( !case_sensitive ){
+	    sequence.back().toLower();
+	  }
 	}
       }
     }
   }
 
-  Pattern::~Pattern(){
-    /// destroy a Pattern
+  Pattern::Pattern( const Pattern& other ):
+    matchannotation( other.matchannotation ),
+    regexp( other.regexp ),
+    case_sensitive( other.case_sensitive ),
+    maxgapsize( other.maxgapsize ),
+    sequence( other.sequence ),
+    kinds( other.kinds ),
+    matchannotationset( other.matchannotationset )
+  {
+    /// copy a Pattern, creating fresh regex matchers
+    for ( const auto& m : other.matchers ){
+      RegexMatcher *matcher = 0;
+      if ( m ){
+	UErrorCode u_stat = U_ZERO_ERROR;
+	matcher = m->pattern().matcher( u_stat );
+      }
+      matchers.push_back( matcher );
+    }
+  }
+
+  Pattern& Pattern::operator=( const Pattern& other ){
+    /// assign a Pattern, creating fresh regex matchers
+    if ( this != &other ){
+      Pattern tmp( other );
+      clear_matchers();
+      matchannotation = tmp.matchannotation;
+      regexp = tmp.regexp;
+      case_sensitive = tmp.case_sensitive;
+      maxgapsize = tmp.maxgapsize;
+      sequence = tmp.sequence;
+      kinds = tmp.kinds;
+      matchannotationset = tmp.matchannotationset;
+      matchers.swap( tmp.matchers );
+    }
+    return *this;
+  }
+
+  void Pattern::clear_matchers(){
+    /// delete all regex matchers
     for ( const auto& m : matchers ){
       delete m;
     }
+    matchers.clear();
+  }
+
+  Pattern::~Pattern(){
+    /// destroy a Pattern
+    clear_matchers();
   }
 
   inline ostream& operator<<( ostream& os, const Pattern& p ){
@@ -3362,10 +4286,33 @@ namespace folia {
       \param flag
       \return true on a succesful match
     */
-    UnicodeString s = us;
+    UnicodeString lowered = us;
+    if ( !case_sensitive ){
+      lowered.toLower();
+    }
+    return step( us, lowered, pos, gap, done, flag );
+  }
+
+  bool Pattern::step( const UnicodeString& us,
+		      const UnicodeString& lowered,
+		      size_t& pos,
+		      int& gap,
+		      bool& done,
+		      bool& flag ) const {
+    /// try to match a value to the term at position pos, like match()
+    /*!
+      \param us A UnicodeString to match
+      \param lowered the lowercased value of us. Only used when not
+      case sensitive
+      \param pos the position of the term to try. Advanced on a match
+      \param gap the number of Words consumed by the current "*" term
+      \param done set to true when a match is complete
+      \param flag set to true when a complete match may still be extended
+      \return true on a succesful match
+    */
     //  cerr << "gap = " << gap << "cursor=" << pos << " vergelijk '" <<  sequence[pos] << "' met '" << us << "'" << endl;
     if ( matchers[pos] ){
-      matchers[pos]->reset( s );
+      matchers[pos]->reset( us );
       UErrorCode u_stat = U_ZERO_ERROR;
       if ( matchers[pos]->matches( u_stat ) ){
 	done = ( ++pos >= sequence.size() );
@@ -3377,9 +4324,7 @@ namespace folia {
       }
     }
     else {
-      if ( !case_sensitive ){
-	s.toLower();
-      }
+      const UnicodeString& s = ( case_sensitive ? us : lowered );
       if ( sequence[pos] == s || sequence[pos] == "*:1" ){
 	done = ( ++pos >= sequence.size() );
 	return true;
@@ -3416,42 +4361,270 @@ namespace folia {
 
   bool Pattern::variablesize() const {
     /// look if at least one sequence in the Pattern is "*"
-    return any_of( sequence.begin(),
-		   sequence.end(),
-		   []( const UnicodeString& s ) { return s == "*"; } );
+    return any_of( kinds.begin(),
+		   kinds.end(),
+		   []( term_kind k ) { return k == GAP; } );
   }
 
   void Pattern::unsetwild() {
     /// replace all sequence in the Pattern with value "*" by "*:1"
-    replace_if( sequence.begin(),
-		sequence.end(),
-		[]( const UnicodeString& s ) { return s == "*"; },
-		"*:1"
-		);
+    for ( size_t i=0; i < sequence.size(); ++i ){
+      if ( kinds[i] == GAP ){
+	sequence[i] = "*:1";
+	kinds[i] = ANY;
+      }
+    }
   }
 
   set<int> Pattern::variablewildcards() const {
     /// build an index of all "*" sequences
     set<int> result;
     for ( size_t i=0; i < sequence.size(); ++i ){
-      if ( sequence[i] == "*" ){
+      if ( kinds[i] == GAP ){
 	result.insert( i );
       }
     }
     return result;
   }
 
-  vector<vector<Word*> > Document::findwords( const Pattern& pat,
-					      const string& args ) const {
-    /// search the Document for vector of Word list matching the Pattern
+  class pattern_automaton {
+    /// runs a list of Patterns simultaneously in a single pass over a
+    /// sequence of Words
     /*!
-      \param pat The search Pattern
-      \param args additional search options as attribute/value pairs
-      \return a vector of Word list that matched. (if any)
-      supported additional arguments can be 'leftcontext' and 'rightcontext'
+      For every Word, the values needed by the Patterns (the text or the
+      class of the matchannotation) are extracted only once.
+
+      The result is exactly that of running Pattern::match() from every
+      start position in turn, as findwords() always did:
+      - every Word is a start position, and from every start position
+      the Pattern is followed until it fails
+      - a "*" term consumes Words until a Word matches the next term, or
+      until maxgapsize Words are consumed. When the next term matches, a
+      match is reported at once, even when more terms follow, and the
+      search goes on for a longer gap. A "*" as the last term consumes
+      exactly one Word
+      - a Pattern starting with "*" resumes at the Word after the last
+      Word it consumed with that "*"
+      - Words that don't have exactly one matchannotation are skipped by
+      the Patterns on that annotation: they are not matched and not part
+      of the result
+      The only deliberate difference: the sequential search did not forget
+      the Words of a start position that was still matching at the end of
+      the Document, and prepended them to the matches of the next start
+      positions. Here every match holds only its own Words.
+      Every start position is run as a separate 'thread'. Patterns that
+      start with a literal term only start threads on Words that have that
+      very value, as all other threads would fail at once.
+    */
+  public:
+    explicit pattern_automaton( const vector<const Pattern*>& );
+    vector<vector<vector<size_t>>> run( const vector<Word*>& );
+  private:
+    struct thread {
+      size_t pat;   ///< the index of the Pattern
+      size_t state; ///< the position in the sequence of the Pattern
+      int gap;      ///< the number of words consumed by the current GAP
+      size_t start; ///< the position of the first Word of the thread
+      vector<size_t> matched; ///< the positions of the matched Words
+    };
+    /// what a thread, started at some position, produced
+    struct outcome {
+      outcome(): restart( string::npos ) {};
+      vector<vector<size_t>> matches; ///< the matches, in order
+      size_t restart; ///< where the next start is, if not the next Word
+    };
+    struct word_value {
+      UnicodeString value;
+      UnicodeString lowered;
+      bool valid;
+    };
+    void extract_values( const Word *, vector<word_value>& ) const;
+    void start_threads( size_t,
+			const vector<word_value>&,
+			vector<thread>& ) const;
+    const vector<const Pattern*>& _patterns;
+    vector<ElementType> _keys;              ///< the distinct values to extract
+    vector<size_t> _key_of;                 ///< the key index per Pattern
+    vector<size_t> _always_start;           ///< Patterns without a literal start
+    vector<map<UnicodeString,vector<size_t>>> _start_exact; ///< per key
+    vector<map<UnicodeString,vector<size_t>>> _start_lower; ///< per key
+  };
+
+  pattern_automaton::pattern_automaton( const vector<const Pattern*>& pats ):
+    _patterns( pats ) {
+    /// build the automaton and the start index for a list of Patterns
+    for ( size_t p=0; p < pats.size(); ++p ){
+      const Pattern *pat = pats[p];
+      ElementType key = pat->matchannotation;
+      size_t k = find( _keys.begin(), _keys.end(), key ) - _keys.begin();
+      if ( k == _keys.size() ){
+	_keys.push_back( key );
+	_start_exact.resize( _keys.size() );
+	_start_lower.resize( _keys.size() );
+      }
+      _key_of.push_back( k );
+      if ( pat->size() > 0 && pat->kind(0) == Pattern::LITERAL ){
+	if ( pat->is_case_sensitive() ){
+	  _start_exact[k][pat->term(0)].push_back( p );
+	}
+	else {
+	  _start_lower[k][pat->term(0)].push_back( p );
+	}
+      }
+      else if ( pat->size() > 0 ){
+	_always_start.push_back( p );
+      }
+    }
+  }
+
+  void pattern_automaton::extract_values( const Word *word,
+					  vector<word_value>& values ) const {
+    /// extract all values needed by the Patterns from one Word
+    for ( size_t k=0; k < _keys.size(); ++k ){
+      word_value& wv = values[k];
+      wv.valid = false;
+      if ( _keys[k] == BASE ){
+	wv.value = word->text();
+	wv.valid = true;
+      }
+      else {
+	vector<FoliaElement *> v = word->select( _keys[k] );
+	if ( v.size() == 1 ){
+	  wv.value = TiCC::UnicodeFromUTF8( v[0]->cls() );
+	  wv.valid = true;
+	}
+      }
+      if ( wv.valid ){
+	wv.lowered = wv.value;
+	wv.lowered.toLower();
+      }
+    }
+  }
+
+  void pattern_automaton::start_threads( size_t pos,
+					 const vector<word_value>& values,
+					 vector<thread>& threads ) const {
+    /// start a thread at pos for every Pattern that might match there
+    for ( const auto& p : _always_start ){
+      if ( values[_key_of[p]].valid ){
+	threads.push_back( thread{ p, 0, 0, pos, {} } );
+      }
+    }
+    for ( size_t k=0; k < _keys.size(); ++k ){
+      if ( !values[k].valid ){
+	continue;
+      }
+      auto it = _start_exact[k].find( values[k].value );
+      if ( it != _start_exact[k].end() ){
+	for ( const auto& p : it->second ){
+	  threads.push_back( thread{ p, 0, 0, pos, {} } );
+	}
+      }
+      it = _start_lower[k].find( values[k].lowered );
+      if ( it != _start_lower[k].end() ){
+	for ( const auto& p : it->second ){
+	  threads.push_back( thread{ p, 0, 0, pos, {} } );
+	}
+      }
+    }
+  }
+
+  vector<vector<vector<size_t>>> pattern_automaton::run( const vector<Word*>& words ){
+    /// run all Patterns over a sequence of words
+    /*!
+      \param words the Words to match
+      \return per Pattern the positions of the Words of every match
     */
-    size_t leftcontext = 0;
-    size_t rightcontext = 0;
+    vector<map<size_t,outcome>> outcomes( _patterns.size() );
+    vector<vector<bool>> valid( _keys.size(), vector<bool>( words.size() ) );
+    vector<word_value> values( _keys.size() );
+    vector<thread> active;
+    for ( size_t i=0; i < words.size(); ++i ){
+      extract_values( words[i], values );
+      for ( size_t k=0; k < _keys.size(); ++k ){
+	valid[k][i] = values[k].valid;
+      }
+      start_threads( i, values, active );
+      vector<thread> next;
+      for ( auto& t : active ){
+	const word_value& wv = values[_key_of[t.pat]];
+	if ( !wv.valid ){
+	  // a Word to skip for this Pattern. The thread just waits
+	  next.push_back( std::move( t ) );
+	  continue;
+	}
+	const Pattern *pat = _patterns[t.pat];
+	bool done = false;
+	bool flag = false;
+	if ( !pat->step( wv.value, wv.lowered, t.state, t.gap, done, flag ) ){
+	  continue;
+	}
+	t.matched.push_back( i );
+	outcome& out = outcomes[t.pat][t.start];
+	if ( t.state == 0 ){
+	  out.restart = i;
+	}
+	if ( done ){
+	  out.matches.push_back( t.matched );
+	  if ( !flag ){
+	    continue;
+	  }
+	}
+	next.push_back( std::move( t ) );
+      }
+      active.swap( next );
+    }
+    // now visit the start positions in order, like a sequential search:
+    // a start position on a skipped Word behaves like the next valid one
+    vector<vector<vector<size_t>>> result( _patterns.size() );
+    for ( size_t p=0; p < _patterns.size(); ++p ){
+      const vector<bool>& val = valid[_key_of[p]];
+      vector<size_t> next_valid( words.size() + 1, string::npos );
+      for ( size_t i=words.size(); i > 0; --i ){
+	next_valid[i-1] = val[i-1] ? i-1 : next_valid[i];
+      }
+      size_t start = 0;
+      while ( start < words.size() ){
+	size_t v = next_valid[start];
+	if ( v == string::npos ){
+	  break;
+	}
+	const auto& it = outcomes[p].find( v );
+	if ( it == outcomes[p].end() ){
+	  ++start;
+	  continue;
+	}
+	const outcome& out = it->second;
+	result[p].insert( result[p].end(),
+			  out.matches.begin(), out.matches.end() );
+	start = ( out.restart == string::npos ? start : out.restart ) + 1;
+      }
+    }
+    return result;
+  }
+
+  static vector<Word*> add_context( const vector<Word*>& matched,
+				    size_t leftcontext,
+				    size_t rightcontext ){
+    /// extend a list of matched Words with their left and right context
+    vector<Word*> result;
+    if ( leftcontext > 0 ){
+      result = matched[0]->leftcontext(leftcontext);
+    }
+    result.insert( result.end(), matched.begin(), matched.end() );
+    if ( rightcontext > 0 ){
+      vector<Word*> right = matched.back()->rightcontext(rightcontext);
+      result.insert( result.end(), right.begin(), right.end() );
+    }
+    return result;
+  }
+
+  static void get_context_args( const string& args,
+				size_t& leftcontext,
+				size_t& rightcontext ){
+    /// extract the 'leftcontext' and 'rightcontext' search arguments
+    leftcontext = 0;
+    rightcontext = 0;
     KWargs kw = getArgs( args );
     string val = kw["leftcontext"];
     if ( !val.empty() ){
@@ -3461,91 +4634,70 @@ namespace folia {
     if ( !val.empty() ){
       rightcontext = TiCC::stringTo<size_t>(val);
     }
-    vector<vector<Word*> > result;
-    vector<Word*> matched;
-    if ( pat.regexp ){
-      throw runtime_error( "regexp not supported yet in patterns" );
+  }
+
+  vector<vector<Word*> > Document::findwords( const Pattern& pat,
+					      const string& args ) const {
+    /// search the Document for vector of Word list matching the Pattern
+    /*!
+      \param pat The search Pattern
+      \param args additional search options as attribute/value pairs
+      \return a vector of Word list that matched. (if any)
+      supported additional arguments can be 'leftcontext' and 'rightcontext'
+    */
+    list<Pattern> pats;
+    pats.push_back( pat );
+    vector<vector<vector<Word*> > > res = findwords_per_pattern( pats, args );
+    return res[0];
+  }
+
+  vector<vector<vector<Word*> > > Document::findwords_per_pattern( const list<Pattern>& pats,
+								    const string& args ) const {
+    /// search the Document for all matches of every Pattern in one pass
+    /*!
+      \param pats a list of search Patterns
+      \param args additional search options as attribute/value pairs
+      \return for every Pattern a vector of Word lists that matched
+      supported additional arguments can be 'leftcontext' and 'rightcontext'
+
+      All Patterns are run simultaneously over the Words of the Document,
+      so this is much cheaper than calling findwords() for every Pattern.
+    */
+    size_t leftcontext;
+    size_t rightcontext;
+    get_context_args( args, leftcontext, rightcontext );
+    vector<const Pattern*> pat_ptrs;
+    for ( const auto& p : pats ){
+      pat_ptrs.push_back( &p );
     }
     vector<Word*> mywords = words();
-    for ( size_t startpos =0; startpos < mywords.size(); ++startpos ){
-      // loop over all words
-      //    cerr << "outer loop STARTPOS = " << startpos << endl;
-      size_t cursor = 0;
-      int gap = 0;
-      bool goon = true;
-      for ( size_t i = startpos; i < mywords.size() && goon ; ++i ){
-	//      cerr << "inner LOOP I = " << i << " myword=" << mywords[i] << endl;
-	UnicodeString value;
-	if ( pat.matchannotation == BASE ){
-	  value = mywords[i]->text();
-	}
-	else {
-	  vector<FoliaElement *> v = mywords[i]->select( pat.matchannotation );
-	  if ( v.size() != 1 ){
-	    continue;
-	  }
-	  value = TiCC::UnicodeFromUTF8(v[0]->cls());
-	}
-	bool done = false;
-	bool flag = false;
-	if ( pat.match( value, cursor, gap, done, flag ) ){
-	  // cerr << "matched, " << (done?"done":"not done")
-	  //      << (flag?" Flagged!":":{") << endl;
-	  matched.push_back(mywords[i]);
-	  if ( cursor == 0 ){
-	    startpos = i; // restart search here
-	  }
-	  if ( done ){
-	    vector<Word*> keep = matched;
-	    //	  cerr << "findnodes() tussenresultaat ==> " << matched << endl;
-	    vector<Word*> tmp1;
-	    if ( leftcontext > 0 ){
-	      tmp1 = matched[0]->leftcontext(leftcontext);
-	      //	    cerr << "findnodes() tmp1 ==> " << tmp1 << endl;
-	      copy( matched.begin(), matched.end(), back_inserter(tmp1) );
-	      //	    cerr << "findnodes() tmp1 na copy ==> " << tmp1 << endl;
-	    }
-	    else {
-	      tmp1 = matched;
-	    }
-	    vector<Word*> tmp2;
-	    if ( rightcontext > 0 ){
-	      tmp2 = matched.back()->rightcontext(rightcontext);
-	      //	    cerr << "findnodes() tmp2 ==> " << tmp2 << endl;
-	      copy( tmp2.begin(), tmp2.end(), back_inserter(tmp1) );
-	      //	    cerr << "findnodes() tmp2 na copy ==> " << tmp2 << endl;
-	    }
-	    result.push_back(tmp1);
-	    //	  cerr << "findnodes() tussenresultaat 2 ==> " << tmp1 << endl;
-	    if ( flag ){
-	      matched = keep;
-	    }
-	    else {
-	      cursor = 0;
-	      matched.clear();
-	      goon = false;
-	    }
-	  }
-	}
-	else {
-	  cursor = 0;
-	  matched.clear();
-	  goon = false;
+    pattern_automaton automaton( pat_ptrs );
+    vector<vector<vector<size_t>>> found = automaton.run( mywords );
+    vector<vector<vector<Word*> > > result( pat_ptrs.size() );
+    for ( size_t p=0; p < found.size(); ++p ){
+      for ( const auto& positions : found[p] ){
+	vector<Word*> matched;
+	for ( const auto& pos : positions ){
+	  matched.push_back( mywords[pos] );
 	}
+	result[p].push_back( add_context( matched, leftcontext, rightcontext ) );
       }
     }
-    //  cerr << "findnodes() result ==> " << result << endl;
     return result;
   }
 
   vector<vector<Word*> > Document::findwords( list<Pattern>& pats,
 					      const string& args ) const {
-    /// search the Document for vector of Word list matching one of the Pattern
+    /// search the Document for vector of Word list matching the Patterns
     /*!
       \param pats a list of search Patterns
       \param args additional search options as attribute/value pairs
       \return a vector of Word list that matched. (if any)
       supported additional arguments can be 'leftcontext' and 'rightcontext'
+
+      The result is only returned when all Patterns give the same result.
+      Otherwise it is empty. Patterns without any match are ignored, as
+      long as no Pattern before them had a match.
     */
     size_t prevsize = 0;
     bool start = true;
@@ -3584,12 +4736,15 @@ namespace folia {
       }
     }
     vector<vector<Word*> > result;
-    for ( const auto& it : pats ){
-      vector<vector<Word*> > res = findwords( it, args );
+    if ( pats.empty() ){
+      return result;
+    }
+    vector<vector<vector<Word*> > > res = findwords_per_pattern( pats, args );
+    for ( const auto& r : res ){
       if ( result.empty() ){
-	result = res;
+	result = r;
       }
-      else if ( res != result ){
+      else if ( r != result ){
 	result.clear();
 	break;
       }
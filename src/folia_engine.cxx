@@ -110,6 +110,10 @@ namespace folia {
     _doc_type( TEXT ),
     _dbg_file(0),
     _os(0),
+    _writer(0),
+    _flush_policy(FLUSH_BYTES),
+    _flush_limit(64*1024),
+    _pending(0),
     _ok(false),
     _done(false),
     _header_done(false),
@@ -122,6 +126,7 @@ namespace folia {
     /// destructor
     xmlFreeTextReader( _reader );
     delete _out_doc;
+    delete _writer;
     delete _os;
   }
 
@@ -874,26 +879,37 @@ namespace folia {
     /// process a matched tag into a FoLiA subtree
     /// \param local_name the tag
     /// \param depth the location in the Document to attach to
-    KWargs atts = get_attributes( _reader );
-    if ( _debug ){
-      DBG << "name=" << local_name << " atts=" << atts << endl;
-    }
     if ( local_name == "wref" ){
-      string id = atts["id"];
-      if ( id.empty() ){
+      // look up the id straight from the reader buffer
+      const char *id = 0;
+      if ( xmlTextReaderMoveToAttribute( _reader, (const xmlChar*)"id" ) == 1 ){
+	id = (const char*)xmlTextReaderConstValue( _reader );
+      }
+      if ( _debug ){
+	DBG << "name=" << local_name << " id=" << (id?id:"") << endl;
+      }
+      if ( !id || !*id ){
+	xmlTextReaderMoveToElement( _reader );
 	_ok = false;
 	throw XmlError( "folia::engine, reference missing an 'id'" );
       }
-      FoliaElement *ref = (*_out_doc)[id];
+      FoliaElement *ref = _out_doc->index( id, strlen( id ) );
       if ( !ref ){
+	string bad = id;
+	xmlTextReaderMoveToElement( _reader );
 	_ok = false;
 	throw XmlError( "folia::engine, unresolvable reference: "
-			+ id );
+			+ bad );
       }
+      xmlTextReaderMoveToElement( _reader );
       ref->increfcount();
       append_node( ref, depth );
     }
     else {
+      KWargs atts = get_attributes( _reader );
+      if ( _debug ){
+	DBG << "name=" << local_name << " atts=" << atts << endl;
+      }
       FoliaElement *t = AbstractElement::createElement( local_name, _out_doc );
       if ( t ){
 	if ( local_name == "foreign-data" ){
@@ -986,63 +1002,15 @@ namespace folia {
       return false;
     }
     _header_done = true;
-    stringstream ss;
-    _out_doc->save( ss, ns_prefix );
-    string data = ss.str();
-    string search_b1;
-    string search_b2;
-    string search_e;
-    if ( _doc_type == TEXT ){
-      if ( !ns_prefix.empty() ){
-	search_b1 = "<" + ns_prefix + ":" + "text>";
-	search_b2 = "<" + ns_prefix + ":" + "text ";
-	search_e = "</" + ns_prefix + ":" + "text>";
-      }
-      else {
-	search_b1 = "<text>";
-	search_b2 = "<text ";
-	search_e = "</text>";
-      }
-    }
-    else {
-      if ( !ns_prefix.empty() ){
-	search_b1 = "<" + ns_prefix + ":" + "speech>";
-	search_b2 = "<" + ns_prefix + ":" + "speech ";
-	search_e = "</" + ns_prefix + ":" + "speech>";
-      }
-      else {
-	search_b1 = "<speech>";
-	search_b2 = "<speech ";
-	search_e = "</speech>";
-      }
-    }
-    string::size_type bpos1 = data.find( search_b1 );
-    string::size_type bpos2 = data.find( search_b2 );
-    string::size_type pos1;
-    if ( bpos1 < bpos2 ){
-      pos1 = bpos1;
-    }
-    else {
-      pos1 = bpos2;
-    }
-    string::size_type pos2;
-    if ( _root_node->size() == 0 ){
-      pos2 = data.find( "/>" , pos1 );
-    }
-    else {
-      pos2 = data.find( ">" , pos1 );
-    }
-    string head = data.substr( 0, pos2 ) + ">";
-    if ( _root_node->size() == 0 ){
-      pos2 += 2;
-    }
-    else {
-      pos2 = data.find( search_e, pos1 );
-      int add = search_e.size();
-      pos2 += add;
-    }
-    _footer = "  " + search_e + data.substr( pos2 );
-    *_os << head << endl;
+    _writer = new XmlWriter( *_os, !_out_doc->compact() );
+    _writer->set_flush_size( 0 );
+    _out_doc->write_header( *_writer, ns_prefix );
+    // the elements written by flush() are children of the root node
+    _writer->start_element( _root_node->xmltag(),
+			    _root_node->collectAttributes(),
+			    XmlWriter::ELEMENTS );
+    _pending = 0;
+    _last_sync = chrono::steady_clock::now();
     return true;
   }
 
@@ -1062,7 +1030,9 @@ namespace folia {
       return false;
     }
     else if ( flush() ){
-      *_os << _footer << endl;
+      _writer->end_element(); // the root node
+      _writer->end_element(); // FoLiA
+      sync_output( true );
       _finished = true;
       return true;
     }
@@ -1090,7 +1060,9 @@ namespace folia {
     }
     size_t len = _root_node->size();
     for ( size_t i=0; i < len; ++i ){
-      *_os << "    " << _root_node->index(i)->xmlstring(true,2,false) << endl;
+      _root_node->index(i)->write_xml( *_writer );
+      ++_pending;
+      sync_output( false );
     }
     for ( size_t i=0; i < len; ++i ){
       _root_node->remove( i, true );
@@ -1098,6 +1070,44 @@ namespace folia {
     return true;
   }
 
+  void Engine::set_flush_policy( flush_policy policy, size_t limit ){
+    /// set the moment the output of flush() is passed on to the output stream
+    /// \param policy what to count: bytes, elements or milliseconds
+    /// \param limit the amount to wait for. 0 means: immediately
+
+    /// flush() serializes the new elements into a buffer. By default, the
+    /// buffer is written (and the output stream flushed) when more than
+    /// 64 KiB is waiting. output_footer() always writes everything.
+    _flush_policy = policy;
+    _flush_limit = limit;
+  }
+
+  void Engine::sync_output( bool force ){
+    /// write the buffered output and flush the output stream, when due
+    /// \param force when true, do it regardless of the flush policy
+    bool due = force;
+    if ( !due ){
+      switch ( _flush_policy ){
+      case FLUSH_BYTES:
+	due = _writer->buffered() > _flush_limit;
+	break;
+      case FLUSH_ELEMENTS:
+	due = _pending >= _flush_limit;
+	break;
+      case FLUSH_TIME:
+	due = chrono::steady_clock::now() - _last_sync
+	  >= chrono::milliseconds( _flush_limit );
+	break;
+      }
+    }
+    if ( due ){
+      _writer->flush();
+      _os->flush();
+      _pending = 0;
+      _last_sync = chrono::steady_clock::now();
+    }
+  }
+
   bool Engine::finish() {
     /// finalize the Engine bij calling output_footer
     if ( _debug ){
@@ -1423,4 +1433,629 @@ namespace folia {
     return 0;
   }
 
+  struct TextExtractor::tag_info {
+    /// the properties of a FoLiA tag that matter for text extraction
+    ElementType et;
+    bool printable;
+    bool hidden;
+    bool structure;
+    bool span;
+    bool textcontainer;
+    bool space_att;
+    std::string textdelimiter;
+  };
+
+  struct TextExtractor::frame {
+    /// the text extraction state of an open element
+    enum kind_t { IGNORE, STRUCT, CORRECTION, CONTAINER };
+    struct entry {
+      /// a child of a textcontainer
+      bool is_text;
+      bool printable;
+      std::string text;
+      std::string delim;
+    };
+    void reset( kind_t k, const tag_info *i, bool n ){
+      /// prepare a (recycled) frame for a new element
+      kind = k;
+      info = i;
+      need = n;
+      space = true;
+      id.clear();
+      original.clear();
+      ignored = false;
+      children = 0;
+      last_et = BASE;
+      last_structure = false;
+      last_space = true;
+      first_delim.clear();
+      last_delim.clear();
+      has_word = false;
+      last_word_space = true;
+      text.clear();
+      sep.clear();
+      own.clear();
+      has_own = false;
+      deletion = false;
+      new_text.clear();
+      cur_text.clear();
+      org_text.clear();
+      org_own.clear();
+      has_org_own = false;
+      entries.clear();
+      found = false;
+      result.clear();
+    }
+    kind_t kind;
+    const tag_info *info; // 0 for non-FoLiA nodes
+    bool need;            // do we need the text of this element?
+    bool ignored;         // inside an Original, Suggestion etc.
+    bool space;
+    std::string id;
+    std::string original;
+    size_t children;
+    ElementType last_et;
+    bool last_structure;
+    bool last_space;
+    std::string first_delim;
+    std::string last_delim;
+    bool has_word;
+    bool last_word_space;
+    std::string text;     // the text of the structure children so far
+    std::string sep;      // the delimiter to add before the next part
+    std::string own;      // the text of the matching TextContent
+    bool has_own;
+    bool deletion;
+    std::string new_text;
+    std::string cur_text;
+    std::string org_text;
+    std::string org_own;
+    bool has_org_own;
+    std::vector<entry> entries;
+    bool found;
+    std::string result;
+  };
+
+  TextExtractor::TextExtractor():
+    /// default constructor
+    _reader(0),
+    _unit(Paragraph_t),
+    _has_ready(false),
+    _count(0)
+  {
+  }
+
+  TextExtractor::~TextExtractor(){
+    /// destructor
+    xmlFreeTextReader( _reader );
+    for ( const auto& f : _stack ){
+      delete f;
+    }
+    for ( const auto& f : _pool ){
+      delete f;
+    }
+    for ( const auto& it : _infos ){
+      delete it.second;
+    }
+  }
+
+  bool TextExtractor::init( const string& i,
+			    ElementType unit,
+			    const string& textclass ){
+    /// (re)initialize the TextExtractor
+    /*!
+      \param i the input file, or a buffer holding a complete document
+      \param unit the type of the elements to extract the text of
+      \param textclass the textclass to extract
+      \return true on success, throws when the input can't be opened
+    */
+    xmlFreeTextReader( _reader );
+    _reader = create_text_reader( i );
+    if ( _reader == 0 ){
+      throw( runtime_error( "folia::TextExtractor(), init failed on '" + i
+			    + "' (File not found)" ) );
+    }
+    for ( const auto& f : _stack ){
+      _pool.push_back( f );
+    }
+    _stack.clear();
+    _unit = unit;
+    _textclass = textclass;
+    _has_ready = false;
+    _count = 0;
+    return true;
+  }
+
+  const TextExtractor::tag_info *TextExtractor::info( const string& tag ){
+    /// return the text properties of a tag
+    /*!
+      \param tag the local name of a FoLiA element
+      \return the properties, or 0 for an unknown tag
+
+      A prototype element is created once per tag to find them.
+    */
+    const auto& it = _infos.find( tag );
+    if ( it != _infos.end() ){
+      return it->second;
+    }
+    tag_info *result = 0;
+    ElementType et = BASE;
+    try {
+      et = stringToElementType( tag );
+    }
+    catch ( const ValueError& ){
+      _infos[tag] = result;
+      return result;
+    }
+    FoliaElement *proto = AbstractElement::createElement( et );
+    result = new tag_info;
+    result->et = et;
+    result->printable = proto->printable();
+    result->hidden = proto->hidden();
+    result->structure = proto->isSubClass( AbstractStructureElement_t );
+    result->span = proto->isSubClass( AbstractSpanAnnotation_t );
+    result->textcontainer = proto->is_textcontainer();
+    result->space_att = ( SPACE & proto->optional_attributes() );
+    result->textdelimiter = proto->text_delimiter();
+    delete proto;
+    _infos[tag] = result;
+    return result;
+  }
+
+  TextExtractor::frame *TextExtractor::new_frame(){
+    /// return an unused frame, recycling old ones
+    if ( _pool.empty() ){
+      return new frame;
+    }
+    frame *result = _pool.back();
+    _pool.pop_back();
+    return result;
+  }
+
+  static string reader_attribute( xmlTextReader *reader, const char *att ){
+    /// return the value of attribute 'att' of the current element
+    xmlChar *val = xmlTextReaderGetAttribute( reader, (const xmlChar*)att );
+    string result;
+    if ( val ){
+      result = (const char*)val;
+      xmlFree( val );
+    }
+    return result;
+  }
+
+  void TextExtractor::open_element(){
+    /// push a frame for the current element of the reader
+    /*!
+      The kind of frame depends on the parent: only the children that
+      text() of the parent would use take part in the text extraction.
+      The rest is still traversed, to find the units inside.
+    */
+    frame *parent = _stack.empty() ? 0 : _stack.back();
+    const tag_info *inf = 0;
+    const xmlChar *ns = xmlTextReaderConstNamespaceUri( _reader );
+    if ( ( !parent || parent->info )
+	 && ( !ns || NSFOLIA == (const char*)ns ) ){
+      inf = info( (const char*)xmlTextReaderConstLocalName( _reader ) );
+    }
+    frame::kind_t kind = frame::IGNORE;
+    bool ignored = false;
+    if ( inf ){
+      if ( parent && parent->need ){
+	switch ( parent->kind ){
+	case frame::STRUCT:
+	  if ( inf->et == TextContent_t ){
+	    string cls = reader_attribute( _reader, "class" );
+	    if ( cls.empty() ){
+	      cls = "current";
+	    }
+	    if ( cls == _textclass ){
+	      kind = frame::CONTAINER;
+	    }
+	  }
+	  else if ( inf->printable && inf->et == Correction_t ){
+	    kind = frame::CORRECTION;
+	  }
+	  else if ( inf->printable && ( inf->structure || inf->span ) ){
+	    kind = frame::STRUCT;
+	  }
+	  break;
+	case frame::CORRECTION:
+	  if ( inf->et == New_t
+	       || inf->et == Original_t
+	       || inf->et == Current_t ){
+	    kind = frame::STRUCT;
+	  }
+	  break;
+	case frame::CONTAINER:
+	  if ( inf->printable ){
+	    kind = inf->textcontainer ? frame::CONTAINER : frame::STRUCT;
+	  }
+	  break;
+	default:
+	  break;
+	}
+      }
+      ignored = parent
+	&& ( parent->ignored
+	     || ( parent->info && default_ignore.count( parent->info->et ) ) );
+      if ( kind == frame::IGNORE && inf->et == _unit && !ignored ){
+	// nobody needs our text, but we are a unit ourselves
+	kind = ( inf->et == Correction_t ) ? frame::CORRECTION : frame::STRUCT;
+      }
+    }
+    bool need = ( kind != frame::IGNORE );
+    frame *f = new_frame();
+    f->reset( kind, inf, need );
+    f->ignored = ignored;
+    if ( inf && ( need || ( parent && parent->need ) ) ){
+      f->space = ( reader_attribute( _reader, "space" ) != "no" );
+      if ( inf->et == _unit ){
+	f->id = reader_attribute( _reader, "xml:id" );
+      }
+      if ( inf->et == TextMarkupCorrection_t ){
+	f->original = reader_attribute( _reader, "original" );
+      }
+    }
+    _stack.push_back( f );
+    if ( xmlTextReaderIsEmptyElement( _reader ) ){
+      close_element();
+    }
+  }
+
+  static void ltrim( string& s ){
+    /// remove leading whitespace (including newlines and tabs)
+    size_t pos = s.find_first_not_of( " \t\n\r" );
+    s.erase( 0, pos );
+  }
+
+  static void rtrim( string& s ){
+    /// remove trailing whitespace (including newlines and tabs)
+    size_t pos = s.find_last_not_of( " \t\n\r" );
+    s.erase( pos == string::npos ? 0 : pos + 1 );
+  }
+
+  static void trim_space( string& s ){
+    /// remove leading and trailing spaces. KEEP newlines etc.
+    size_t pos = s.find_last_not_of( ' ' );
+    s.erase( pos == string::npos ? 0 : pos + 1 );
+    s.erase( 0, s.find_first_not_of( ' ' ) );
+  }
+
+  void TextExtractor::close_element(){
+    /// pop the frame of the current element and compute its text
+    /*!
+      This mimics AbstractElement::private_try_text() and friends
+    */
+    frame *f = _stack.back();
+    _stack.pop_back();
+    if ( f->need ){
+      switch ( f->kind ){
+      case frame::STRUCT:
+	if ( f->info->et == Linebreak_t ){
+	  f->result = "\n";
+	}
+	else if ( f->info->et == Whitespace_t ){
+	  f->result = "\n\n";
+	}
+	else if ( f->info->printable && !f->info->hidden ){
+	  f->result = f->text;
+	  if ( f->result.empty() ){
+	    f->result = f->own;
+	  }
+	}
+	f->found = !f->result.empty();
+	break;
+      case frame::CORRECTION:
+	if ( f->deletion ){
+	  f->result = f->cur_text;
+	}
+	else if ( !f->new_text.empty() ){
+	  f->result = f->new_text;
+	}
+	else if ( !f->cur_text.empty() ){
+	  f->result = f->cur_text;
+	}
+	else {
+	  f->result = f->org_text;
+	}
+	f->found = !f->result.empty();
+	if ( !f->has_own && f->has_org_own ){
+	  f->own = f->org_own;
+	  f->has_own = true;
+	}
+	break;
+      case frame::CONTAINER:
+	if ( f->info->et == TextMarkupCorrection_t
+	     && _textclass == "original" ){
+	  f->result = f->original;
+	}
+	else {
+	  for ( size_t i=0; i < f->entries.size(); ++i ){
+	    frame::entry& e = f->entries[i];
+	    if ( e.is_text ){
+	      if ( i == 0 ){
+		ltrim( e.text );
+	      }
+	      if ( i == f->entries.size() - 1 ){
+		rtrim( e.text );
+	      }
+	      f->result += e.text;
+	    }
+	    else if ( e.printable ){
+	      if ( !f->result.empty() ){
+		f->result += e.delim;
+	      }
+	      f->result += e.text;
+	    }
+	  }
+	}
+	f->found = true;
+	break;
+      default:
+	break;
+      }
+    }
+    if ( !_stack.empty() && f->info ){
+      add_child( *_stack.back(), *f );
+    }
+    if ( f->info
+	 && f->info->et == _unit
+	 && !f->ignored
+	 && f->kind != frame::IGNORE
+	 && f->kind != frame::CONTAINER ){
+      _ready_id = f->id;
+      _ready_text = f->result;
+      _has_ready = true;
+    }
+    _pool.push_back( f );
+  }
+
+  const string& TextExtractor::delimiter( const frame& f ) const {
+    /// return the delimiter of a closed element
+    /*!
+      This mimics AbstractElement::get_delimiter() and its overrides
+    */
+    static const string EMPTY_STRING = "";
+    static const string SPACE_STRING = " ";
+    if ( !f.info ){
+      return EMPTY_STRING;
+    }
+    switch ( f.info->et ){
+    case Word_t:
+      return f.space ? f.info->textdelimiter : EMPTY_STRING;
+    case Quote_t:
+      if ( f.children == 0 ){
+	return SPACE_STRING;
+      }
+      return ( f.last_et == Sentence_t ) ? EMPTY_STRING : f.last_delim;
+    case Correction_t:
+      return ( f.children == 0 ) ? EMPTY_STRING : f.first_delim;
+    default:
+      break;
+    }
+    if ( ( f.info->space_att && !f.space )
+	 || ( f.last_structure && !f.last_space ) ){
+      return EMPTY_STRING;
+    }
+    if ( f.info->textdelimiter != "NONE" ){
+      return f.info->textdelimiter;
+    }
+    if ( f.last_structure ){
+      return f.last_delim;
+    }
+    return EMPTY_STRING;
+  }
+
+  void TextExtractor::add_child( frame& p, const frame& c ){
+    /// register the closed element c as the next child of p
+    if ( !p.need ){
+      return;
+    }
+    p.last_et = c.info->et;
+    p.last_structure = c.info->structure;
+    p.last_space = c.space;
+    p.last_delim = delimiter( c );
+    if ( p.children++ == 0 ){
+      p.first_delim = p.last_delim;
+    }
+    if ( c.info->et == Word_t ){
+      p.has_word = true;
+      p.last_word_space = c.space;
+    }
+    switch ( p.kind ){
+    case frame::STRUCT:
+      if ( c.kind == frame::CONTAINER ){
+	// a TextContent with the right class
+	if ( !p.has_own ){
+	  p.own = c.result;
+	  p.has_own = true;
+	}
+      }
+      else if ( c.kind == frame::CORRECTION && c.has_own && !p.has_own ){
+	// find_text_content() looks into corrections
+	p.own = c.own;
+	p.has_own = true;
+      }
+      if ( ( c.kind == frame::STRUCT || c.kind == frame::CORRECTION )
+	   && c.found ){
+	// mimic AbstractElement::try_deeptext()
+	string part = c.result;
+	trim_space( part );
+	size_t last = part.find_last_not_of( '\n' );
+	bool end_is_nl = ( part.empty() ? false : last != part.size() - 1 );
+	p.text += p.sep;
+	if ( end_is_nl && last == string::npos ){
+	  // only newline(s)
+	  trim_space( p.text );
+	}
+	p.text += part;
+	p.sep.clear();
+	if ( !end_is_nl ){
+	  if ( c.info->et == Sentence_t
+	       && c.has_word && !c.last_word_space ){
+	    // no space after the last word
+	  }
+	  else {
+	    p.sep = delimiter( c );
+	  }
+	}
+      }
+      break;
+    case frame::CORRECTION:
+      if ( c.info->et == New_t ){
+	if ( c.children == 0 ){
+	  p.deletion = true;
+	}
+	else if ( c.found ){
+	  p.new_text = c.result;
+	}
+      }
+      else if ( c.info->et == Original_t ){
+	if ( c.found ){
+	  p.org_text = c.result;
+	}
+      }
+      else if ( c.info->et == Current_t ){
+	if ( c.found ){
+	  p.cur_text = c.result;
+	}
+      }
+      if ( c.kind == frame::STRUCT
+	   && c.has_own
+	   && c.info->printable
+	   && !c.info->hidden ){
+	// mimic Correction::find_text_content()
+	if ( c.info->et == Original_t ){
+	  if ( !p.has_org_own ){
+	    p.org_own = c.own;
+	    p.has_org_own = true;
+	  }
+	}
+	else if ( !p.has_own ){
+	  p.own = c.own;
+	  p.has_own = true;
+	}
+      }
+      break;
+    case frame::CONTAINER: {
+      frame::entry e;
+      e.is_text = false;
+      e.printable = c.need;
+      if ( e.printable ){
+	e.text = c.result;
+	e.delim = delimiter( c );
+      }
+      p.entries.push_back( e );
+    }
+      break;
+    default:
+      break;
+    }
+  }
+
+  void TextExtractor::add_text(){
+    /// add the current text node of the reader to the open textcontainer
+    if ( _stack.empty() ){
+      return;
+    }
+    frame *f = _stack.back();
+    if ( !f->need || f->kind != frame::CONTAINER ){
+      return;
+    }
+    frame::entry e;
+    e.is_text = true;
+    e.printable = false;
+    const xmlChar *val = xmlTextReaderConstValue( _reader );
+    if ( val ){
+      e.text = (const char*)val;
+    }
+    for ( const auto& c : e.text ){
+      if ( (unsigned char)c >= 0x80 ){
+	// not plain ASCII, so NFC normalize, like XmlText::setvalue()
+	UnicodeString us = TiCC::UnicodeFromUTF8( e.text );
+	e.text = TiCC::UnicodeToUTF8( _nfc.normalize( us ) );
+	break;
+      }
+    }
+    ++f->children;
+    f->last_et = XmlText_t;
+    f->last_structure = false;
+    f->last_delim.clear();
+    f->entries.push_back( e );
+  }
+
+  void TextExtractor::add_comment(){
+    /// register an XML comment as a child of the open element
+    if ( _stack.empty() ){
+      return;
+    }
+    frame *f = _stack.back();
+    if ( !f->need ){
+      return;
+    }
+    f->last_et = XmlComment_t;
+    f->last_structure = false;
+    f->last_delim.clear();
+    if ( f->children++ == 0 ){
+      f->first_delim.clear();
+    }
+    if ( f->kind == frame::CONTAINER ){
+      frame::entry e;
+      e.is_text = false;
+      e.printable = false;
+      f->entries.push_back( e );
+    }
+  }
+
+  bool TextExtractor::next( string& id, string& text ){
+    /// get the text of the next unit
+    /*!
+      \param id the xml:id of the unit found
+      \param text the UTF8 text of the unit found. May be empty.
+      \return false when no more units are available. Throws an XmlError
+      when the input is not well-formed.
+
+      The units are returned in the order of their closing tags. So nested
+      units (like a Division inside a Division) come before the enclosing
+      one.
+    */
+    while ( !_has_ready && _reader ){
+      int ret = xmlTextReaderRead( _reader );
+      if ( ret != 1 ){
+	xmlFreeTextReader( _reader );
+	_reader = 0;
+	if ( ret < 0 ){
+	  throw XmlError( "TextExtractor: the input is not well-formed XML" );
+	}
+	break;
+      }
+      switch ( xmlTextReaderNodeType( _reader ) ){
+      case XML_READER_TYPE_ELEMENT:
+	open_element();
+	break;
+      case XML_READER_TYPE_END_ELEMENT:
+	close_element();
+	break;
+      case XML_READER_TYPE_TEXT:
+      case XML_READER_TYPE_WHITESPACE:
+      case XML_READER_TYPE_SIGNIFICANT_WHITESPACE:
+	add_text();
+	break;
+      case XML_READER_TYPE_COMMENT:
+	add_comment();
+	break;
+      default:
+	break;
+      }
+    }
+    if ( !_has_ready ){
+      return false;
+    }
+    id = _ready_id;
+    text = _ready_text;
+    _has_ready = false;
+    ++_count;
+    return true;
+  }
+
 } // namespace folia
@@ -0,0 +1,381 @@
+/*
+  Copyright (c) 2006 - 2021
+  CLST  - Radboud University
+  ILK   - Tilburg University
+
+  This file is part of libfolia
+
+  libfolia is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  libfolia is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, see <http://www.gnu.org/licenses/>.
+
+  For questions and suggestions, see:
+      https://github.com/LanguageMachines/ticcutils/issues
+  or send mail to:
+      lamasoftware (at ) science.ru.nl
+*/
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "ticcutils/StringOps.h"
+#include "libfolia/folia.h"
+
+using namespace std;
+
+namespace folia {
+
+  TokenExporter::TokenExporter( format f ):
+    /// create an exporter for format f
+    _format(f),
+    _textclass("current"),
+    _sentences(0)
+  {
+  }
+
+  static void put_field( ostream& os, const string& value ){
+    /// write value as a column value
+    /*!
+      an empty value is written as '_'. Tabs and newlines are replaced by
+      spaces, so they can't break the columns
+    */
+    if ( value.empty() ){
+      os << '_';
+      return;
+    }
+    if ( value.find_first_of( "\t\n\r" ) == string::npos ){
+      os << value;
+      return;
+    }
+    string tmp = value;
+    for ( auto& c : tmp ){
+      if ( c == '\t' || c == '\n' || c == '\r' ){
+	c = ' ';
+      }
+    }
+    os << tmp;
+  }
+
+  static void put_class( ostream& os, const FoliaElement *annotation ){
+    /// write the class of an annotation, or '_' when there is none
+    if ( annotation ){
+      put_field( os, annotation->cls() );
+    }
+    else {
+      os << '_';
+    }
+  }
+
+  static void get_feats( const FoliaElement *annotation,
+			 vector<pair<string,string>>& feats ){
+    /// collect the subset/class pairs of the Features of an annotation
+    if ( annotation ){
+      for ( const auto& child : annotation->data() ){
+	if ( child->isSubClass( Feature_t )
+	     && !child->cls().empty() ){
+	  feats.push_back( make_pair( child->subset(), child->cls() ) );
+	}
+      }
+    }
+  }
+
+  static void put_feats( ostream& os,
+			 const FoliaElement *upos,
+			 const FoliaElement *xpos ){
+    /// write the morphological features of a Word in CoNLL-U FEATS notation
+    /*!
+      \param os the output stream
+      \param upos the UPOS annotation. May be 0
+      \param xpos the XPOS annotation. May be 0
+      The Features of upos are used, or those of xpos when upos has none.
+      They are sorted case insensitive on their subset, values of the same
+      subset are joined with a ','. Writes '_' when there are no features.
+    */
+    vector<pair<string,string>> feats;
+    get_feats( upos, feats );
+    if ( feats.empty() ){
+      get_feats( xpos, feats );
+    }
+    if ( feats.empty() ){
+      os << '_';
+      return;
+    }
+    sort( feats.begin(), feats.end(),
+	  []( const pair<string,string>& a, const pair<string,string>& b ){
+	    string la = TiCC::lowercase( a.first );
+	    string lb = TiCC::lowercase( b.first );
+	    if ( la != lb ){
+	      return la < lb;
+	    }
+	    return a.second < b.second;
+	  } );
+    string result;
+    for ( size_t i=0; i < feats.size(); ++i ){
+      if ( i > 0 && feats[i].first == feats[i-1].first ){
+	result += "," + feats[i].second;
+      }
+      else {
+	if ( i > 0 ){
+	  result += "|";
+	}
+	result += feats[i].first + "=" + feats[i].second;
+      }
+    }
+    put_field( os, result );
+  }
+
+  void TokenExporter::add_word( const FoliaElement *w ){
+    /// add a Word to the current sentence, with its annotations
+    /*!
+      \param w the Word
+      The children of w are visited once, taking the first matching pos
+      and lemma annotations.
+    */
+    token t = { w, 0, 0, 0, 0, "", false };
+    for ( const auto& child : w->data() ){
+      switch ( child->element_id() ){
+      case PosAnnotation_t: {
+	const string st = child->sett();
+	if ( !_xpos_set.empty() && st == _xpos_set ){
+	  if ( !t.xpos ){
+	    t.xpos = child;
+	  }
+	}
+	else if ( !t.upos
+		  && ( _upos_set.empty() || st == _upos_set ) ){
+	  t.upos = child;
+	}
+	break;
+      }
+      case LemmaAnnotation_t:
+	if ( !t.lemma
+	     && ( _lemma_set.empty() || child->sett() == _lemma_set ) ){
+	  t.lemma = child;
+	}
+	break;
+      default:
+	break;
+      }
+    }
+    _tokens.push_back( t );
+    _positions[w] = _tokens.size();
+  }
+
+  void TokenExporter::add_dependencies( const FoliaElement *layer ){
+    /// remember the Dependencies of the requested set in a layer
+    for ( const auto& child : layer->data() ){
+      if ( child->element_id() == Dependency_t
+	   && ( _dep_set.empty() || child->sett() == _dep_set ) ){
+	_dependencies.push_back( child );
+      }
+    }
+  }
+
+  void TokenExporter::collect( const FoliaElement *node ){
+    /// collect the Words and Dependencies below node
+    /*!
+      \param node the node to walk
+
+      Only the children node owns are visited, so the Words referred to
+      from span annotations are not seen twice. Like select(), the
+      default_ignore elements are skipped.
+    */
+    for ( const auto& child : node->data() ){
+      if ( child->parent() != node ){
+	// a reference
+	continue;
+      }
+      ElementType et = child->element_id();
+      if ( et == Word_t ){
+	add_word( child );
+      }
+      else if ( et == DependenciesLayer_t ){
+	add_dependencies( child );
+      }
+      else if ( child->size() > 0
+		&& default_ignore.find( et ) == default_ignore.end()
+		&& !child->isSubClass( AbstractAnnotationLayer_t ) ){
+	collect( child );
+      }
+    }
+  }
+
+  size_t TokenExporter::export_sentence( ostream& os,
+					 const FoliaElement *s ){
+    /// export one sentence
+    /*!
+      \param os the output stream
+      \param s the Sentence
+      \return the number of Words written
+    */
+    _tokens.clear();
+    _positions.clear();
+    _dependencies.clear();
+    collect( s );
+    for ( const auto& dep : _dependencies ){
+      const FoliaElement *head = 0;
+      vector<FoliaElement*> dependents;
+      for ( const auto& role : dep->data() ){
+	if ( role->element_id() == Headspan_t ){
+	  head = role->wrefs( 0 );
+	}
+	else if ( role->element_id() == DependencyDependent_t ){
+	  dependents = role->wrefs();
+	}
+      }
+      size_t head_pos = 0; // a Dependency without a head marks the root
+      if ( head ){
+	const auto& hit = _positions.find( head );
+	if ( hit == _positions.end() ){
+	  continue;
+	}
+	head_pos = hit->second;
+      }
+      for ( const auto& d : dependents ){
+	const auto& dit = _positions.find( d );
+	if ( dit != _positions.end() ){
+	  token& t = _tokens[dit->second-1];
+	  t.head = head_pos;
+	  t.deprel = dep->cls();
+	  if ( head_pos == 0 && t.deprel.empty() ){
+	    t.deprel = "root";
+	  }
+	  t.attached = true;
+	}
+      }
+    }
+    if ( _format == TSV ){
+      if ( _sentences == 0 ){
+	os << "sentence\tid\tform\tlemma\tupos\txpos\tfeats\thead\tdeprel\n";
+      }
+    }
+    else {
+      if ( !s->id().empty() ){
+	os << "# sent_id = " << s->id() << "\n";
+      }
+      const string text = s->str( _textclass );
+      if ( !text.empty() ){
+	os << "# text = ";
+	put_field( os, text );
+	os << "\n";
+      }
+    }
+    for ( size_t i=0; i < _tokens.size(); ++i ){
+      const token& t = _tokens[i];
+      if ( _format == TSV ){
+	put_field( os, s->id() );
+	os << '\t';
+	put_field( os, t.word->id() );
+	os << '\t';
+      }
+      else {
+	os << i+1 << '\t';
+      }
+      const string *form = t.word->text_view( _textclass );
+      if ( form ){
+	put_field( os, *form );
+      }
+      else {
+	put_field( os, t.word->str( _textclass ) );
+      }
+      os << '\t';
+      put_class( os, t.lemma );
+      os << '\t';
+      put_class( os, t.upos );
+      os << '\t';
+      put_class( os, t.xpos );
+      os << '\t';
+      put_feats( os, t.upos, t.xpos );
+      os << '\t';
+      if ( t.attached ){
+	os << t.head << '\t';
+	put_field( os, t.deprel );
+      }
+      else {
+	os << "_\t_";
+      }
+      if ( _format == CONLLU ){
+	os << "\t_\t";
+	if ( !t.word->space() ){
+	  os << "SpaceAfter=No";
+	}
+	else {
+	  os << '_';
+	}
+      }
+      os << '\n';
+    }
+    if ( _format == CONLLU ){
+      os << '\n';
+    }
+    ++_sentences;
+    return _tokens.size();
+  }
+
+  static size_t export_tree( TokenExporter& exporter,
+			     ostream& os,
+			     const FoliaElement *node ){
+    /// export all top level Sentences below node
+    size_t result = 0;
+    for ( const auto& child : node->data() ){
+      if ( child->parent() != node ){
+	continue;
+      }
+      ElementType et = child->element_id();
+      if ( et == Sentence_t ){
+	result += exporter.export_sentence( os, child );
+      }
+      else if ( et != Word_t
+		&& child->size() > 0
+		&& default_ignore.find( et ) == default_ignore.end()
+		&& !child->isSubClass( AbstractAnnotationLayer_t )
+		&& !child->isSubClass( AbstractInlineAnnotation_t ) ){
+	result += export_tree( exporter, os, child );
+      }
+    }
+    return result;
+  }
+
+  size_t TokenExporter::export_document( ostream& os,
+					 const Document& doc ){
+    /// export all Sentences of a Document
+    /*!
+      \param os the output stream
+      \param doc the Document
+      \return the number of Words written
+    */
+    if ( !doc.doc() ){
+      return 0;
+    }
+    return export_tree( *this, os, doc.doc() );
+  }
+
+  size_t TokenExporter::export_engine( ostream& os, Engine& engine ){
+    /// export all Sentences delivered by an Engine
+    /*!
+      \param os the output stream
+      \param engine an initialized Engine, without an output file
+      \return the number of Words written
+
+      Every Sentence is exported as soon as the Engine returns it, so the
+      output starts before the whole input is read.
+    */
+    size_t result = 0;
+    const string tag = toString( Sentence_t );
+    FoliaElement *s;
+    while ( (s = engine.get_node( tag )) ){
+      result += export_sentence( os, s );
+    }
+    return result;
+  }
+
+} // namespace folia
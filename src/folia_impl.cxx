@@ -37,6 +37,8 @@
 #include <algorithm>
 #include <type_traits>
 #include <stdexcept>
+#include <thread>
+#include <mutex>
 #include "ticcutils/PrettyPrint.h"
 #include "ticcutils/StringOps.h"
 #include "ticcutils/XMLtools.h"
@@ -85,6 +87,15 @@ namespace folia {
     return _props.HIDDEN;
   }
 
+  const string& AbstractElement::text_delimiter() const {
+    /// return the TEXTDELIMITER property
+    /*!
+      This is "NONE" when the element type has no delimiter of its own.
+      Use get_delimiter() for the delimiter that text() actually uses.
+    */
+    return _props.TEXTDELIMITER;
+  }
+
   const string& AbstractElement::xmltag() const {
     /// return the XMLTAG property
     /*
@@ -236,6 +247,14 @@ namespace folia {
      * \param p a properties block (required)
      * \param d a parent document
      */
+    _text_cache(0),
+    _text_generation(0),
+    _checked_parent(0),
+    _checked_generation(0),
+    _source_begin(0),
+    _source_end(0),
+    _modifications(0),
+    _source_generation(0),
     _mydoc(d),
     _parent(0),
     _auth( p.AUTH ),
@@ -249,6 +268,7 @@ namespace folia {
 
   AbstractElement::~AbstractElement( ) {
     /// Destructor for AbstractElements.
+    delete _text_cache;
     bool debug = false;
     // if ( xmltag() == "w"
     // 	 || xmltag() == "s"
@@ -458,6 +478,7 @@ namespace folia {
      *     - if the object provided value is valid
      *     - if the attribute is declared for the annotation-type
      */
+    invalidate_text_cache(); // class, textclass or space may change
     Attrib supported = required_attributes() | optional_attributes();
     //#define LOG_SET_ATT
 #ifdef LOG_SET_ATT
@@ -1224,86 +1245,123 @@ namespace folia {
     }
   }
 
+  bool AbstractElement::parent_text_matches( bool trim_spaces,
+					     UnicodeString& s1,
+					     UnicodeString& s2 ) const {
+    /// compare our text with the text of our parent
+    /*!
+     * \param trim_spaces when false, use the older (<v2.4.1) rules
+     * \param s1 returns the text of the parent
+     * \param s2 returns our own text
+     * \return true when the texts match, or when there is nothing to compare
+     *
+     * For Word and String children, we only assume that their text is
+     * embedded in the parents text.
+     *
+     * For all other cases, the text should exactly match the parents text.
+     * \note Matching is opaque to spaces, newlines and tabs
+     */
+    string cls = this->cls();
+    FoliaElement *parent = this->parent();
+    if ( !parent
+	 || parent->element_id() == Correction_t
+	 || !parent->hastext( cls ) ){
+      // only check text consistency for parents with text
+      // but SKIP Corrections
+      return true;
+    }
+    TEXT_FLAGS flags = TEXT_FLAGS::STRICT;
+    if ( !trim_spaces ) {
+      flags |= TEXT_FLAGS::NO_TRIM_SPACES;
+    }
+    s1 = parent->text( cls, flags);
+    flags = TEXT_FLAGS::NONE;
+    if ( !trim_spaces ) {
+      flags |= TEXT_FLAGS::NO_TRIM_SPACES;
+    }
+    s2 = this->text( cls, flags );
+    // no retain tokenization, strict for parent, deeper for child
+    s1 = normalize_spaces( s1 );
+    s2 = normalize_spaces( s2 );
+    if ( isSubClass( Word_t )
+	 || isSubClass( String_t )
+	 || isSubClass( AbstractTextMarkup_t ) ) {
+      // Words, Strings and AbstractTextMarkup are 'per definition' PART of
+      // their text parents
+      return s1.indexOf( s2 ) >= 0; // aren't they?
+    }
+    // otherwise an exacte match is needed
+    return s1 == s2;
+  }
+
   void AbstractElement::check_text_consistency( bool trim_spaces ) const {
     /// check the text consistency of the combined text of the children
     /// against the text of the Element.
     /*!
      * When a document is available AND it has the checktext() property
      * the combined text of ALL the children is checked against the text of
-     * the parent.
+     * the parent. See parent_text_matches()
      *
      * will throw on error
-     *
-     * For Word and String children, we only assume that their text is
-     * embedded in the parents text.
-     *
-     * For all other cases, the text should exactly match the parents text.
-     * \note Matching is opaque to spaces, newlines and tabs
      */
     if ( !doc() || !doc()->checktext() || !printable() ){
       return;
     }
-
-    string cls = this->cls();
-    FoliaElement *parent = this->parent();
-    if ( parent
-	 && parent->element_id() != Correction_t
-	 && parent->hastext( cls ) ){
-      // check text consistency for parents with text
-      // but SKIP Corrections
-      TEXT_FLAGS flags = TEXT_FLAGS::STRICT;
-      if ( !trim_spaces ) {
-	flags |= TEXT_FLAGS::NO_TRIM_SPACES;
-      }
-      UnicodeString s1 = parent->text( cls, flags);
-      flags = TEXT_FLAGS::NONE;
-      if ( !trim_spaces ) {
-	flags |= TEXT_FLAGS::NO_TRIM_SPACES;
-      }
-      UnicodeString s2 = this->text( cls, flags );
-      // no retain tokenization, strict for parent, deeper for child
-      s1 = normalize_spaces( s1 );
-      s2 = normalize_spaces( s2 );
-      bool test_fail;
-      if ( isSubClass( Word_t )
-	   || isSubClass( String_t )
-	   || isSubClass( AbstractTextMarkup_t ) ) {
-	// Words, Strings and AbstractTextMarkup are 'per definition' PART of
-	// their text parents
-	test_fail = ( s1.indexOf( s2 ) < 0 ); // aren't they?
-      }
-      else {
-	// otherwise an exacte match is needed
-	test_fail = ( s1 != s2 );
-      }
-      if ( test_fail ){
-        bool warn_only = false;
-        if ( trim_spaces ) {
-	  //ok, we failed according to the >v2.4.1 rules
-	  //but do we also fail under the old rules?
-	  try {
-	    this->check_text_consistency(false);
-	    warn_only = true;
-	  } catch ( const InconsistentText& ) {
-	    //ignore, we raise the newer error
-	  }
-        }
-	string msg = "text (class="
-	  + cls + ") from node: " + xmltag()
-	  + "(" + id() + ")"
-	  + " with value\n'" + TiCC::UnicodeToUTF8(s2)
-	  + "'\n to element: " + parent->xmltag() +
-	  + "(" + parent->id() + ") which already has "
-	  + "text in that class and value: \n'"
-	  + TiCC::UnicodeToUTF8(s1) + "'\n";
-        if (warn_only) {
-	  msg += "However, according to the older rules (<v2.4.1) the text is consistent. So we are treating this as a warning rather than an error. We do recommend fixing this if this is a document you intend to publish.\n";
-	  cerr << "WARNING: inconsistent text: " << msg << endl;
-        }
-	else {
-	  throw InconsistentText(msg);
-        }
+    if ( trim_spaces && text_checked() ){
+      // validated before, and unmodified since
+      return;
+    }
+    UnicodeString s1;
+    UnicodeString s2;
+    if ( parent_text_matches( trim_spaces, s1, s2 ) ){
+      if ( trim_spaces ){
+	mark_text_checked();
       }
+      return;
+    }
+    bool warn_only = false;
+    if ( trim_spaces ) {
+      //ok, we failed according to the >v2.4.1 rules
+      //but do we also fail under the old rules?
+      try {
+	this->check_text_consistency(false);
+	warn_only = true;
+      } catch ( const InconsistentText& ) {
+	//ignore, we raise the newer error
+      }
+    }
+    string msg = "text (class="
+      + cls() + ") from node: " + xmltag()
+      + "(" + id() + ")"
+      + " with value\n'" + TiCC::UnicodeToUTF8(s2)
+      + "'\n to element: " + parent()->xmltag() +
+      + "(" + parent()->id() + ") which already has "
+      + "text in that class and value: \n'"
+      + TiCC::UnicodeToUTF8(s1) + "'\n";
+    if (warn_only) {
+      msg += "However, according to the older rules (<v2.4.1) the text is consistent. So we are treating this as a warning rather than an error. We do recommend fixing this if this is a document you intend to publish.\n";
+      cerr << "WARNING: inconsistent text: " << msg << endl;
+    }
+    else {
+      throw InconsistentText(msg);
+    }
+  }
+
+  void AbstractElement::precheck_text_consistency() const {
+    /// do the check_text_consistency() test, but only remember a success
+    /*!
+     * Used after parsing, when our text and the text of our parent are still
+     * in the text cache. When our text is consistent, the check is skipped
+     * on output. Otherwise nothing is reported here: check_text_consistency()
+     * will do that on output, like before.
+     */
+    if ( !doc() || !doc()->checktext() || !printable() || text_checked() ){
+      return;
+    }
+    UnicodeString s1;
+    UnicodeString s2;
+    if ( parent_text_matches( true, s1, s2 ) ){
+      mark_text_checked();
     }
   }
 
@@ -1400,16 +1458,14 @@ namespace folia {
 #endif
   }
 
-  xmlNode *AbstractElement::xml( bool recursive, bool kanon ) const {
-    /// convert an Element to an xmlNode
+  KWargs AbstractElement::xml_attributes( set<FoliaElement*>& attribute_elements ) const {
+    /// collect the attributes for the XML output of an Element
     /*!
-     * \param recursive Convert the children too, creating a xmlNode tree
-     * \param kanon Output in a canonical form to make comparions easy
-     * \return am xmlNode object(-tree)
+     * \param attribute_elements returns the children that are represented as
+     * attributes, and so are excluded from the 'normal' output
+     * \return the attributes
      */
-    xmlNode *e = XmlNewNode( foliaNs(), xmltag() );
     KWargs attribs = collectAttributes();
-    set<FoliaElement *> attribute_elements;
     // nodes that can be represented as attributes are converted to atributes
     // and excluded of 'normal' output.
 
@@ -1432,70 +1488,190 @@ namespace folia {
 	}
       }
     }
-    addAttributes( e, attribs );
-    if ( _data.empty() ){
-      return e; // we are done
-    }
-    if ( recursive ) {
-      // append children:
-      // we want make sure that text elements are in the right order,
-      // in front and the 'current' class first
-      list<FoliaElement *> currenttextelements;
-      list<FoliaElement *> textelements;
-      list<FoliaElement *> otherelements;
-      list<FoliaElement *> commentelements;
-      multimap<ElementType, FoliaElement *, std::greater<ElementType>> otherelementsMap;
-      for ( const auto& el : _data ) {
-	if ( attribute_elements.find(el) == attribute_elements.end() ) {
-	  if ( el->isinstance(TextContent_t) ) {
-	    if ( el->cls() == "current" ) {
-	      currenttextelements.push_back( el );
-	    }
-	    else {
-	      textelements.push_back( el );
-	    }
+    return attribs;
+  }
+
+  vector<FoliaElement*> AbstractElement::xml_children( const set<FoliaElement*>& attribute_elements,
+						       bool kanon ) const {
+    /// return the children of an Element in XML output order
+    /*!
+     * \param attribute_elements the children that are output as attributes
+     * \param kanon Output in a canonical form to make comparions easy
+     * \return the children to output, in order
+     */
+    // we want make sure that text elements are in the right order,
+    // in front and the 'current' class first
+    list<FoliaElement *> currenttextelements;
+    list<FoliaElement *> textelements;
+    list<FoliaElement *> otherelements;
+    list<FoliaElement *> commentelements;
+    multimap<ElementType, FoliaElement *, std::greater<ElementType>> otherelementsMap;
+    for ( const auto& el : _data ) {
+      if ( attribute_elements.find(el) == attribute_elements.end() ) {
+	if ( el->isinstance(TextContent_t) ) {
+	  if ( el->cls() == "current" ) {
+	    currenttextelements.push_back( el );
+	  }
+	  else {
+	    textelements.push_back( el );
+	  }
+	}
+	else {
+	  if ( kanon ) {
+	    otherelementsMap.insert( make_pair( el->element_id(), el ) );
 	  }
 	  else {
-	    if ( kanon ) {
-	      otherelementsMap.insert( make_pair( el->element_id(), el ) );
+	    if ( el->isinstance(XmlComment_t)
+		 && currenttextelements.empty()
+		 && textelements.empty() ) {
+	      commentelements.push_back( el );
 	    }
 	    else {
-	      if ( el->isinstance(XmlComment_t)
-		   && currenttextelements.empty()
-		   && textelements.empty() ) {
-		commentelements.push_back( el );
-	      }
-	      else {
-		otherelements.push_back( el );
-	      }
+	      otherelements.push_back( el );
 	    }
 	  }
 	}
       }
-      for ( const auto& cel : commentelements ) {
-	xmlAddChild( e, cel->xml( recursive, kanon ) );
+    }
+    vector<FoliaElement*> result;
+    result.reserve( _data.size() );
+    result.insert( result.end(),
+		   commentelements.begin(), commentelements.end() );
+    result.insert( result.end(),
+		   currenttextelements.begin(), currenttextelements.end() );
+    result.insert( result.end(),
+		   textelements.begin(), textelements.end() );
+    if ( !kanon ) {
+      result.insert( result.end(),
+		     otherelements.begin(), otherelements.end() );
+    }
+    else {
+      for ( const auto& oem : otherelementsMap ) {
+	result.push_back( oem.second );
       }
-      for ( const auto& tel : currenttextelements ) {
-	xmlAddChild( e, tel->xml( recursive, false ) );
+    }
+    return result;
+  }
+
+  xmlNode *AbstractElement::xml( bool recursive, bool kanon ) const {
+    /// convert an Element to an xmlNode
+    /*!
+     * \param recursive Convert the children too, creating a xmlNode tree
+     * \param kanon Output in a canonical form to make comparions easy
+     * \return am xmlNode object(-tree)
+     */
+    xmlNode *e = XmlNewNode( foliaNs(), xmltag() );
+    set<FoliaElement *> attribute_elements;
+    addAttributes( e, xml_attributes( attribute_elements ) );
+    if ( _data.empty() ){
+      return e; // we are done
+    }
+    if ( recursive ) {
+      // append children:
+      for ( const auto& el : xml_children( attribute_elements, kanon ) ) {
 	// don't change the internal sequences of TextContent elements
+	xmlAddChild( e, el->xml( recursive,
+				 kanon && !el->isinstance(TextContent_t) ) );
       }
-      for ( const auto& tel : textelements ) {
-	xmlAddChild( e, tel->xml( recursive, false ) );
-	// don't change the internal sequences of TextContent elements
+      check_text_consistency();
+    }
+    return e;
+  }
+
+  static XmlWriter::content_kind xml_content_kind( const vector<FoliaElement*>& children ){
+    /// determine how the XmlWriter should format these children
+    if ( children.empty() ){
+      return XmlWriter::EMPTY;
+    }
+    for ( const auto& el : children ){
+      if ( el->isinstance( XmlText_t ) ){
+	return XmlWriter::MIXED;
       }
-      if ( !kanon ) {
-	for ( const auto& oem : otherelements ) {
-	  xmlAddChild( e, oem->xml( recursive, kanon ) );
-	}
+    }
+    return XmlWriter::ELEMENTS;
+  }
+
+  static void write_xml_children( XmlWriter& w,
+				  const vector<FoliaElement*>& children,
+				  bool kanon ){
+    /// write the children of an Element, concurrently when w asks for it
+    /*!
+     * \param w the XmlWriter to use
+     * \param children the children to write
+     * \param kanon Output in a canonical form
+     *
+     * When w.threads() != 1, every child is rendered into a separate
+     * fragment in a pool of threads. The fragments are appended to w in
+     * document order, so the result is the same as sequential output.
+     * To bound the memory use, this is done in batches of a few children
+     * per thread.
+     * Only the first level with more than 1 child is split this way, the
+     * fragment writers themselves are sequential.
+     */
+    if ( w.threads() == 1
+	 || children.size() < 2 ){
+      for ( const auto& el : children ) {
+	el->write_xml( w, kanon && !el->isinstance(TextContent_t) );
       }
-      else {
-	for ( const auto& oem : otherelementsMap ) {
-	  xmlAddChild( e, oem.second->xml( recursive, kanon ) );
-	}
+      return;
+    }
+    unsigned int threads = w.threads();
+    if ( threads == 0 ){
+      threads = max( 1u, thread::hardware_concurrency() );
+    }
+    const size_t batch_size = 8 * threads;
+    vector<string> fragments;
+    for ( size_t start = 0; start < children.size(); start += batch_size ){
+      size_t len = min( batch_size, children.size() - start );
+      fragments.assign( len, string() );
+      parallel_for( len,
+		    [&]( size_t i ){
+		      XmlWriter fw( fragments[i], w );
+		      const FoliaElement *el = children[start+i];
+		      el->write_xml( fw,
+				     kanon && !el->isinstance(TextContent_t) );
+		    },
+		    threads );
+      for ( const auto& frag : fragments ){
+	w.append( frag );
+      }
+    }
+  }
+
+  void AbstractElement::write_xml( XmlWriter& w, bool kanon ) const {
+    /// write an Element and all its children as XML text
+    /*!
+     * \param w the XmlWriter to use
+     * \param kanon Output in a canonical form to make comparions easy
+     *
+     * The output is the same as for xml() but without building an xmlNode
+     * tree first.
+     * When w has a source and we are unmodified since we were parsed from
+     * it, our source is copied instead.
+     */
+    if ( _source_end > 0
+	 && w.source()
+	 && _source_generation == _modifications ){
+      w.splice( _source_begin, _source_end );
+      if ( !_data.empty() ){
+	check_text_consistency();
       }
+      return;
+    }
+    set<FoliaElement *> attribute_elements;
+    KWargs attribs = xml_attributes( attribute_elements );
+    vector<FoliaElement*> children;
+    if ( !_data.empty() ){
+      children = xml_children( attribute_elements, kanon );
+    }
+    w.start_element( xmltag(), attribs, xml_content_kind( children ) );
+    if ( !children.empty() ){
+      write_xml_children( w, children, kanon );
+      w.end_element();
+    }
+    if ( !_data.empty() ){
       check_text_consistency();
     }
-    return e;
   }
 
   const string AbstractElement::str( const string& cls ) const {
@@ -1512,17 +1688,16 @@ namespace folia {
      *
      * otherwise return the empty string
      */
-    UnicodeString us;
-    try {
-      us = text(cls);
+    const string *view = text_view( cls );
+    if ( view ){
+      // the common case: a plain token. No conversions needed
+      return *view;
     }
-    catch( const NoSuchText& ){
-      try {
-	us = phon(cls);
-      }
-      catch( const NoSuchPhon&){
-	// No TextContent or Phone is allowed
-      }
+    UnicodeString us;
+    if ( !try_text( us, cls )
+	 && !try_phon( us, cls ) ){
+      // No TextContent or Phone is allowed
+      us.remove();
     }
     return TiCC::UnicodeToUTF8( us );
   }
@@ -1586,12 +1761,7 @@ namespace folia {
      * \param cls The desired textclass
      * \return true if there is a TextContent available. Otherwise false
      */
-    try {
-      this->text_content(cls);
-      return true;
-    } catch ( const NoSuchText& e ) {
-      return false;
-    }
+    return this->find_text_content( cls ) != 0;
   }
 
   bool FoliaElement::hasphon( const string& cls ) const {
@@ -1600,12 +1770,7 @@ namespace folia {
      * \param cls The desired textclass
      * \return true if there is a PhonContent available. Otherwise false
      */
-    try {
-      this->phon_content(cls);
-      return true;
-    } catch ( const NoSuchPhon& e ) {
-      return false;
-    }
+    return this->find_phon_content( cls ) != 0;
   }
 
   //#define DEBUG_TEXT
@@ -1665,22 +1830,23 @@ namespace folia {
     return EMPTY_STRING;
   }
 
-  const UnicodeString AbstractElement::private_text( const string& cls,
-						     bool retaintok,
-						     bool strict,
-						     bool show_hidden,
-                                                     bool trim_spaces ) const {
+  bool AbstractElement::private_try_text( UnicodeString& result,
+					  const string& cls,
+					  bool retaintok,
+					  bool strict,
+					  bool show_hidden,
+					  bool trim_spaces ) const {
 
-    /// get the UnicodeString value of an element
+    /// get the UnicodeString value of an element, without throwing
     /*!
+     * \param result the Unicode String representation found
      * \param cls The textclass we are looking for
      * \param retaintok retain the tokenisation information
      * \param strict If true, return the text of this level only
      * when false, allow recursing into children
      * \param show_hidden include text form 'hidden' nodes too.
      * \param trim_spaces Trim leading and trailing spaces (defaults to True since FoLiA v2.4.1)
-     * \return the Unicode String representation found. Throws when
-     * no text can be found
+     * \return true when text is found, false otherwise.
      */
 #ifdef DEBUG_TEXT
     cerr << "TEXT(" << cls << ") on node : " << xmltag() << " id="
@@ -1690,8 +1856,11 @@ namespace folia {
 	 << (show_hidden?"show_hidden":"hide hidden") << "\t"
 	 << (trim_spaces?"trimming spaces":"not trimming spaces") << "\t" << endl;
 #endif
+    result.remove();
     if ( strict ) {
-      return text_content(cls,show_hidden)->text(cls, !trim_spaces ? TEXT_FLAGS::NO_TRIM_SPACES : TEXT_FLAGS::NONE);
+      const TextContent *tc = find_text_content( cls, show_hidden );
+      return tc
+	&& tc->try_text( result, cls, !trim_spaces ? TEXT_FLAGS::NO_TRIM_SPACES : TEXT_FLAGS::NONE );
     }
     else if ( is_textcontainer() ){
 #ifdef DEBUG_TEXT
@@ -1704,23 +1873,26 @@ namespace folia {
 	cerr << "TextContent shortcut, class=" << this->cls()
 	     << " but looking for: " << cls << endl;
 #endif
-	return "";
+	return true;
       }
 #ifdef DEBUG_TEXT
       cerr << "Get the text from the children." << endl;
 #endif
-      UnicodeString result;
       unsigned int i = 0;
+      UnicodeString tmp;
       for ( const auto& d : _data ){
         if (d->isinstance( XmlText_t)) {
+	  if ( !d->try_text( tmp, cls ) ){
+	    return false;
+	  }
 	  if ((trim_spaces) && (i == 0) && (i == _data.size() -1)) {
-	    result += rtrim(ltrim(d->text( cls )));
+	    result += rtrim(ltrim(tmp));
 	  } else if ((trim_spaces) && (i == 0)) {
-	    result += ltrim(d->text( cls ));
+	    result += ltrim(tmp);
 	  } else if ((trim_spaces) && (i == _data.size() - 1)) {
-	    result += rtrim(d->text( cls ));
+	    result += rtrim(tmp);
 	  } else {
-	    result += d->text( cls );
+	    result += tmp;
 	  }
         }
 	else if ( d->printable() ){
@@ -1731,7 +1903,10 @@ namespace folia {
 #endif
 	    result += TiCC::UnicodeFromUTF8(delim);
 	  }
-          result += d->text( cls, !trim_spaces ? TEXT_FLAGS::NO_TRIM_SPACES : TEXT_FLAGS::NONE  );
+	  if ( !d->try_text( tmp, cls, !trim_spaces ? TEXT_FLAGS::NO_TRIM_SPACES : TEXT_FLAGS::NONE ) ){
+	    return false;
+	  }
+          result += tmp;
 	}
         ++i;
       }
@@ -1739,10 +1914,10 @@ namespace folia {
       cerr << "TEXT(" << cls << ") on a textcontainer :" << xmltag()
 	   << " returned '" << result << "'" << endl;
 #endif
-      return result;
+      return true;
     }
     else if ( !printable() || ( hidden() && !show_hidden ) ){
-      throw NoSuchText( "NON printable element: " + xmltag() );
+      return false;
     }
     else {
       TEXT_FLAGS flags = TEXT_FLAGS::NONE;
@@ -1755,24 +1930,212 @@ namespace folia {
       if ( !trim_spaces ){
          flags |= TEXT_FLAGS::NO_TRIM_SPACES;
       }
-      UnicodeString result = deeptext( cls, flags );
-      if ( result.isEmpty() ) {
-	result = stricttext( cls, trim_spaces );
+      if ( !try_deeptext( result, cls, flags ) ){
+	return false;
       }
       if ( result.isEmpty() ) {
-	throw NoSuchText( "on tag " + xmltag() + " nor it's children" );
+	TEXT_FLAGS sflags = TEXT_FLAGS::STRICT;
+	if ( !trim_spaces ){
+	  sflags |= TEXT_FLAGS::NO_TRIM_SPACES;
+	}
+	if ( !try_text( result, cls, sflags ) ){
+	  return false;
+	}
       }
-      return result;
+      return !result.isEmpty();
     }
   }
 
-  const UnicodeString AbstractElement::text( const std::string& cls,
-					     TEXT_FLAGS flags ) const {
-    /// get the UnicodeString text value of an element
+  const UnicodeString AbstractElement::private_text( const string& cls,
+						     bool retaintok,
+						     bool strict,
+						     bool show_hidden,
+                                                     bool trim_spaces ) const {
+
+    /// get the UnicodeString value of an element
+    /*!
+     * \param cls The textclass we are looking for
+     * \param retaintok retain the tokenisation information
+     * \param strict If true, return the text of this level only
+     * when false, allow recursing into children
+     * \param show_hidden include text form 'hidden' nodes too.
+     * \param trim_spaces Trim leading and trailing spaces (defaults to True since FoLiA v2.4.1)
+     * \return the Unicode String representation found. Throws when
+     * no text can be found
+     */
+    UnicodeString result;
+    if ( !AbstractElement::private_try_text( result, cls, retaintok, strict,
+					     show_hidden, trim_spaces ) ){
+      throw_no_text( cls, strict, show_hidden, trim_spaces );
+    }
+    return result;
+  }
+
+  void AbstractElement::throw_no_text( const string& cls,
+				       bool strict,
+				       bool show_hidden,
+				       bool trim_spaces ) const {
+    /// throw the NoSuchText exception for a failed text() lookup
+    /*!
+     * \param cls The textclass we were looking for
+     * \param strict was the lookup restricted to this level?
+     * \param show_hidden did the lookup include 'hidden' nodes?
+     * \param trim_spaces were leading and trailing spaces trimmed?
+     *
+     * Only decides on the message, the text itself is NOT searched again.
+     */
+    if ( strict ) {
+      // let text_content() throw, as it knows best what is missing
+      text_content( cls, show_hidden )->text( cls, !trim_spaces ? TEXT_FLAGS::NO_TRIM_SPACES : TEXT_FLAGS::NONE );
+    }
+    else if ( !is_textcontainer()
+	      && ( !printable() || ( hidden() && !show_hidden ) ) ){
+      throw NoSuchText( "NON printable element: " + xmltag() );
+    }
+    throw NoSuchText( "on tag " + xmltag() + " nor it's children" );
+  }
+
+  /// one memoized result of AbstractElement::text() or phon()
+  struct AbstractElement::text_cache_entry {
+    std::string cls;
+    TEXT_FLAGS flags;
+    bool phon;
+    UnicodeString text;
+  };
+
+  /// the text caches of different nodes are protected by a fixed set of
+  /// mutexes, to allow concurrent text() calls from several threads
+  static std::mutex text_cache_mutexes[64];
+
+  static std::mutex& text_cache_mutex( const void *node ){
+    /// return the mutex that guards the text cache of a node
+    return text_cache_mutexes[ (reinterpret_cast<uintptr_t>(node) >> 4) % 64 ];
+  }
+
+  /// the CORRECTION_HANDLING text() uses in the current thread
+  static thread_local CORRECTION_HANDLING correction_handling
+    = CORRECTION_HANDLING::NEW;
+  /// the Suggestion used for CORRECTION_HANDLING::SUGGESTION
+  static thread_local size_t correction_suggestion = 0;
+
+  class correction_handling_guard {
+    /// set the correction handling of text() in the current thread,
+    /// restoring the previous value on destruction
+  public:
+    correction_handling_guard( CORRECTION_HANDLING h, size_t s ):
+      _saved( correction_handling ),
+      _saved_suggestion( correction_suggestion )
+    {
+      correction_handling = h;
+      correction_suggestion = s;
+    }
+    ~correction_handling_guard(){
+      correction_handling = _saved;
+      correction_suggestion = _saved_suggestion;
+    }
+  private:
+    CORRECTION_HANDLING _saved;
+    size_t _saved_suggestion;
+  };
+
+  bool AbstractElement::text_cacheable() const {
+    /// should text() results of this node be memoized?
+    /*!
+      Nodes holding the text itself are cheap, and not worth the memory.
+      Span annotations refer to Words that are not their 'true' children,
+      so changes in those Words would not invalidate the cache.
+    */
+    ElementType et = element_id();
+    return et != XmlText_t
+      && et != TextContent_t
+      && et != PhonContent_t
+      && !isSubClass( AbstractTextMarkup_t )
+      && !isSubClass( AbstractSpanAnnotation_t );
+  }
+
+  void AbstractElement::clear_text_cache() const {
+    /// forget all memoized text() results of this node
+    std::lock_guard<std::mutex> lock( text_cache_mutex( this ) );
+    delete _text_cache;
+    _text_cache = 0;
+    ++_text_generation;
+  }
+
+  void AbstractElement::mark_text_checked() const {
+    /// register that our text is consistent with the text of our parent
+    /*!
+      The mark is valid until our parent, or one of its descendants, is
+      modified. (which increments the text_generation() of the parent)
+    */
+    _checked_parent = _parent;
+    _checked_generation = _parent ? _parent->text_generation() : 0;
+  }
+
+  bool AbstractElement::text_checked() const {
+    /// is our text known to be consistent with the text of our parent?
+    return _parent
+      && _checked_parent == _parent
+      && _checked_generation == _parent->text_generation();
+  }
+
+  void FoliaElement::invalidate_text_cache() const {
+    /// forget all memoized text() results of this node and all its ancestors
+    /*!
+      Must be called on every modification that may change the text of a
+      node. It also marks the nodes as modified. See mark_modified()
+    */
+    for ( const FoliaElement *p = this; p; p = p->parent() ){
+      p->clear_text_cache();
+    }
+    mark_modified();
+  }
+
+  void AbstractElement::count_modification() const {
+    /// register a modification of this node or one of its descendants
+    std::lock_guard<std::mutex> lock( text_cache_mutex( this ) );
+    ++_modifications;
+  }
+
+  void FoliaElement::mark_modified() const {
+    /// mark this node and all its ancestors as modified
+    /*!
+      Must be called on every modification that changes the XML output of
+      a node. In KEEPSOURCE mode, the source of a modified node is not used.
+      Modifications that may change the text, should call
+      invalidate_text_cache() instead.
+    */
+    for ( const FoliaElement *p = this; p; p = p->parent() ){
+      p->count_modification();
+    }
+  }
+
+  bool AbstractElement::try_text( UnicodeString& result,
+				  const std::string& cls,
+				  TEXT_FLAGS flags ) const {
+    /// get the UnicodeString text value of an element, without throwing
     /*!
+     * \param result the text found
      * \param cls the textclass the text should be in
      * \param flags the search parameters to use. See TEXT_FLAGS.
-     */
+     * \return true when text was found. false otherwise
+     *
+     * The result is memoized per textclass and flags. The cache is cleared
+     * on every modification of the node or one of its descendants.
+     * Results for a non default CORRECTION_HANDLING are not memoized.
+     */
+    bool cacheable = text_cacheable()
+      && correction_handling == CORRECTION_HANDLING::NEW;
+    if ( cacheable ){
+      std::lock_guard<std::mutex> lock( text_cache_mutex( this ) );
+      if ( _text_cache ){
+	for ( const auto& entry : *_text_cache ){
+	  if ( !entry.phon && entry.flags == flags && entry.cls == cls ){
+	    result = entry.text;
+	    return true;
+	  }
+	}
+      }
+    }
     bool retain = ( TEXT_FLAGS::RETAIN & flags ) == TEXT_FLAGS::RETAIN;
     bool strict = ( TEXT_FLAGS::STRICT & flags ) == TEXT_FLAGS::STRICT;
     bool hidden = ( TEXT_FLAGS::HIDDEN & flags ) == TEXT_FLAGS::HIDDEN;
@@ -1780,22 +2143,98 @@ namespace folia {
 #ifdef DEBUG_TEXT
     cerr << "DEBUG text() retain=" << retain << " strict=" << strict << " hidden=" << hidden << " trim_spaces=" << trim_spaces << endl;
 #endif
-    return private_text( cls, retain, strict, hidden, trim_spaces );
+    if ( !private_try_text( result, cls, retain, strict, hidden, trim_spaces ) ){
+      return false;
+    }
+    if ( cacheable ){
+      std::lock_guard<std::mutex> lock( text_cache_mutex( this ) );
+      if ( !_text_cache ){
+	_text_cache = new vector<text_cache_entry>();
+      }
+      text_cache_entry entry;
+      entry.cls = cls;
+      entry.flags = flags;
+      entry.phon = false;
+      entry.text = result;
+      _text_cache->push_back( entry );
+    }
+    return true;
   }
 
-  void FoLiA::setAttributes( KWargs& kwargs ){
-    /// set the attributes of a FoLiA top node
+  bool AbstractElement::try_phon( UnicodeString& result,
+				  const std::string& cls,
+				  TEXT_FLAGS flags ) const {
+    /// get the UnicodeString phon value of an element, without throwing
     /*!
-     * \param kwargs an attribute-value list
-     * the FoLiA top is special, as it may accept special attributes
-     * which are stored in the associated document, and NOT in the node
-     */
-    // we store some attributes in the document itself
-    doc()->setDocumentProps( kwargs );
-    // use remaining attributes for the FoLiA node
-    // probably only the ID
-    AbstractElement::setAttributes( kwargs );
-  }
+     * \param result the phonetic content found
+     * \param cls the textclass the phon should be in
+     * \param flags the search parameters to use. See TEXT_FLAGS.
+     * \return true when phonetic content was found. false otherwise
+     *
+     * The result is memoized per textclass and flags, in the same cache as
+     * the text() results.
+     */
+    bool cacheable = text_cacheable();
+    if ( cacheable ){
+      std::lock_guard<std::mutex> lock( text_cache_mutex( this ) );
+      if ( _text_cache ){
+	for ( const auto& entry : *_text_cache ){
+	  if ( entry.phon && entry.flags == flags && entry.cls == cls ){
+	    result = entry.text;
+	    return true;
+	  }
+	}
+      }
+    }
+    if ( !private_try_phon( result, cls, flags ) ){
+      return false;
+    }
+    if ( cacheable ){
+      std::lock_guard<std::mutex> lock( text_cache_mutex( this ) );
+      if ( !_text_cache ){
+	_text_cache = new vector<text_cache_entry>();
+      }
+      text_cache_entry entry;
+      entry.cls = cls;
+      entry.flags = flags;
+      entry.phon = true;
+      entry.text = result;
+      _text_cache->push_back( entry );
+    }
+    return true;
+  }
+
+  const UnicodeString AbstractElement::text( const std::string& cls,
+					     TEXT_FLAGS flags ) const {
+    /// get the UnicodeString text value of an element
+    /*!
+     * \param cls the textclass the text should be in
+     * \param flags the search parameters to use. See TEXT_FLAGS.
+     * \return the text. Throws NoSuchText when there is none.
+     */
+    UnicodeString result;
+    if ( !try_text( result, cls, flags ) ){
+      bool strict = ( TEXT_FLAGS::STRICT & flags ) == TEXT_FLAGS::STRICT;
+      bool hidden = ( TEXT_FLAGS::HIDDEN & flags ) == TEXT_FLAGS::HIDDEN;
+      bool trim_spaces = !( ( TEXT_FLAGS::NO_TRIM_SPACES & flags ) == TEXT_FLAGS::NO_TRIM_SPACES);
+      throw_no_text( cls, strict, hidden, trim_spaces );
+    }
+    return result;
+  }
+
+  void FoLiA::setAttributes( KWargs& kwargs ){
+    /// set the attributes of a FoLiA top node
+    /*!
+     * \param kwargs an attribute-value list
+     * the FoLiA top is special, as it may accept special attributes
+     * which are stored in the associated document, and NOT in the node
+     */
+    // we store some attributes in the document itself
+    doc()->setDocumentProps( kwargs );
+    // use remaining attributes for the FoLiA node
+    // probably only the ID
+    AbstractElement::setAttributes( kwargs );
+  }
 
   FoliaElement* FoLiA::parseXml( const xmlNode *node ){
     ///
@@ -1883,14 +2322,9 @@ namespace folia {
 #ifdef DEBUG_TEXT
     cerr << "FoLiA::TEXT(" << cls << ")" << endl;
 #endif
-    const vector<FoliaElement *>& data = this->data();
     UnicodeString result;
-    for ( const auto& d : data ){
-      if ( !result.isEmpty() ){
-	const string& delim = d->get_delimiter( retaintok );
-	result += TiCC::UnicodeFromUTF8(delim);
-      }
-      result += d->private_text( cls, retaintok, strict, false, trim_spaces );
+    if ( !private_try_text( result, cls, retaintok, strict, false, trim_spaces ) ){
+      throw_no_text( cls, strict, false, trim_spaces );
     }
 #ifdef DEBUG_TEXT
     cerr << "FoLiA::TEXT returns '" << result << "'" << endl;
@@ -1898,6 +2332,76 @@ namespace folia {
     return result;
   }
 
+  static TEXT_FLAGS child_text_flags( bool retaintok,
+				      bool strict,
+				      bool trim_spaces ){
+    /// the TEXT_FLAGS to use for the children of a FoLiA topnode
+    TEXT_FLAGS flags = TEXT_FLAGS::NONE;
+    if ( retaintok ){
+      flags |= TEXT_FLAGS::RETAIN;
+    }
+    if ( strict ){
+      flags |= TEXT_FLAGS::STRICT;
+    }
+    if ( !trim_spaces ){
+      flags |= TEXT_FLAGS::NO_TRIM_SPACES;
+    }
+    return flags;
+  }
+
+  bool FoLiA::private_try_text( UnicodeString& result,
+				const string& cls,
+				bool retaintok,
+				bool strict,
+				bool,
+				bool trim_spaces ) const {
+    /// get the UnicodeString value of a FoLiA topnode, without throwing
+    /*!
+     * \param result the Unicode String representation found
+     * \param cls The textclass we are looking for
+     * \param retaintok retain the tokenisation information
+     * \param strict If true, return the text of the direct children only
+     * \param trim_spaces Trim leading and trailing spaces
+     * \return true when text is found, false otherwise
+     */
+    TEXT_FLAGS flags = child_text_flags( retaintok, strict, trim_spaces );
+    result.remove();
+    UnicodeString tmp;
+    for ( const auto& d : data() ){
+      if ( !d->try_text( tmp, cls, flags ) ){
+	return false;
+      }
+      if ( !result.isEmpty() ){
+	const string& delim = d->get_delimiter( retaintok );
+	result += TiCC::UnicodeFromUTF8(delim);
+      }
+      result += tmp;
+    }
+    return true;
+  }
+
+  void FoLiA::throw_no_text( const string& cls,
+			     bool strict,
+			     bool,
+			     bool trim_spaces ) const {
+    /// throw the NoSuchText exception for a failed text() lookup
+    /*!
+     * \param cls The textclass we were looking for
+     * \param strict was the lookup restricted to the direct children?
+     * \param trim_spaces were leading and trailing spaces trimmed?
+     *
+     * The exception of the first child without text is passed on.
+     */
+    TEXT_FLAGS flags = child_text_flags( false, strict, trim_spaces );
+    UnicodeString tmp;
+    for ( const auto& d : data() ){
+      if ( !d->try_text( tmp, cls, flags ) ){
+	d->text( cls, flags );
+      }
+    }
+    AbstractElement::throw_no_text( cls, strict, false, trim_spaces );
+  }
+
   UnicodeString trim_space( const UnicodeString& in ){
     /// remove leading and traling spaces. KEEP newlines etc.
     /*!
@@ -2012,14 +2516,76 @@ namespace folia {
     return result;
   }
 
-  const UnicodeString AbstractElement::deeptext( const string& cls,
-						 TEXT_FLAGS flags ) const {
-    /// get the UnicodeString text value of underlying elements
+  /// the number of threads text extraction may use in the current thread
+  static thread_local unsigned int text_threads = 1;
+
+  class text_thread_guard {
+    /// set the number of threads for text extraction in the current thread,
+    /// restoring the previous value on destruction
+  public:
+    explicit text_thread_guard( unsigned int n ): _saved( text_threads ){
+      text_threads = n;
+    }
+    ~text_thread_guard(){
+      text_threads = _saved;
+    }
+  private:
+    unsigned int _saved;
+  };
+
+  const UnicodeString FoliaElement::parallel_text( const string& cls,
+						   TEXT_FLAGS flags,
+						   unsigned int threads ) const {
+    /// get the UnicodeString text value of an element, using several threads
+    /*!
+     * \param cls the textclass
+     * \param flags the search parameters to use. See TEXT_FLAGS.
+     * \param threads the number of threads to use. 0 means: one per core
+     * \return the same result as text( cls, flags )
+     *
+     * The first deeptext() that encounters more then one child with text
+     * computes the texts of those children in parallel. The result is
+     * assembled in document order, just like the sequential version.
+     * The Document may NOT be modified while this runs.
+     */
+    if ( threads == 0 ){
+      threads = std::thread::hardware_concurrency();
+    }
+    text_thread_guard guard( threads );
+    return text( cls, flags );
+  }
+
+  const UnicodeString FoliaElement::corrected_text( CORRECTION_HANDLING handling,
+						    size_t suggestion,
+						    const string& cls,
+						    TEXT_FLAGS flags ) const {
+    /// get the UnicodeString text value of an element, choosing the text of
+    /// all underlying Correction nodes in the same way
+    /*!
+     * \param handling which text of a Correction to use
+     * \param suggestion the index of the Suggestion to use, when handling is
+     * CORRECTION_HANDLING::SUGGESTION
+     * \param cls the textclass
+     * \param flags the search parameters to use. See TEXT_FLAGS.
+     * \return the text. Throws NoSuchText when there is none.
+     *
+     * The text is assembled in one pass over the tree, like text(). With
+     * CORRECTION_HANDLING::NEW the result equals text( cls, flags )
+     */
+    correction_handling_guard guard( handling, suggestion );
+    return text( cls, flags );
+  }
+
+  bool AbstractElement::try_deeptext( UnicodeString& result,
+				      const string& cls,
+				      TEXT_FLAGS flags ) const {
+    /// get the UnicodeString text value of underlying elements, without
+    /// throwing
     /*!
+     * \param result The Unicode Text found.
      * \param cls the textclass
      * \param flags the search parameters to use
-     * \return The Unicode Text found.
-     * Will throw on error.
+     * \return true when text was found, false otherwise
      */
 #ifdef DEBUG_TEXT
     cerr << "deepTEXT(" << cls << ") on node : " << xmltag() << " id=" << id() << ", cls=" << this->cls() << ")" << endl;
@@ -2027,8 +2593,7 @@ namespace folia {
 #ifdef DEBUG_TEXT
     cerr << "deeptext: node has " << _data.size() << " children." << endl;
 #endif
-    vector<UnicodeString> parts;
-    vector<UnicodeString> seps;
+    vector<const FoliaElement*> kids;
     for ( const auto& child : this->data() ) {
       // try to get text dynamically from children
       // skip TextContent elements
@@ -2042,49 +2607,82 @@ namespace folia {
 		|| child->isSubClass( AbstractSpanAnnotation_t )
 		|| child->isinstance( Correction_t ) )
 	   && !child->isinstance( TextContent_t ) ) {
+	kids.push_back( child );
+      }
+    }
+    vector<UnicodeString> kid_texts( kids.size() );
+    vector<char> kid_found( kids.size(), 0 ); // NOT vector<bool>: threads!
+    auto kid_text = [&]( size_t i ){
 #ifdef DEBUG_TEXT
-	cerr << "deeptext:bekijk node[" << child->xmltag() << "]"<< endl;
+      cerr << "deeptext:bekijk node[" << kids[i]->xmltag() << "]"<< endl;
 #endif
-	try {
-	  UnicodeString tmp = child->text( cls, flags );
+      if ( kids[i]->try_text( kid_texts[i], cls, flags ) ){
+	kid_found[i] = 1;
 #ifdef DEBUG_TEXT
-	  cerr << "deeptext found '" << tmp << "'" << endl;
+	cerr << "deeptext found '" << kid_texts[i] << "'" << endl;
 #endif
-	  if ( !isSubClass(AbstractTextMarkup_t) ){
-	    tmp = trim_space( tmp );
-	  }
+      }
 #ifdef DEBUG_TEXT
-	  cerr << "deeptext trimmed '" << tmp << "'" << endl;
+      else {
+	cerr << "HELAAS" << endl;
+      }
 #endif
-	  parts.push_back(tmp);
-	  if ( child->isinstance( Sentence_t )
-	       && no_space_at_end(child) ){
-	    const string& delim = "";
+    };
+    if ( text_threads > 1 && kids.size() > 1 ){
+      // compute the texts of the children in parallel.
+      // nested calls run sequential
+      CORRECTION_HANDLING handling = correction_handling;
+      size_t suggestion = correction_suggestion;
+      parallel_for( kids.size(),
+		    [&]( size_t i ){
+		      text_thread_guard guard( 1 );
+		      correction_handling_guard c_guard( handling, suggestion );
+		      kid_text( i );
+		    },
+		    text_threads );
+    }
+    else {
+      for ( size_t i=0; i < kids.size(); ++i ){
+	kid_text( i );
+      }
+    }
+    vector<UnicodeString> parts;
+    vector<UnicodeString> seps;
+    for ( size_t i=0; i < kids.size(); ++i ) {
+      if ( !kid_found[i] ){
+	continue;
+      }
+      const FoliaElement *child = kids[i];
+      UnicodeString tmp = kid_texts[i];
+      if ( !isSubClass(AbstractTextMarkup_t) ){
+	tmp = trim_space( tmp );
+      }
 #ifdef DEBUG_TEXT
-	    cerr << "deeptext: no delimiter van "<< child->xmltag() << " on"
-		 << " last w of s" << endl;
+      cerr << "deeptext trimmed '" << tmp << "'" << endl;
 #endif
-	    seps.push_back(TiCC::UnicodeFromUTF8(delim));
-	  }
-	  else {
-	    // get the delimiter
-	    bool retain = ( TEXT_FLAGS::RETAIN & flags ) == TEXT_FLAGS::RETAIN;
-	    const string& delim = child->get_delimiter( retain );
+      parts.push_back(tmp);
+      if ( child->isinstance( Sentence_t )
+	   && no_space_at_end(const_cast<FoliaElement*>(child)) ){
+	const string& delim = "";
 #ifdef DEBUG_TEXT
-	    cerr << "deeptext:delimiter van "<< child->xmltag() << " ='" << delim << "'" << endl;
+	cerr << "deeptext: no delimiter van "<< child->xmltag() << " on"
+	     << " last w of s" << endl;
 #endif
-	    seps.push_back(TiCC::UnicodeFromUTF8(delim));
-	  }
-	} catch ( const NoSuchText& e ) {
+	seps.push_back(TiCC::UnicodeFromUTF8(delim));
+      }
+      else {
+	// get the delimiter
+	bool retain = ( TEXT_FLAGS::RETAIN & flags ) == TEXT_FLAGS::RETAIN;
+	const string& delim = child->get_delimiter( retain );
 #ifdef DEBUG_TEXT
-	  cerr << "HELAAS" << endl;
+	cerr << "deeptext:delimiter van "<< child->xmltag() << " ='" << delim << "'" << endl;
 #endif
-	}
+	seps.push_back(TiCC::UnicodeFromUTF8(delim));
       }
     }
 
     // now construct the result;
-    UnicodeString result;
+    result.remove();
     for ( size_t i=0; i < parts.size(); ++i ) {
 #ifdef DEBUG_TEXT
       cerr << "part[" << i << "]='" << parts[i] << "'" << endl;
@@ -2122,12 +2720,90 @@ namespace folia {
 #endif
     if ( result.isEmpty() ) {
       bool hidden = ( TEXT_FLAGS::HIDDEN & flags ) == TEXT_FLAGS::HIDDEN;
-      result = text_content(cls,hidden)->text(cls);
+      const TextContent *tc = find_text_content( cls, hidden );
+      if ( !tc || !tc->try_text( result, cls ) ){
+	return false;
+      }
     }
 #ifdef DEBUG_TEXT
     cerr << "deeptext() for " << xmltag() << " result= '" << result << "'" << endl;
 #endif
-    if ( result.isEmpty() ) {
+    return !result.isEmpty();
+  }
+
+  inline bool is_trim_char( char c ){
+    /// is c one of the characters removed by ltrim() and rtrim()
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+  }
+
+  const string *AbstractElement::text_view( const string& cls ) const {
+    /// return a view on the stored UTF8 text of this element, if possible
+    /*!
+     * \param cls the textclass the text should be in
+     * \return a pointer to the UTF8 value of the one XmlText node that
+     * completely determines the text of this element, or 0 when the text
+     * has to be assembled.
+     *
+     * When not 0, *result equals TiCC::UnicodeToUTF8( text( cls ) ).
+     * This holds for a plain token: a Word (or a TextContent) with a single
+     * \<t\> of the requested class, without markup and without structure
+     * below it.
+     * The pointer stays valid until the element is modified or deleted.
+     */
+    const TextContent *tc = 0;
+    if ( isinstance( TextContent_t ) ){
+      if ( this->cls() != cls ){
+	return 0;
+      }
+      tc = dynamic_cast<const TextContent*>( this );
+    }
+    else {
+      if ( is_textcontainer() || !printable() || hidden() ){
+	return 0;
+      }
+      for ( const auto& child : _data ) {
+	if ( child->printable()
+	     && ( is_structure( child )
+		  || child->isSubClass( AbstractSpanAnnotation_t )
+		  || child->isinstance( Correction_t ) )
+	     && !child->isinstance( TextContent_t ) ) {
+	  // text must be assembled from the children
+	  return 0;
+	}
+      }
+      tc = find_text_content( cls );
+      if ( !tc || tc->parent() != this ){
+	return 0;
+      }
+    }
+    if ( tc->size() != 1 ){
+      return 0;
+    }
+    const XmlText *xt = dynamic_cast<const XmlText*>( tc->index(0) );
+    if ( !xt ){
+      return 0;
+    }
+    const string& value = xt->value();
+    if ( value.empty()
+	 || is_trim_char( value[0] )
+	 || is_trim_char( value[value.size()-1] ) ){
+      // text() would trim it
+      return 0;
+    }
+    return &value;
+  }
+
+  const UnicodeString AbstractElement::deeptext( const string& cls,
+						 TEXT_FLAGS flags ) const {
+    /// get the UnicodeString text value of underlying elements
+    /*!
+     * \param cls the textclass
+     * \param flags the search parameters to use
+     * \return The Unicode Text found.
+     * Will throw on error.
+     */
+    UnicodeString result;
+    if ( !try_deeptext( result, cls, flags ) ){
       throw NoSuchText( xmltag() + ":(class=" + cls +"): empty!" );
     }
     return result;
@@ -2158,17 +2834,17 @@ namespace folia {
     return this->text(cls, flags );
   }
 
-  const TextContent *AbstractElement::text_content( const string& cls,
-						    bool show_hidden ) const {
+  const TextContent *AbstractElement::find_text_content( const string& cls,
+							 bool show_hidden ) const {
     /// Get the TextContent explicitly associated with this element.
     /*!
      * \param cls the textclass to search for
      * \param show_hidden if true also return text of 'hidden' nodes
+     * \return the TextContent, or 0 when not found
      *
      * Returns the TextContent instance rather than the actual text.
      * (so it might return iself.. ;)
      * Does not recurse into children with the sole exception of Correction
-     * might throw NoSuchText exception if not found.
      */
 
 #ifdef DEBUG_TEXT
@@ -2186,7 +2862,7 @@ namespace folia {
 	return dynamic_cast<const TextContent*>(this);
       }
       else {
-	throw NoSuchText( "TextContent::text_content(" + cls + ")" );
+	return 0;
       }
     }
 #ifdef DEBUG_TEXT
@@ -2194,7 +2870,7 @@ namespace folia {
     cerr << (!hidden()?"NOT":"") << " hidden: " << xmltag() << endl;
 #endif
     if ( !printable() || ( hidden() && !show_hidden ) ) {
-      throw NoSuchText( "non-printable element: " +  xmltag() );
+      return 0;
     }
 #ifdef DEBUG_TEXT
     cerr << "recurse into children...." << endl;
@@ -2204,38 +2880,63 @@ namespace folia {
 	return dynamic_cast<TextContent*>(el);
       }
       else if ( el->element_id() == Correction_t) {
-	try {
-	  return el->text_content(cls,show_hidden);
-	} catch ( const NoSuchText& e ) {
-	  // continue search for other Corrections or a TextContent
+	const TextContent *result = el->find_text_content( cls, show_hidden );
+	if ( result ){
+	  return result;
 	}
+	// continue search for other Corrections or a TextContent
       }
     }
-    throw NoSuchText( xmltag() + "::text_content(" + cls + ")" );
+    return 0;
   }
 
-  const PhonContent *AbstractElement::phon_content( const string& cls,
+  const TextContent *AbstractElement::text_content( const string& cls,
 						    bool show_hidden ) const {
+    /// Get the TextContent explicitly associated with this element.
+    /*!
+     * \param cls the textclass to search for
+     * \param show_hidden if true also return text of 'hidden' nodes
+     *
+     * Returns the TextContent instance rather than the actual text.
+     * (so it might return iself.. ;)
+     * Does not recurse into children with the sole exception of Correction
+     * might throw NoSuchText exception if not found.
+     */
+    const TextContent *result = find_text_content( cls, show_hidden );
+    if ( result ){
+      return result;
+    }
+    if ( isinstance(TextContent_t) ){
+      throw NoSuchText( "TextContent::text_content(" + cls + ")" );
+    }
+    if ( !printable() || ( hidden() && !show_hidden ) ) {
+      throw NoSuchText( "non-printable element: " +  xmltag() );
+    }
+    throw NoSuchText( xmltag() + "::text_content(" + cls + ")" );
+  }
+
+  const PhonContent *AbstractElement::find_phon_content( const string& cls,
+							 bool show_hidden ) const {
     /// Get the PhonContent explicitly associated with this element.
     /*!
      * \param cls the textclass to search for
      * \param show_hidden if true also return text og 'hidden' nodes
+     * \return the PhonContent, or 0 when not found
      *
      * Returns the PhonContent instance rather than the actual text.
      * (so it might return iself.. ;)
      * Does not recurse into children with the sole exception of Correction
-     * might throw NoSuchPhon exception if not found.
      */
     if ( isinstance(PhonContent_t) ){
       if  ( this->cls() == cls ) {
 	return dynamic_cast<const PhonContent*>(this);
       }
       else {
-	throw NoSuchPhon( xmltag() + "::phon_content(" + cls + ")" );
+	return 0;
       }
     }
     if ( !speakable() || ( hidden() && !show_hidden ) ) {
-      throw NoSuchPhon( "non-speakable element: " + xmltag() );
+      return 0;
     }
 
     for ( const auto& el : _data ) {
@@ -2243,125 +2944,157 @@ namespace folia {
 	return dynamic_cast<PhonContent*>(el);
       }
       else if ( el->element_id() == Correction_t) {
-	try {
-	  return el->phon_content(cls,show_hidden);
-	} catch ( const NoSuchPhon& e ) {
-	  // continue search for other Corrections or a TextContent
+	const PhonContent *result = el->find_phon_content( cls, show_hidden );
+	if ( result ){
+	  return result;
 	}
+	// continue search for other Corrections or a PhonContent
       }
     }
+    return 0;
+  }
+
+  const PhonContent *AbstractElement::phon_content( const string& cls,
+						    bool show_hidden ) const {
+    /// Get the PhonContent explicitly associated with this element.
+    /*!
+     * \param cls the textclass to search for
+     * \param show_hidden if true also return text og 'hidden' nodes
+     *
+     * Returns the PhonContent instance rather than the actual text.
+     * (so it might return iself.. ;)
+     * Does not recurse into children with the sole exception of Correction
+     * might throw NoSuchPhon exception if not found.
+     */
+    const PhonContent *result = find_phon_content( cls, show_hidden );
+    if ( result ){
+      return result;
+    }
+    if ( !isinstance(PhonContent_t)
+	 && ( !speakable() || ( hidden() && !show_hidden ) ) ) {
+      throw NoSuchPhon( "non-speakable element: " + xmltag() );
+    }
     throw NoSuchPhon( xmltag() + "::phon_content(" + cls + ")" );
   }
 
   //#define DEBUG_PHON
 
-  const UnicodeString AbstractElement::phon( const string& cls,
-					     TEXT_FLAGS flags ) const {
-    /// get the UnicodeString phon value of an element
+  bool AbstractElement::private_try_phon( UnicodeString& result,
+					  const string& cls,
+					  TEXT_FLAGS flags ) const {
+    /// get the UnicodeString phon value of an element, without throwing
     /*!
-     * \param cls the textclass the text should be in
+     * \param result the phonetic content found
+     * \param cls the textclass the phon should be in
      * \param flags the search parameters to use. See TEXT_FLAGS.
+     * \return true when non-empty phonetic content is found
      */
     bool hidden = ( TEXT_FLAGS::HIDDEN & flags ) == TEXT_FLAGS::HIDDEN;
     bool strict = ( TEXT_FLAGS::STRICT & flags ) == TEXT_FLAGS::STRICT;
 #ifdef DEBUG_PHON
     cerr << "PHON(" << cls << ") on node : " << xmltag() << " id=" << id() << endl;
 #endif
+    result.remove();
     if ( strict ) {
-      return phon_content(cls)->phon();
+      const PhonContent *pc = find_phon_content( cls );
+      return pc && pc->try_phon( result, cls );
     }
     else if ( !speakable() || ( this->hidden() && !hidden ) ) {
-      throw NoSuchPhon( "NON speakable element: " + xmltag() );
+      return false;
     }
-    else {
-      UnicodeString result = deepphon( cls, flags );
-      if ( result.isEmpty() ) {
-	result = phon_content(cls,hidden)->phon();
-      }
-      if ( result.isEmpty() ) {
-	throw NoSuchPhon( "on tag " + xmltag() + " nor it's children" );
-      }
+    return try_deepphon( result, cls, flags );
+  }
+
+  const UnicodeString AbstractElement::phon( const string& cls,
+					     TEXT_FLAGS flags ) const {
+    /// get the UnicodeString phon value of an element
+    /*!
+     * \param cls the textclass the text should be in
+     * \param flags the search parameters to use. See TEXT_FLAGS.
+     * \return the phonetic content. Throws NoSuchPhon when there is none.
+     */
+    UnicodeString result;
+    if ( try_phon( result, cls, flags ) ){
       return result;
     }
+    bool hidden = ( TEXT_FLAGS::HIDDEN & flags ) == TEXT_FLAGS::HIDDEN;
+    bool strict = ( TEXT_FLAGS::STRICT & flags ) == TEXT_FLAGS::STRICT;
+    if ( strict ) {
+      phon_content( cls ); // throws the appropriate exception
+    }
+    else if ( !speakable() || ( this->hidden() && !hidden ) ) {
+      throw NoSuchPhon( "NON speakable element: " + xmltag() );
+    }
+    throw NoSuchPhon( xmltag() + ":(class=" + cls +"): empty!" );
   }
 
-  const UnicodeString AbstractElement::deepphon( const string& cls,
-						 TEXT_FLAGS flags ) const {
-    /// get the UnicodeString phon value of underlying elements
+  bool AbstractElement::try_deepphon( UnicodeString& result,
+				      const string& cls,
+				      TEXT_FLAGS flags ) const {
+    /// get the UnicodeString phon value of underlying elements, without
+    /// throwing
     /*!
+     * \param result the phonetic content found
      * \param cls the textclass
      * \param flags the search parameters to use
-     * \return The Unicode Text found.
-     * Will throw on error.
+     * \return true when non-empty phonetic content is found
      */
 #ifdef DEBUG_PHON
     cerr << "deepPHON(" << cls << ") on node : " << xmltag()
 	 << " id=" << id() << endl;
     cerr << "deepphon: node has " << _data.size() << " children." << endl;
 #endif
-    vector<UnicodeString> parts;
-    vector<UnicodeString> seps;
+    result.remove();
+    UnicodeString sep;
+    bool first = true;
+    UnicodeString tmp;
     for ( const auto& child : _data ) {
       // try to get text dynamically from children
       // skip PhonContent elements
+      if ( child->speakable()
+	   && !child->isinstance( PhonContent_t )
+	   && child->try_phon( tmp, cls ) ){
 #ifdef DEBUG_PHON
-      if ( !child->speakable() ) {
-	cerr << "deepphon: node[" << child->xmltag() << "] NOT SPEAKABLE! " << endl;
-      }
-#endif
-      if ( child->speakable() && !child->isinstance( PhonContent_t ) ) {
-#ifdef DEBUG_PHON
-	cerr << "deepphon:bekijk node[" << child->xmltag() << "]" << endl;
-#endif
-	try {
-	  UnicodeString tmp = child->phon( cls );
-#ifdef DEBUG_PHON
-	  cerr << "deepphon found '" << tmp << "'" << endl;
-#endif
-	  parts.push_back(tmp);
-	  // get the delimiter
-	  const string& delim = child->get_delimiter();
-#ifdef DEBUG_PHON
-	  cerr << "deepphon:delimiter van "<< child->xmltag() << " ='" << delim << "'" << endl;
-#endif
-	  seps.push_back(TiCC::UnicodeFromUTF8(delim));
-	} catch ( const NoSuchPhon& e ) {
-#ifdef DEBUG_PHON
-	  cerr << "HELAAS" << endl;
+	cerr << "deepphon found '" << tmp << "'" << endl;
 #endif
+	if ( !first ){
+	  result += sep;
 	}
+	result += tmp;
+	first = false;
+	// get the delimiter
+	sep = TiCC::UnicodeFromUTF8( child->get_delimiter() );
       }
     }
-
-    // now construct the result;
-    UnicodeString result;
-    for ( size_t i=0; i < parts.size(); ++i ) {
-      result += parts[i];
-      if ( i < parts.size()-1 ) {
-	result += seps[i];
-      }
-    }
-#ifdef DEBUG_TEXT
-    cerr << "deepphon() for " << xmltag() << " step 3 " << endl;
-#endif
     if ( result.isEmpty() ) {
       bool hidden = ( TEXT_FLAGS::HIDDEN & flags ) == TEXT_FLAGS::HIDDEN;
-      try {
-	result = phon_content(cls,hidden)->phon();
-      }
-      catch ( ... ) {
+      const PhonContent *pc = find_phon_content( cls, hidden );
+      if ( !pc || !pc->try_phon( result, cls ) ){
+	return false;
       }
     }
-#ifdef DEBUG_TEXT
-    cerr << "deepphontext() for " << xmltag() << " result= '" << result << "'" << endl;
+#ifdef DEBUG_PHON
+    cerr << "deepphon() for " << xmltag() << " result= '" << result << "'" << endl;
 #endif
-    if ( result.isEmpty() ) {
+    return !result.isEmpty();
+  }
+
+  const UnicodeString AbstractElement::deepphon( const string& cls,
+						 TEXT_FLAGS flags ) const {
+    /// get the UnicodeString phon value of underlying elements
+    /*!
+     * \param cls the textclass
+     * \param flags the search parameters to use
+     * \return The Unicode Text found.
+     * Will throw on error.
+     */
+    UnicodeString result;
+    if ( !try_deepphon( result, cls, flags ) ) {
       throw NoSuchPhon( xmltag() + ":(class=" + cls +"): empty!" );
     }
     return result;
   }
 
-
   vector<FoliaElement *>AbstractElement::find_replacables( FoliaElement *par ) const {
     // find all children with the same signature as the parameter
     /*!
@@ -2412,6 +3145,7 @@ namespace folia {
     if ( it != _data.end() ){
       *it = _new;
       _new->set_parent(this);
+      invalidate_text_cache();
     }
     return 0;
   }
@@ -2428,6 +3162,7 @@ namespace folia {
     while ( it != _data.end() ) {
       if ( *it == pos ) {
 	it = _data.insert( ++it, add );
+	invalidate_text_cache();
 	break;
       }
       ++it;
@@ -2832,6 +3567,7 @@ namespace folia {
       if ( !child->parent() ) {
 	child->set_parent(this);
       }
+      invalidate_text_cache();
       if ( child->referable() ){
 	child->increfcount();
       }
@@ -2844,6 +3580,7 @@ namespace folia {
     /// perform some post correction after appending
     if ( id().empty() && (ID & required_attributes()) && auto_generate_id() ){
       _id = generateId( xmltag() );
+      invalidate_text_cache(); // we are modified
     }
     return this;
   }
@@ -2884,6 +3621,7 @@ namespace folia {
      */
     auto it = std::remove( _data.begin(), _data.end(), child );
     _data.erase( it, _data.end() );
+    invalidate_text_cache();
     if ( del ) {
       if ( child->refcount() > 0 ){
 	// dont really delete yet!
@@ -2923,6 +3661,7 @@ namespace folia {
 	(*it)->set_parent(0);
       }
       _data.erase(it);
+      invalidate_text_cache();
     }
   }
 
@@ -3169,6 +3908,22 @@ namespace folia {
 	 && !isSubClass( Morpheme_t ) && !isSubClass( Phoneme_t) ){
         check_text_consistency_while_parsing();
     }
+    if ( doc() && doc()->checktext() ){
+      // our children are complete now, so the output check of them can be
+      // done while the texts are at hand
+      for ( const auto& child : _data ){
+	if ( !child->data().empty() ){
+	  child->precheck_text_consistency();
+	}
+      }
+    }
+    if ( node->_private ){
+      // in KEEPSOURCE mode: remember where we are in the source
+      const auto range = static_cast<const pair<size_t,size_t>*>( node->_private );
+      _source_begin = range->first;
+      _source_end = range->second;
+      _source_generation = _modifications;
+    }
     return this;
   }
 
@@ -3187,6 +3942,7 @@ namespace folia {
 	throw ValueError( "invalid datetime, must be in YYYY-MM-DDThh:mm:ss format: " + s );
       }
       _datetime = time;
+      mark_modified();
     }
   }
 
@@ -3767,10 +4523,11 @@ namespace folia {
     return 0;
   }
 
-  FoliaElement *TextContent::get_reference() const {
-    /// get the FoliaElement _ref is refering to
+  FoliaElement *TextContent::find_reference() const {
+    /// find the FoliaElement _ref is refering to, without checking the offset
     /*!
-     * \return the refered element OR the default parent when _ref is 0
+     * \return the refered element OR the default parent when _ref is 0.
+     * 0 when there is no offset. Throws when there is no such element
      */
     FoliaElement *ref = 0;
     if ( _offset == -1 ){
@@ -3792,33 +4549,56 @@ namespace folia {
     else if ( !ref->hastext( cls() ) ){
       throw UnresolvableTextContent( "Reference (ID " + _ref + ") has no such text (class=" + cls() + ")" );
     }
-    else if ( doc()->checktext() || doc()->fixtext() ){
-      UnicodeString mt = this->text( this->cls(), TEXT_FLAGS::STRICT );
-      UnicodeString pt = ref->text( this->cls(), TEXT_FLAGS::STRICT );
-      UnicodeString sub( pt, this->offset(), mt.length() );
-      if ( mt != sub ){
-	if ( doc()->fixtext() ){
-	  int pos = pt.indexOf( mt );
-	  if ( pos < 0 ){
-	    throw UnresolvableTextContent( "Reference (ID " + ref->id() +
-					   ",class=" + cls()
-					   + " found, but no substring match "
-					   + TiCC::UnicodeToUTF8(mt)
-					   + " in " +  TiCC::UnicodeToUTF8(pt) );
-	  }
-	  else {
-	    this->set_offset( pos );
-	  }
+    return ref;
+  }
+
+  void TextContent::check_offset( const FoliaElement *ref,
+				  const UnicodeString& pt ) const {
+    /// check our offset against the text of the refered element
+    /*!
+     * \param ref the refered element, as returned by find_reference()
+     * \param pt the STRICT text of ref (class=cls())
+     *
+     * Throws when our text isn't found at offset() in pt. In FIXTEXT mode
+     * the offset is repaired when our text is found elsewhere in pt.
+     */
+    UnicodeString mt = this->text( this->cls(), TEXT_FLAGS::STRICT );
+    UnicodeString sub( pt, this->offset(), mt.length() );
+    if ( mt != sub ){
+      if ( doc()->fixtext() ){
+	int pos = pt.indexOf( mt );
+	if ( pos < 0 ){
+	  throw UnresolvableTextContent( "Reference (ID " + ref->id() +
+					 ",class=" + cls()
+					 + " found, but no substring match "
+					 + TiCC::UnicodeToUTF8(mt)
+					 + " in " +  TiCC::UnicodeToUTF8(pt) );
 	}
 	else {
-	  throw UnresolvableTextContent( "Reference (ID " + ref->id() +
-					 ",class='" + cls()
-					 + "') found, but no text match at "
-					 + "offset=" + TiCC::toString(offset())
-					 + " Expected '" + TiCC::UnicodeToUTF8(mt)
-					 + "' but got '" +  TiCC::UnicodeToUTF8(sub) + "'" );
+	  this->set_offset( pos );
 	}
       }
+      else {
+	throw UnresolvableTextContent( "Reference (ID " + ref->id() +
+				       ",class='" + cls()
+				       + "') found, but no text match at "
+				       + "offset=" + TiCC::toString(offset())
+				       + " Expected '" + TiCC::UnicodeToUTF8(mt)
+				       + "' but got '" +  TiCC::UnicodeToUTF8(sub) + "'" );
+      }
+    }
+  }
+
+  FoliaElement *TextContent::get_reference() const {
+    /// get the FoliaElement _ref is refering to
+    /*!
+     * \return the refered element OR the default parent when _ref is 0
+     *
+     * When CHECKTEXT or FIXTEXT mode is set, our offset is checked too
+     */
+    FoliaElement *ref = find_reference();
+    if ( ref && ( doc()->checktext() || doc()->fixtext() ) ){
+      check_offset( ref, ref->text( this->cls(), TEXT_FLAGS::STRICT ) );
     }
     return ref;
   }
@@ -3864,10 +4644,11 @@ namespace folia {
     return 0;
   }
 
-  FoliaElement *PhonContent::get_reference() const {
-    /// get the FoliaElement _ref is refering to
+  FoliaElement *PhonContent::find_reference() const {
+    /// find the FoliaElement _ref is refering to, without checking the offset
     /*!
-     * \return the refered element OR the default parent when _ref is 0
+     * \return the refered element OR the default parent when _ref is 0.
+     * 0 when there is no offset. Throws when there is no such element
      */
     FoliaElement *ref = 0;
     if ( _offset == -1 ){
@@ -3889,33 +4670,56 @@ namespace folia {
     else if ( !ref->hasphon( cls() ) ){
       throw UnresolvableTextContent( "Reference (ID " + _ref + ") has no such phonetic content (class=" + cls() + ")" );
     }
-    else if ( doc()->checktext() || doc()->fixtext() ){
-      UnicodeString mt = this->phon( this->cls() );
-      UnicodeString pt = ref->phon( this->cls() );
-      UnicodeString sub( pt, this->offset(), mt.length() );
-      if ( mt != sub ){
-	if ( doc()->fixtext() ){
-	  int pos = pt.indexOf( mt );
-	  if ( pos < 0 ){
-	    throw UnresolvableTextContent( "Reference (ID " + ref->id() +
-					   ",class=" + cls()
-					   + " found, but no substring match "
-					   + TiCC::UnicodeToUTF8(mt)
-					   + " in " +  TiCC::UnicodeToUTF8(pt) );
-	  }
-	  else {
-	    this->set_offset( pos );
-	  }
-	}
-	else {
+    return ref;
+  }
+
+  void PhonContent::check_offset( const FoliaElement *ref,
+				  const UnicodeString& pt ) const {
+    /// check our offset against the phonetic content of the refered element
+    /*!
+     * \param ref the refered element, as returned by find_reference()
+     * \param pt the phonetic content of ref (class=cls())
+     *
+     * Throws when our phon isn't found at offset() in pt. In FIXTEXT mode
+     * the offset is repaired when our phon is found elsewhere in pt.
+     */
+    UnicodeString mt = this->phon( this->cls() );
+    UnicodeString sub( pt, this->offset(), mt.length() );
+    if ( mt != sub ){
+      if ( doc()->fixtext() ){
+	int pos = pt.indexOf( mt );
+	if ( pos < 0 ){
 	  throw UnresolvableTextContent( "Reference (ID " + ref->id() +
 					 ",class=" + cls()
-					 + " found, but no text match at "
-					 + "offset=" + TiCC::toString(offset())
-					 + " Expected " + TiCC::UnicodeToUTF8(mt)
-					 + " but got " +  TiCC::UnicodeToUTF8(sub) );
+					 + " found, but no substring match "
+					 + TiCC::UnicodeToUTF8(mt)
+					 + " in " +  TiCC::UnicodeToUTF8(pt) );
+	}
+	else {
+	  this->set_offset( pos );
 	}
       }
+      else {
+	throw UnresolvableTextContent( "Reference (ID " + ref->id() +
+				       ",class=" + cls()
+				       + " found, but no text match at "
+				       + "offset=" + TiCC::toString(offset())
+				       + " Expected " + TiCC::UnicodeToUTF8(mt)
+				       + " but got " +  TiCC::UnicodeToUTF8(sub) );
+      }
+    }
+  }
+
+  FoliaElement *PhonContent::get_reference() const {
+    /// get the FoliaElement _ref is refering to
+    /*!
+     * \return the refered element OR the default parent when _ref is 0
+     *
+     * When CHECKTEXT or FIXTEXT mode is set, our offset is checked too
+     */
+    FoliaElement *ref = find_reference();
+    if ( ref && ( doc()->checktext() || doc()->fixtext() ) ){
+      check_offset( ref, ref->phon( this->cls() ) );
     }
     return ref;
   }
@@ -3993,42 +4797,35 @@ namespace folia {
     return result;
   }
 
-  const UnicodeString PhonContent::phon( const string& cls,
-					 TEXT_FLAGS ) const {
+  bool PhonContent::private_try_phon( UnicodeString& result,
+				      const string& cls,
+				      TEXT_FLAGS ) const {
     /// get the UnicodeString phon value
     /*!
+     * \param result the phonetic content found. May be empty.
      * \param cls the textclass the text should be in
-     * The second parameter is NOT used (yet)
+     * The third parameter is NOT used (yet)
+     * \return true always
      */
 #ifdef DEBUG_PHON
     cerr << "PhonContent::PHON(" << cls << ") " << endl;
 #endif
-    UnicodeString result;
+    result.remove();
+    UnicodeString tmp;
     for ( const auto& el : data() ) {
       // try to get text dynamically from children
-#ifdef DEBUG_PHON
-      cerr << "PhonContent: bekijk node[" << el->str(cls) << endl;
-#endif
-      try {
-#ifdef DEBUG_PHON
-	cerr << "roep text(" << cls << ") aan op " << el << endl;
-#endif
-	UnicodeString tmp = el->text( cls );
+      if ( el->try_text( tmp, cls ) ){
 #ifdef DEBUG_PHON
 	cerr << "PhonContent found '" << tmp << "'" << endl;
 #endif
 	result += tmp;
-      } catch ( const NoSuchPhon& e ) {
-#ifdef DEBUG_TEXT
-	cerr << "PhonContent::HELAAS" << endl;
-#endif
       }
     }
     result.trim();
 #ifdef DEBUG_PHON
     cerr << "PhonContent return " << result << endl;
 #endif
-    return result;
+    return true;
   }
 
   const string AllowGenerateID::generateId( const string& tag ){
@@ -5166,18 +5963,22 @@ namespace folia {
      * \param node a WordReference
      * \return the parsed tree. Throws on error.
      */
-    KWargs atts = getAttributes( node );
-    string id = atts["id"];
-    if ( id.empty() ) {
+    // look up the id directly in the attribute value
+    const xmlAttr *att = xmlHasNsProp( node, (const xmlChar*)"id", 0 );
+    const char *id_val = 0;
+    if ( att && att->children && att->children->content ){
+      id_val = (const char*)att->children->content;
+    }
+    if ( !id_val || !*id_val ) {
       throw XmlError( "empty id in WordReference" );
     }
     if ( doc()->debug ) {
-      cerr << "Found word reference: " << id << endl;
+      cerr << "Found word reference: " << id_val << endl;
     }
-    FoliaElement *ref = (*doc())[id];
+    FoliaElement *ref = doc()->index( id_val, strlen( id_val ) );
     if ( ref ) {
       if ( !ref->referable() ){
-	throw XmlError( "WordReference id=" + id + " refers to a non-referable word: "
+	throw XmlError( "WordReference id=" + string(id_val) + " refers to a non-referable word: "
 			+ ref->xmltag() );
       }
       // Disabled test! should consider the textclass of the yet unknown
@@ -5198,7 +5999,8 @@ namespace folia {
       ref->increfcount();
     }
     else {
-      throw XmlError( "Unresolvable id " + id + " in WordReference" );
+      throw XmlError( "Unresolvable id " + string(id_val)
+		      + " in WordReference" );
     }
     delete this;
     return ref;
@@ -5326,7 +6128,21 @@ namespace folia {
     if ( !_value.empty() ){
       xmlAddChild( e, xmlNewText( (const xmlChar*)_value.c_str()) );
     }
-    return e;
+    return e;
+  }
+
+  void Description::write_xml( XmlWriter& w, bool ) const {
+    ///  write the Description as XML text
+    set<FoliaElement *> attribute_elements;
+    KWargs attribs = xml_attributes( attribute_elements );
+    if ( _value.empty() ){
+      w.start_element( xmltag(), attribs, XmlWriter::EMPTY );
+    }
+    else {
+      w.start_element( xmltag(), attribs, XmlWriter::MIXED );
+      w.text( _value );
+      w.end_element();
+    }
   }
 
   FoliaElement* Description::parseXml( const xmlNode *node ) {
@@ -5363,6 +6179,20 @@ namespace folia {
     return e;
   }
 
+  void Comment::write_xml( XmlWriter& w, bool ) const {
+    ///  write the Comment as XML text
+    set<FoliaElement *> attribute_elements;
+    KWargs attribs = xml_attributes( attribute_elements );
+    if ( _value.empty() ){
+      w.start_element( xmltag(), attribs, XmlWriter::EMPTY );
+    }
+    else {
+      w.start_element( xmltag(), attribs, XmlWriter::MIXED );
+      w.text( _value );
+      w.end_element();
+    }
+  }
+
   FoliaElement* Comment::parseXml( const xmlNode *node ) {
     /// parse a Comment node at node
     /*!
@@ -5540,6 +6370,45 @@ namespace folia {
     return e;
   }
 
+  void AbstractSpanAnnotation::write_xml( XmlWriter& w, bool kanon ) const {
+    ///  write a SpanAnnotation as XML text
+    /*!
+     * \param w the XmlWriter to use
+     * \param kanon if true, output in a canonical way.
+     *
+     * Like xml(), referable children are output as Wref, except for their
+     * first occurrence in the document.
+     */
+    set<FoliaElement *> attribute_elements;
+    KWargs attribs = xml_attributes( attribute_elements );
+    vector<FoliaElement*> children;
+    for ( const auto& el : data() ) {
+      if ( el->refcount() > 0
+	   || tagToAtt( el ).empty() ){
+	children.push_back( el );
+      }
+    }
+    w.start_element( xmltag(), attribs, xml_content_kind( children ) );
+    if ( children.empty() ){
+      return;
+    }
+    for ( const auto& el : children ) {
+      if ( el->refcount() > 0 ){
+	KWargs args;
+	args["id"] = el->id();
+	string txt = el->str( el->textclass() );
+	if ( !txt.empty() ) {
+	  args["t"] = txt;
+	}
+	w.start_element( "wref", args, XmlWriter::EMPTY );
+      }
+      else {
+	el->write_xml( w, kanon );
+      }
+    }
+    w.end_element();
+  }
+
   xmlNode *Content::xml( bool recursive, bool ) const {
     ///  convert a Content node to an xmlNode
     /*!
@@ -5554,6 +6423,21 @@ namespace folia {
     return e;
   }
 
+  void Content::write_xml( XmlWriter& w, bool ) const {
+    ///  write a Content node as XML text, with the value as a CData block
+    set<FoliaElement *> attribute_elements;
+    KWargs attribs = xml_attributes( attribute_elements );
+    w.start_element( xmltag(), attribs, XmlWriter::MIXED );
+    if ( !data().empty() ){
+      for ( const auto& el : xml_children( attribute_elements, false ) ) {
+	el->write_xml( w, false );
+      }
+      check_text_consistency();
+    }
+    w.cdata( value );
+    w.end_element();
+  }
+
   void Content::setAttributes( KWargs& kwargs ){
     /// set the Contents attributes given a set of Key-Value pairs.
     /*!
@@ -5614,87 +6498,167 @@ namespace folia {
   }
 
   //#define DEBUG_TEXT
-  const UnicodeString Correction::private_text( const string& cls,
-						bool retaintok,
-						bool, bool, bool trim_spaces ) const {
-    /// get the UnicodeString value of an Correction
+  void Correction::init(){
+    /// set default values on creation
+    _new_child = 0;
+    _original_child = 0;
+    _current_child = 0;
+    _resolved_generation = 0;
+    _resolved = false;
+  }
+
+  void Correction::resolve_children() const {
+    /// find the New, Original, Current and Suggestion children
+    /*!
+      The result is kept until this Correction, or one of its descendants,
+      is modified. (which increments the text_generation())
+      The caller must hold the text_cache_mutex() of this node.
+    */
+    if ( _resolved && _resolved_generation == text_generation() ){
+      return;
+    }
+    _new_child = 0;
+    _original_child = 0;
+    _current_child = 0;
+    _suggestion_children.clear();
+    for ( const auto& el : data() ){
+      switch ( el->element_id() ){
+      case New_t:
+	if ( !_new_child ){
+	  _new_child = dynamic_cast<New*>( el );
+	}
+	break;
+      case Original_t:
+	if ( !_original_child ){
+	  _original_child = dynamic_cast<Original*>( el );
+	}
+	break;
+      case Current_t:
+	if ( !_current_child ){
+	  _current_child = dynamic_cast<Current*>( el );
+	}
+	break;
+      case Suggestion_t:
+	_suggestion_children.push_back( dynamic_cast<Suggestion*>( el ) );
+	break;
+      default:
+	break;
+      }
+    }
+    _resolved_generation = text_generation();
+    _resolved = true;
+  }
+
+  static bool try_correction_child( const FoliaElement *el,
+				    UnicodeString& result,
+				    const string& cls,
+				    TEXT_FLAGS flags ){
+    /// get the text of a New, Original, Current or Suggestion node
+    /*!
+     * \param el the node. May be 0
+     * \param result the text found
+     * \param cls the textclass
+     * \param flags the search parameters to use
+     * \return true when a non-empty text is found
+     */
+    result.remove();
+    if ( !el ){
+      return false;
+    }
+    return el->try_text( result, cls, flags )
+      && !result.isEmpty();
+  }
+
+  bool Correction::private_try_text( UnicodeString& result,
+				     const string& cls,
+				     bool retaintok,
+				     bool, bool, bool trim_spaces ) const {
+    /// get the UnicodeString value of an Correction, without throwing
     /*!
+     * \param result the Unicode String representation found
      * \param cls The textclass we are looking for
      * \param retaintok retain the tokenisation information
-     * \return the Unicode String representation found. Throws when
-     * no text can be found.
+     * \return true when text is found
+     *
+     * Which text is returned depends on the CORRECTION_HANDLING in effect.
+     * By default that is the text of the New node, or, when not available,
+     * the text of the Current node or else the Original node. When the New
+     * node is empty (a deletion) only the text of the Current node is used.
      */
 #ifdef DEBUG_TEXT
     cerr << "TEXT(" << cls << ") on node : " << xmltag() << " id=" << id() << endl;
 #endif
     // we cannot use text_content() on New, Original or Current,
     // because textcontent doesn't recurse!
-    bool deletion = false;
-    UnicodeString new_result;
-    UnicodeString org_result;
-    UnicodeString cur_result;
-    for ( const auto& el : data() ) {
-#ifdef DEBUG_TEXT
-      cerr << "data=" << el << endl;
-#endif
-      if ( el->isinstance( New_t ) ){
-	if ( el->size() == 0 ){
-	  deletion = true;
-	}
-	else {
-	  try {
-	    new_result = el->private_text( cls, retaintok, false, false, trim_spaces );
-	  }
-	  catch ( ... ){
-	    // try other nodes
-	  }
-	}
-      }
-      else if ( el->isinstance( Original_t ) ){
-	try {
-	  org_result = el->private_text( cls, retaintok, false, false, trim_spaces );
-	}
-	catch ( ... ){
-	  // try other nodes
-	}
-      }
-      else if ( el->isinstance( Current_t ) ){
-	try {
-	  cur_result = el->private_text( cls, retaintok, false, false, trim_spaces );
-	}
-	catch ( ... ){
-	  // try other nodes
-	}
-      }
-    }
-    if ( !deletion ){
-      if ( !new_result.isEmpty() ){
-#ifdef DEBUG_TEXT
-	cerr << "return new text '" << new_result << "'" << endl;
-#endif
-	return new_result;
-      }
-      else if ( !cur_result.isEmpty() ){
+    TEXT_FLAGS flags = TEXT_FLAGS::NONE;
+    if ( retaintok ){
+      flags |= TEXT_FLAGS::RETAIN;
+    }
+    if ( !trim_spaces ){
+      flags |= TEXT_FLAGS::NO_TRIM_SPACES;
+    }
+    const New *nw = 0;
+    const Original *org = 0;
+    const Current *cur = 0;
+    const Suggestion *sug = 0;
+    {
+      std::lock_guard<std::mutex> lock( text_cache_mutex( this ) );
+      resolve_children();
+      nw = _new_child;
+      org = _original_child;
+      cur = _current_child;
+      if ( correction_handling == CORRECTION_HANDLING::SUGGESTION
+	   && correction_suggestion < _suggestion_children.size() ){
+	sug = _suggestion_children[correction_suggestion];
+      }
+    }
+    if ( sug ){
+      // an empty Suggestion suggests a deletion
+      return sug->size() > 0
+	&& try_correction_child( sug, result, cls, flags );
+    }
+    if ( correction_handling == CORRECTION_HANDLING::ORIGINAL ){
+      return try_correction_child( org, result, cls, flags )
+	|| try_correction_child( cur, result, cls, flags );
+    }
+    bool deletion = ( nw && nw->size() == 0 );
+    if ( deletion ){
 #ifdef DEBUG_TEXT
-	cerr << "return cur text '" << cur_result << "'" << endl;
+      cerr << "Deletion: return cur text" << endl;
 #endif
-	return cur_result;
-      }
-      else if ( !org_result.isEmpty() ){
-#ifdef DEBUG_TEXT
-	cerr << "return ori text '" << org_result << "'" << endl;
-#endif
-	return org_result;
-      }
+      return try_correction_child( cur, result, cls, flags );
     }
-    else {
-      if ( !cur_result.isEmpty() ){
-#ifdef DEBUG_TEXT
-	cerr << "Deletion: return cur text '" << cur_result << "'" << endl;
-#endif
-	return cur_result;
-      }
+    return try_correction_child( nw, result, cls, flags )
+      || try_correction_child( cur, result, cls, flags )
+      || try_correction_child( org, result, cls, flags );
+  }
+
+  const UnicodeString Correction::private_text( const string& cls,
+						bool retaintok,
+						bool strict,
+						bool show_hidden,
+						bool trim_spaces ) const {
+    /// get the UnicodeString value of an Correction
+    /*!
+     * \param cls The textclass we are looking for
+     * \param retaintok retain the tokenisation information
+     * \return the Unicode String representation found. Throws when
+     * no text can be found.
+     */
+    UnicodeString result;
+    if ( !private_try_text( result, cls, retaintok, strict,
+			    show_hidden, trim_spaces ) ){
+      throw_no_text( cls, strict, show_hidden, trim_spaces );
     }
+    return result;
+  }
+
+  void Correction::throw_no_text( const string& cls,
+				  bool, bool, bool ) const {
+    /// throw the NoSuchText exception for a failed text() lookup
+    /*!
+     * \param cls The textclass we were looking for
+     */
     throw NoSuchText( "cls=" + cls );
   }
   //#undef DEBUG_TEXT
@@ -5713,46 +6677,90 @@ namespace folia {
     return EMPTY_STRING;
   }
 
-  const TextContent *Correction::text_content( const string& cls,
-					       bool show_hidden ) const {
+  const TextContent *Correction::find_text_content( const string& cls,
+						    bool show_hidden ) const {
     /// Get the TextContent explicitly associated with a Correction
     /*!
      * \param cls the textclass to search for
      * \param show_hidden if true also return text of 'hidden' nodes
+     * \return the TextContent found, or 0
      *
      * Returns the TextContent instance rather than the actual text.
      * (so it might return iself.. ;)
-     * recurses into children looking for New or Current nodes
-     * might throw NoSuchText exception if not found.
-     */
+     * recurses into children looking for New or Current nodes, or for the
+     * nodes the CORRECTION_HANDLING in effect prefers
+     */
+    if ( correction_handling != CORRECTION_HANDLING::NEW ){
+      const FoliaElement *first = 0;
+      const FoliaElement *second = 0;
+      {
+	std::lock_guard<std::mutex> lock( text_cache_mutex( this ) );
+	resolve_children();
+	if ( correction_handling == CORRECTION_HANDLING::ORIGINAL ){
+	  first = _original_child;
+	  second = _current_child;
+	}
+	else if ( correction_suggestion < _suggestion_children.size() ){
+	  first = _suggestion_children[correction_suggestion];
+	  if ( first->size() == 0 ){
+	    // a suggested deletion
+	    return 0;
+	  }
+	}
+      }
+      if ( first ){
+	const TextContent *res = first->find_text_content( cls, show_hidden );
+	if ( res ){
+	  return res;
+	}
+      }
+      if ( correction_handling == CORRECTION_HANDLING::ORIGINAL ){
+	return second ? second->find_text_content( cls, show_hidden ) : 0;
+      }
+    }
     // TODO: this implements correctionhandling::EITHER only
     for ( const auto& el : data() ) {
       if ( el->isinstance( New_t ) || el->isinstance( Current_t ) ) {
-	try {
-	  const TextContent *res = el->text_content( cls, show_hidden );
+	const TextContent *res = el->find_text_content( cls, show_hidden );
+	if ( res ){
 	  return res;
 	}
-	catch (...){
-	}
       }
     }
     for ( const auto& el : data() ) {
       if ( el->isinstance( Original_t ) ) {
-	try {
-	  const TextContent *res = el->text_content( cls, show_hidden );
+	const TextContent *res = el->find_text_content( cls, show_hidden );
+	if ( res ){
 	  return res;
 	}
-	catch ( ... ){
-	}
       }
       else if ( cls == "current" && el->hastext( "original" ) ){
 	cerr << "text(original)= "
 	     << el->text_content( cls, show_hidden )->text()<< endl;
 	// hack for old and erroneous behaviour
-	return el->text_content( "original", show_hidden );
+	return el->find_text_content( "original", show_hidden );
       }
     }
-    throw NoSuchText("wrong cls");
+    return 0;
+  }
+
+  const TextContent *Correction::text_content( const string& cls,
+					       bool show_hidden ) const {
+    /// Get the TextContent explicitly associated with a Correction
+    /*!
+     * \param cls the textclass to search for
+     * \param show_hidden if true also return text of 'hidden' nodes
+     *
+     * Returns the TextContent instance rather than the actual text.
+     * (so it might return iself.. ;)
+     * recurses into children looking for New or Current nodes
+     * might throw NoSuchText exception if not found.
+     */
+    const TextContent *result = find_text_content( cls, show_hidden );
+    if ( !result ){
+      throw NoSuchText("wrong cls");
+    }
+    return result;
   }
 
   Correction *Correction::correct( const std::vector<FoliaElement*>&,
@@ -5816,36 +6824,54 @@ namespace folia {
     return parent()->correct( args );
   }
 
-  const PhonContent *Correction::phon_content( const string& cls,
-					       bool show_hidden ) const {
+  const PhonContent *Correction::find_phon_content( const string& cls,
+						    bool show_hidden ) const {
     /// Get the PhonContent explicitly associated with this element.
     /*!
      * \param cls the textclass to search for
      * \param show_hidden if true also return text og 'hidden' nodes
+     * \return the PhonContent found, or 0
      *
      * Returns the PhonContent instance rather than the actual text.
      * (so it might return iself.. ;)
      * recurses into children looking for New or Current
-     * might throw NoSuchPhon exception if not found.
      */
     // TODO: this implements correctionhandling::EITHER only
     for ( const auto& el: data() ) {
       if ( el->isinstance( New_t ) || el->isinstance( Current_t ) ) {
-	return el->phon_content( cls, show_hidden );
+	return el->find_phon_content( cls, show_hidden );
       }
     }
     for ( const auto& el: data() ) {
       if ( el->isinstance( Original_t ) ) {
-	return el->phon_content( cls, show_hidden );
+	return el->find_phon_content( cls, show_hidden );
       }
     }
-    throw NoSuchPhon("wrong cls");
+    return 0;
+  }
+
+  const PhonContent *Correction::phon_content( const string& cls,
+					       bool show_hidden ) const {
+    /// Get the PhonContent explicitly associated with this element.
+    /*!
+     * \param cls the textclass to search for
+     * \param show_hidden if true also return text og 'hidden' nodes
+     *
+     * Returns the PhonContent instance rather than the actual text.
+     * (so it might return iself.. ;)
+     * recurses into children looking for New or Current
+     * might throw NoSuchPhon exception if not found.
+     */
+    const PhonContent *result = find_phon_content( cls, show_hidden );
+    if ( !result ){
+      throw NoSuchPhon("wrong cls");
+    }
+    return result;
   }
 
   bool Correction::hasNew() const {
     ///  check if this Correction has a New node
-    vector<FoliaElement*> v = select( New_t, SELECT_FLAGS::LOCAL );
-    return !v.empty();
+    return getNew() != 0;
   }
 
   New *Correction::getNew() const {
@@ -5853,11 +6879,9 @@ namespace folia {
     /*!
      * \return the new node or 0 if not available
      */
-    vector<New*> v = FoliaElement::select<New>( false );
-    if ( v.empty() ) {
-      return 0;
-    }
-    return v[0];
+    std::lock_guard<std::mutex> lock( text_cache_mutex( this ) );
+    resolve_children();
+    return _new_child;
   }
 
   FoliaElement *Correction::getNew( size_t index ) const {
@@ -5872,8 +6896,7 @@ namespace folia {
 
   bool Correction::hasOriginal() const {
     ///  check if this Correction has an Original node
-    vector<FoliaElement*> v = select( Original_t, SELECT_FLAGS::LOCAL );
-    return !v.empty();
+    return getOriginal() != 0;
   }
 
   Original *Correction::getOriginal() const {
@@ -5881,11 +6904,9 @@ namespace folia {
     /*!
      * \return the new node or 0 if not available
      */
-    vector<Original*> v = FoliaElement::select<Original>( false );
-    if ( v.empty() ) {
-      return 0;
-    }
-    return v[0];
+    std::lock_guard<std::mutex> lock( text_cache_mutex( this ) );
+    resolve_children();
+    return _original_child;
   }
 
   FoliaElement *Correction::getOriginal( size_t index ) const {
@@ -5900,8 +6921,9 @@ namespace folia {
 
   bool Correction::hasCurrent( ) const {
     ///  check if this Correction has a New node
-    vector<FoliaElement*> v = select( Current_t, SELECT_FLAGS::LOCAL );
-    return !v.empty();
+    std::lock_guard<std::mutex> lock( text_cache_mutex( this ) );
+    resolve_children();
+    return _current_child != 0;
   }
 
   Current *Correction::getCurrent( ) const {
@@ -5909,11 +6931,16 @@ namespace folia {
     /*!
      * \return the new node or 0 if not available
      */
-    vector<Current*> v = FoliaElement::select<Current>( false );
-    if ( v.empty() ) {
+    Current *result = 0;
+    {
+      std::lock_guard<std::mutex> lock( text_cache_mutex( this ) );
+      resolve_children();
+      result = _current_child;
+    }
+    if ( !result ) {
       throw NoSuchAnnotation( "current" );
     }
-    return v[0];
+    return result;
   }
 
   FoliaElement *Correction::getCurrent( size_t index ) const {
@@ -5928,13 +6955,16 @@ namespace folia {
 
   bool Correction::hasSuggestions( ) const {
     ///  check if this Correction has Suggestion nodes
-    vector<Suggestion*> v = suggestions();
-    return !v.empty();
+    std::lock_guard<std::mutex> lock( text_cache_mutex( this ) );
+    resolve_children();
+    return !_suggestion_children.empty();
   }
 
   vector<Suggestion*> Correction::suggestions( ) const {
     /// get all Suggestion nodes of this Correction
-    return FoliaElement::select<Suggestion>( false );
+    std::lock_guard<std::mutex> lock( text_cache_mutex( this ) );
+    resolve_children();
+    return _suggestion_children;
   }
 
   Suggestion *Correction::suggestions( size_t index ) const {
@@ -5943,11 +6973,12 @@ namespace folia {
      * \param index the position in list of Suggestion nodes
      * \return the Suggestion or 0 if not available
      */
-    vector<Suggestion*> v = suggestions();
-    if ( v.empty() || index >= v.size() ) {
+    std::lock_guard<std::mutex> lock( text_cache_mutex( this ) );
+    resolve_children();
+    if ( index >= _suggestion_children.size() ) {
       throw NoSuchAnnotation( "suggestion" );
     }
-    return v[index];
+    return _suggestion_children[index];
   }
 
   Head *Division::head() const {
@@ -6095,6 +7126,7 @@ namespace folia {
     UnicodeString us = TiCC::UnicodeFromUTF8(s);
     us = norm.normalize( us );
     _value = TiCC::UnicodeToUTF8( us );
+    invalidate_text_cache();
     return true;
   }
 
@@ -6105,11 +7137,24 @@ namespace folia {
     return TiCC::UnicodeFromUTF8(_value);
   }
 
+  bool XmlText::private_try_text( UnicodeString& result,
+				  const string&,
+				  bool, bool, bool, bool ) const {
+    /// get the UnicodeString value of an XmlText element. Never fails
+    result = TiCC::UnicodeFromUTF8(_value);
+    return true;
+  }
+
   xmlNode *XmlText::xml( bool, bool ) const {
     ///  convert an XmlText node to an xmlNode
     return xmlNewText( (const xmlChar*)_value.c_str() );
   }
 
+  void XmlText::write_xml( XmlWriter& w, bool ) const {
+    ///  write an XmlText node as XML text
+    w.text( _value );
+  }
+
   FoliaElement* XmlText::parseXml( const xmlNode *node ) {
     /// parse a Xmltext node at node
     /*!
@@ -6284,6 +7329,11 @@ namespace folia {
     return xmlNewComment( (const xmlChar*)_value.c_str() );
   }
 
+  void XmlComment::write_xml( XmlWriter& w, bool ) const {
+    ///  write an XmlComment node as XML text
+    w.comment( _value );
+  }
+
   FoliaElement* XmlComment::parseXml( const xmlNode *node ) {
     /// parse a XmlComment node
     /*!
@@ -6421,7 +7471,6 @@ namespace folia {
 
   ForeignData::~ForeignData(){
     /// destructor for ForeignData
-    xmlFreeNode( _foreign_data );
   }
 
   FoliaElement* ForeignData::parseXml( const xmlNode *node ){
@@ -6439,21 +7488,63 @@ namespace folia {
     return get_data();
   }
 
-  void ForeignData::set_data( const xmlNode *node ){
-    /// assign node to _foreign_data
+  void ForeignData::write_xml( XmlWriter& w, bool ) const {
+    /// write the data of the ForeignData node as XML text
     /*!
-     * performs sanity check to avoid adding FoLiA nodes
+     * The stored XML is copied as is. Only when it has to be formatted at
+     * another level than the one it was stored for, it is parsed again.
      */
-    xmlNode *p = (xmlNode *)node->children;
-    while ( p ){
-      string pref;
-      string ns = getNS( p, pref );
-      if ( ns == NSFOLIA ){
-	throw XmlError( "ForeignData MAY NOT be in the FoLiA namespace" );
+    if ( _data.empty() ){
+      return;
+    }
+    size_t level = w.node_level();
+    if ( level == string::npos
+	 || _formatted.empty() ){
+      w.verbatim( _data );
+    }
+    else if ( level == _level ){
+      w.verbatim( _formatted );
+    }
+    else {
+      xmlNode *data = get_data();
+      w.node( data );
+      xmlFreeNode( data );
+    }
+  }
+
+  static string dump_node( xmlNode *node, size_t level, bool format ){
+    /// serialize node like libxml2 does
+    /*!
+     * \param node the node to serialize
+     * \param level the indentation level
+     * \param format should the result be formatted?
+     * \return the XML text of the node
+     */
+    xmlBuffer *buf = xmlBufferCreate();
+    xmlNodeDump( buf, node->doc, node, level, format?1:0 );
+    string result( (const char*)xmlBufferContent( buf ),
+		   xmlBufferLength( buf ) );
+    xmlBufferFree( buf );
+    return result;
+  }
+
+  static bool is_formattable( const xmlNode *node ){
+    /// would libxml2 format the content of node?
+    /*!
+     * libxml2 formats an element only when it has children, and none of
+     * them is text. Otherwise the output is the same at every level.
+     */
+    if ( !node->children ){
+      return false;
+    }
+    for ( const xmlNode *p = node->children; p; p = p->next ){
+      if ( p->type == XML_TEXT_NODE
+	   || p->type == XML_CDATA_SECTION_NODE
+	   || p->type == XML_ENTITY_REF_NODE ){
+	return false;
       }
-      p = p->next;
     }
-    _foreign_data = xmlCopyNode( (xmlNode*)node, 1 );
+    return true;
   }
 
   void clean_ns( xmlNode *node, const string& ns ){
@@ -6480,14 +7571,75 @@ namespace folia {
     }
   }
 
+  void ForeignData::set_data( const xmlNode *node ){
+    /// store node as XML text
+    /*!
+     * performs sanity check to avoid adding FoLiA nodes
+     *
+     * The node is serialized once, with cleaned-out FoLiA namespace
+     * declarations. When formatting makes a difference, we also store it
+     * formatted at the level of node in its tree, as that is where it will
+     * usually be written again.
+     */
+    xmlNode *p = (xmlNode *)node->children;
+    while ( p ){
+      string pref;
+      string ns = getNS( p, pref );
+      if ( ns == NSFOLIA ){
+	throw XmlError( "ForeignData MAY NOT be in the FoLiA namespace" );
+      }
+      p = p->next;
+    }
+    xmlNode *copy = xmlCopyNode( (xmlNode*)node, 1 );
+    clean_ns( copy, NSFOLIA ); // Sanity: remove FoLiA namespace defs, if any
+    // attach it to an UTF-8 document, to get the same attribute escaping
+    // as XmlWriter::node()
+    xmlDoc *tmp = xmlNewDoc( (const xmlChar*)"1.0" );
+    tmp->encoding = xmlStrdup( (const xmlChar*)"UTF-8" );
+    xmlDocSetRootElement( tmp, copy );
+    _data = dump_node( copy, 0, false );
+    _formatted.clear();
+    _level = 0;
+    if ( is_formattable( copy ) ){
+      for ( const xmlNode *a = node->parent;
+	    a && a->type == XML_ELEMENT_NODE;
+	    a = a->parent ){
+	++_level;
+      }
+      _formatted = dump_node( copy, _level, true );
+    }
+    xmlFreeDoc( tmp );
+    mark_modified();
+  }
+
   xmlNode* ForeignData::get_data() const {
-    /// get the _foreign_data as an xmlNode tree
+    /// get the foreign data as an xmlNode tree
     /*!
-     * \return a COPY of the _foreign_daya member.
+     * \return a new xmlNode tree, parsed from the stored XML text.
      * With cleaned-out FoLiA namespace declarations.
+     *
+     * The only namespace that may be used but not declared in the stored
+     * XML is the FoLiA one. When the node has a prefix, it is declared on
+     * a wrapper.
      */
-    xmlNode *result = xmlCopyNode(_foreign_data, 1 );
-    clean_ns( result, NSFOLIA ); // Sanity: remove FoLiA namespace defs, if any
+    if ( _data.empty() ){
+      return 0;
+    }
+    string wrapper = "<wrapper>";
+    string::size_type pos = _data.find_first_of( ": />", 1 );
+    if ( pos != string::npos && _data[pos] == ':' ){
+      wrapper = "<wrapper xmlns:" + _data.substr( 1, pos-1 )
+	+ "=\"" + NSFOLIA + "\">";
+    }
+    string wrapped = wrapper + _data + "</wrapper>";
+    xmlDoc *doc = xmlReadMemory( wrapped.c_str(), wrapped.size(),
+				 0, "UTF-8", XML_PARSER_OPTIONS );
+    if ( !doc ){
+      throw XmlError( "ForeignData: unable to parse the stored data" );
+    }
+    xmlNode *result = xmlCopyNode( xmlDocGetRootElement( doc )->children, 1 );
+    xmlFreeDoc( doc );
+    clean_ns( result, NSFOLIA );
     return result;
   }
 
@@ -6621,6 +7773,30 @@ namespace folia {
     return AbstractElement::private_text( cls, retaintok, strict, show_hidden, trim_spaces );
   }
 
+  bool TextMarkupCorrection::private_try_text( UnicodeString& result,
+					       const string& cls,
+					       bool retaintok,
+					       bool strict,
+					       bool show_hidden,
+					       bool trim_spaces ) const{
+    /// get the UnicodeString value of a TextMarkupCorrection, without throwing
+    /*!
+     * \param result the Unicode String representation found
+     * \param cls The textclass we are looking for
+     * \param retaintok retain the tokenisation information
+     * \param strict If true, return the text of this level only
+     * \param show_hidden include text form 'hidden' nodes too.
+     * \param trim_spaces Trim leading and trailing spaces
+     * \return true when text is found, false otherwise
+     */
+    if ( cls == "original" ) {
+      result = TiCC::UnicodeFromUTF8(_original);
+      return true;
+    }
+    return AbstractElement::private_try_text( result, cls, retaintok, strict,
+					      show_hidden, trim_spaces );
+  }
+
   const FoliaElement* AbstractTextMarkup::resolveid() const {
     /// return the FoliaElement refered to by idref
     /*!
@@ -6666,7 +7842,9 @@ namespace folia {
 
   void ForeignData::init() {
     /// set default value on creation
-    _foreign_data = 0;
+    _data.clear();
+    _formatted.clear();
+    _level = 0;
   }
 
 } // namespace folia
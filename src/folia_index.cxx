@@ -0,0 +1,458 @@
+/*
+  Copyright (c) 2006 - 2021
+  CLST  - Radboud University
+  ILK   - Tilburg University
+
+  This file is part of libfolia
+
+  libfolia is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  libfolia is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, see <http://www.gnu.org/licenses/>.
+
+  For questions and suggestions, see:
+      https://github.com/LanguageMachines/ticcutils/issues
+  or send mail to:
+      lamasoftware (at ) science.ru.nl
+*/
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <stdexcept>
+#include "ticcutils/StringOps.h"
+#include "ticcutils/Unicode.h"
+#include "libfolia/folia.h"
+
+using namespace std;
+
+namespace folia {
+
+  /// the first line of every Index file
+  static const string index_magic = "FoLiA-index 1";
+
+  static string escape( const string& s ){
+    /// escape tabs, newlines, carriage returns and backslashes in s
+    string result;
+    for ( const auto& c : s ){
+      switch ( c ){
+      case '\\':
+	result += "\\\\";
+	break;
+      case '\t':
+	result += "\\t";
+	break;
+      case '\n':
+	result += "\\n";
+	break;
+      case '\r':
+	result += "\\r";
+	break;
+      default:
+	result += c;
+      }
+    }
+    return result;
+  }
+
+  static string unescape( const string& s ){
+    /// undo the effect of escape()
+    string result;
+    for ( size_t i=0; i < s.size(); ++i ){
+      if ( s[i] == '\\' && i+1 < s.size() ){
+	++i;
+	switch ( s[i] ){
+	case 't':
+	  result += '\t';
+	  break;
+	case 'n':
+	  result += '\n';
+	  break;
+	case 'r':
+	  result += '\r';
+	  break;
+	default:
+	  result += s[i];
+	}
+      }
+      else {
+	result += s[i];
+      }
+    }
+    return result;
+  }
+
+  static size_t split_tabs( const string& line, vector<string>& parts ){
+    /// split a line at tabs, keeping empty fields
+    parts.clear();
+    string::size_type pos = 0;
+    while ( true ){
+      string::size_type tab = line.find( '\t', pos );
+      if ( tab == string::npos ){
+	parts.push_back( line.substr( pos ) );
+	break;
+      }
+      parts.push_back( line.substr( pos, tab-pos ) );
+      pos = tab + 1;
+    }
+    return parts.size();
+  }
+
+  Index::Index(){
+    /// create an empty Index, indexing the text, lemma and pos of Words
+    add_field( BASE );
+    add_field( LemmaAnnotation_t );
+    add_field( PosAnnotation_t );
+  }
+
+  Index::~Index(){
+    /// destroy an Index, and all Documents resolved so far
+    clear_cache();
+  }
+
+  string Index::field_name( ElementType et, const string& st ){
+    /// return the name of the field used for an annotation type and set
+    /*!
+      \param et the type of the annotation. BASE means the text of the Word
+      \param st the annotation set. An empty set means: any set
+      \return the field name, like 'text', 'pos' or 'pos@setname'
+    */
+    string result;
+    if ( et == BASE ){
+      result = "text";
+    }
+    else {
+      result = toString( et );
+    }
+    if ( !st.empty() ){
+      result += "@" + st;
+    }
+    return result;
+  }
+
+  void Index::add_field( ElementType et, const string& st ){
+    /// add a field to the set of indexed fields
+    /*!
+      \param et the annotation type. Use BASE to index the text of the Words
+      \param st an optional set. When empty, all sets are indexed in the
+      same field
+    */
+    pair<ElementType,string> fld = make_pair( et, st );
+    for ( const auto& f : _fields ){
+      if ( f == fld ){
+	return;
+      }
+    }
+    _fields.push_back( fld );
+  }
+
+  vector<string> Index::fields() const {
+    /// return the names of all indexed fields
+    vector<string> result;
+    if ( !_terms.empty() ){
+      for ( const auto& it : _terms ){
+	result.push_back( it.first );
+      }
+    }
+    else {
+      for ( const auto& f : _fields ){
+	result.push_back( field_name( f.first, f.second ) );
+      }
+    }
+    return result;
+  }
+
+  size_t Index::term_count() const {
+    /// return the total number of distinct terms over all fields
+    size_t result = 0;
+    for ( const auto& it : _terms ){
+      result += it.second.size();
+    }
+    for ( const auto& it : _postings ){
+      result += it.second.size();
+    }
+    return result;
+  }
+
+  size_t Index::add_file( const string& file_name ){
+    /// parse a FoLiA file and add all its Words to the Index
+    /*!
+      \param file_name the file to index
+      \return the number of Words indexed
+      The Document is parsed without text consistency checks, which are
+      irrelevant for indexing.
+    */
+    Document doc;
+    doc.set_checktext( false );
+    // NOT via a "file='...'" argument, which breaks on a ' in file_name
+    doc.read_from_file( file_name );
+    return add_document( doc, file_name );
+  }
+
+  size_t Index::add_document( const Document& doc, const string& file_name ){
+    /// add all Words of a Document to the Index
+    /*!
+      \param doc the Document to index
+      \param file_name the name under which the Document can be found
+      again, to resolve the postings
+      \return the number of Words indexed
+    */
+    if ( _is.is_open() ){
+      throw logic_error( "Index::add_document(): impossible on a loaded Index" );
+    }
+    size_t file = _files.size();
+    _files.push_back( file_name );
+    vector<Word*> wv = doc.words();
+    for ( size_t ordinal=0; ordinal < wv.size(); ++ordinal ){
+      const Word *w = wv[ordinal];
+      for ( const auto& fld : _fields ){
+	posting_map& pm = _postings[field_name( fld.first, fld.second )];
+	if ( fld.first == BASE ){
+	  try {
+	    string val = TiCC::UnicodeToUTF8( w->text() );
+	    pm[val].push_back( posting( file, w->id(), ordinal ) );
+	  }
+	  catch ( const NoSuchText& ){
+	    // no text, nothing to index
+	  }
+	}
+	else {
+	  vector<FoliaElement*> av = w->select( fld.first,
+						fld.second,
+						default_ignore_annotations,
+						SELECT_FLAGS::LOCAL );
+	  for ( const auto& a : av ){
+	    pm[a->cls()].push_back( posting( file, w->id(), ordinal ) );
+	  }
+	}
+      }
+    }
+    return wv.size();
+  }
+
+  void Index::save( const string& file_name ) const {
+    /// write the Index to a file
+    /*!
+      \param file_name the name of the file to create
+
+      The file starts with a header listing the files and the term
+      dictionary, followed by the postings of all terms. The dictionary
+      holds the offset of every postings list, so a loaded Index can look
+      up a term without reading all postings.
+    */
+    if ( _is.is_open() ){
+      throw logic_error( "Index::save(): impossible on a loaded Index" );
+    }
+    ofstream os( file_name, ios::binary );
+    if ( !os ){
+      throw runtime_error( "Index::save(): unable to open: " + file_name );
+    }
+    stringstream dict;
+    stringstream post;
+    size_t terms = 0;
+    for ( const auto& fld : _postings ){
+      for ( const auto& it : fld.second ){
+	dict << escape(fld.first) << "\t" << escape(it.first) << "\t"
+	     << post.tellp() << "\t" << it.second.size() << "\n";
+	for ( const auto& p : it.second ){
+	  post << p.file << "\t" << p.ordinal << "\t" << escape(p.word_id) << "\n";
+	}
+	++terms;
+      }
+    }
+    os << index_magic << "\n";
+    os << "files\t" << _files.size() << "\n";
+    for ( const auto& f : _files ){
+      os << escape( f ) << "\n";
+    }
+    os << "terms\t" << terms << "\n";
+    os << dict.rdbuf();
+    os << "postings\n";
+    os << post.rdbuf();
+    if ( !os ){
+      throw runtime_error( "Index::save(): failed writing: " + file_name );
+    }
+  }
+
+  void Index::load( const string& file_name ){
+    /// read the header and the term dictionary of an Index file
+    /*!
+      \param file_name the file to read
+      The postings stay on disk until they are looked up.
+    */
+    clear_cache();
+    _files.clear();
+    _postings.clear();
+    _terms.clear();
+    if ( _is.is_open() ){
+      _is.close();
+    }
+    _is.clear();
+    _is.open( file_name, ios::binary );
+    if ( !_is ){
+      throw runtime_error( "Index::load(): unable to open: " + file_name );
+    }
+    string line;
+    if ( !getline( _is, line ) || line != index_magic ){
+      throw runtime_error( "Index::load(): " + file_name
+			   + " is not a FoLiA index file" );
+    }
+    vector<string> parts;
+    size_t count = 0;
+    if ( !getline( _is, line )
+	 || split_tabs( line, parts ) != 2
+	 || parts[0] != "files" ){
+      throw runtime_error( "Index::load(): invalid files header in: " + file_name );
+    }
+    count = TiCC::stringTo<size_t>( parts[1] );
+    for ( size_t i=0; i < count; ++i ){
+      if ( !getline( _is, line ) ){
+	throw runtime_error( "Index::load(): unexpected end of: " + file_name );
+      }
+      _files.push_back( unescape( line ) );
+    }
+    if ( !getline( _is, line )
+	 || split_tabs( line, parts ) != 2
+	 || parts[0] != "terms" ){
+      throw runtime_error( "Index::load(): invalid terms header in: " + file_name );
+    }
+    count = TiCC::stringTo<size_t>( parts[1] );
+    for ( size_t i=0; i < count; ++i ){
+      if ( !getline( _is, line )
+	   || split_tabs( line, parts ) != 4 ){
+	throw runtime_error( "Index::load(): invalid term entry in: " + file_name );
+      }
+      term_entry te;
+      te.offset = TiCC::stringTo<size_t>( parts[2] );
+      te.count = TiCC::stringTo<size_t>( parts[3] );
+      _terms[unescape(parts[0])][unescape(parts[1])] = te;
+    }
+    if ( !getline( _is, line ) || line != "postings" ){
+      throw runtime_error( "Index::load(): missing postings in: " + file_name );
+    }
+    streamoff base = _is.tellg();
+    for ( auto& fld : _terms ){
+      for ( auto& it : fld.second ){
+	it.second.offset += base;
+      }
+    }
+  }
+
+  vector<posting> Index::lookup( const string& field,
+				 const string& term ) const {
+    /// return all postings of a term in a field
+    /*!
+      \param field the field name, as returned by field_name()
+      \param term the value to search for
+      \return a list of postings, in indexing order. May be empty
+    */
+    vector<posting> result;
+    const auto& pit = _postings.find( field );
+    if ( pit != _postings.end() ){
+      const auto& it = pit->second.find( term );
+      if ( it != pit->second.end() ){
+	result = it->second;
+      }
+      return result;
+    }
+    const auto& tit = _terms.find( field );
+    if ( tit == _terms.end() ){
+      return result;
+    }
+    const auto& it = tit->second.find( term );
+    if ( it == tit->second.end() ){
+      return result;
+    }
+    _is.clear();
+    _is.seekg( it->second.offset );
+    string line;
+    vector<string> parts;
+    result.reserve( it->second.count );
+    for ( size_t i=0; i < it->second.count; ++i ){
+      if ( !getline( _is, line )
+	   || split_tabs( line, parts ) != 3 ){
+	throw runtime_error( "Index::lookup(): corrupt postings for: "
+			     + field + "/" + term );
+      }
+      result.push_back( posting( TiCC::stringTo<size_t>( parts[0] ),
+				 unescape( parts[2] ),
+				 TiCC::stringTo<size_t>( parts[1] ) ) );
+    }
+    return result;
+  }
+
+  vector<posting> Index::lookup( const string& term ) const {
+    /// return all postings of a term in the text field
+    return lookup( "text", term );
+  }
+
+  Word *Index::resolve( const posting& p ){
+    /// return the Word a posting refers to
+    /*!
+      \param p the posting
+      \return the Word. The Document it belongs to is parsed the first time
+      it is needed, and stays owned by the Index until clear_cache()
+    */
+    if ( p.file >= _files.size() ){
+      throw range_error( "Index::resolve(): invalid file number "
+			 + TiCC::toString( p.file ) );
+    }
+    Document *doc = 0;
+    const auto& it = _docs.find( p.file );
+    if ( it == _docs.end() ){
+      doc = new Document();
+      doc->set_checktext( false );
+      try {
+	doc->read_from_file( _files[p.file] );
+      }
+      catch ( ... ){
+	delete doc;
+	throw;
+      }
+      _docs[p.file] = doc;
+    }
+    else {
+      doc = it->second;
+    }
+    if ( !p.word_id.empty() ){
+      return dynamic_cast<Word*>( doc->index( p.word_id ) );
+    }
+    vector<Word*> wv = doc->words();
+    if ( p.ordinal >= wv.size() ){
+      throw range_error( "Index::resolve(): invalid word number "
+			 + TiCC::toString( p.ordinal ) + " in "
+			 + _files[p.file] );
+    }
+    return wv[p.ordinal];
+  }
+
+  vector<Word*> Index::resolve( const vector<posting>& pv ){
+    /// return the Words for a list of postings
+    vector<Word*> result;
+    for ( const auto& p : pv ){
+      Word *w = resolve( p );
+      if ( w ){
+	result.push_back( w );
+      }
+    }
+    return result;
+  }
+
+  void Index::clear_cache(){
+    /// delete all Documents resolved so far.
+    /// all Words returned by resolve() become invalid
+    for ( const auto& it : _docs ){
+      delete it.second;
+    }
+    _docs.clear();
+  }
+
+} // namespace folia
@@ -34,6 +34,13 @@
 #include <list>
 #include <stdexcept>
 #include <algorithm>
+#include <thread>
+#include <atomic>
+#include <exception>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "unicode/ustring.h"
 #include "ticcutils/StringOps.h"
 #include "ticcutils/XMLtools.h"
 #include "ticcutils/PrettyPrint.h"
@@ -217,6 +224,235 @@ namespace folia {
     return folia::toString( *this );
   }
 
+  void parallel_for( size_t count,
+		     const function<void(size_t)>& func,
+		     unsigned int threads ){
+    /// run func(i) for all i in [0,count) using several threads
+    /*!
+      \param count the number of tasks
+      \param func the function to call for every task
+      \param threads the maximum number of threads to use. 0 means one per
+      core. The calling thread takes part in the work.
+
+      The tasks are handed out one by one to the first idle thread, so
+      unevenly sized tasks are balanced automaticly. When a task throws,
+      no new tasks are started and the first exception is rethrown in the
+      calling thread after all threads are done.
+    */
+    if ( threads == 0 ){
+      threads = thread::hardware_concurrency();
+    }
+    if ( threads > count ){
+      threads = count;
+    }
+    if ( threads <= 1 ){
+      for ( size_t i=0; i < count; ++i ){
+	func( i );
+      }
+      return;
+    }
+    atomic<size_t> next( 0 );
+    vector<exception_ptr> errors( threads );
+    auto worker = [&]( unsigned int t ){
+      try {
+	size_t i;
+	while ( ( i = next++ ) < count ){
+	  func( i );
+	}
+      }
+      catch ( ... ){
+	errors[t] = current_exception();
+	next = count;
+      }
+    };
+    vector<thread> pool;
+    for ( unsigned int t=1; t < threads; ++t ){
+      pool.push_back( thread( worker, t ) );
+    }
+    worker( 0 );
+    for ( auto& th : pool ){
+      th.join();
+    }
+    for ( const auto& e : errors ){
+      if ( e ){
+	rethrow_exception( e );
+      }
+    }
+  }
+
+  id_index::id_index(): _size(0), _used(0){
+    /// create an empty id_index
+  }
+
+  uint64_t id_index::hash( const char *s, size_t len ){
+    /// the FNV-1a hash of the len bytes at s
+    uint64_t h = 14695981039346656037ULL;
+    for ( size_t i=0; i < len; ++i ){
+      h ^= static_cast<unsigned char>( s[i] );
+      h *= 1099511628211ULL;
+    }
+    return h;
+  }
+
+  size_t id_index::probe( const char *s, size_t len, uint64_t h ) const {
+    /// find the slot for an id
+    /*!
+      \param s the id
+      \param len the length of s
+      \param h the hash of s
+      \return the position of the slot holding s, or the position of the
+      first EMPTY slot when not found
+    */
+    size_t mask = _slots.size() - 1;
+    size_t pos = h & mask;
+    while ( true ){
+      const slot& sl = _slots[pos];
+      if ( sl.state == slot::EMPTY ){
+	return pos;
+      }
+      if ( sl.state == slot::FULL
+	   && sl.hash == h
+	   && sl.key.size() == len
+	   && sl.key.compare( 0, len, s, len ) == 0 ){
+	return pos;
+      }
+      pos = ( pos + 1 ) & mask;
+    }
+  }
+
+  void id_index::rehash( size_t capacity ){
+    /// rebuild the table with the given capacity (a power of 2),
+    /// dropping all DELETED slots
+    vector<slot> old;
+    old.swap( _slots );
+    _slots.resize( capacity );
+    size_t mask = capacity - 1;
+    for ( auto& sl : old ){
+      if ( sl.state == slot::FULL ){
+	size_t pos = sl.hash & mask;
+	while ( _slots[pos].state != slot::EMPTY ){
+	  pos = ( pos + 1 ) & mask;
+	}
+	_slots[pos].hash = sl.hash;
+	_slots[pos].key.swap( sl.key );
+	_slots[pos].value = sl.value;
+	_slots[pos].state = slot::FULL;
+      }
+    }
+    _used = _size;
+  }
+
+  void id_index::reserve( size_t count ){
+    /// make room for at least count ids, without further rehashing
+    size_t capacity = 16;
+    while ( capacity * 7 < count * 10 ){
+      capacity *= 2;
+    }
+    if ( capacity > _slots.size() ){
+      rehash( capacity );
+    }
+  }
+
+  bool id_index::insert( const string& id, FoliaElement *el ){
+    /// add an id to the index
+    /*!
+      \param id the id
+      \param el the FoliaElement to store
+      \return false when the id was already present. The index is unchanged
+    */
+    if ( ( _used + 1 ) * 10 > _slots.size() * 7 ){
+      // keep the load (including DELETED slots) below 70%
+      reserve( ( _size + 1 ) * 2 );
+      if ( ( _used + 1 ) * 10 > _slots.size() * 7 ){
+	rehash( _slots.size() );
+      }
+    }
+    uint64_t h = hash( id.data(), id.size() );
+    size_t pos = probe( id.data(), id.size(), h );
+    slot& sl = _slots[pos];
+    if ( sl.state == slot::FULL ){
+      return false;
+    }
+    sl.hash = h;
+    sl.key = id;
+    sl.value = el;
+    sl.state = slot::FULL;
+    ++_size;
+    ++_used;
+    return true;
+  }
+
+  bool id_index::erase( const string& id ){
+    /// remove an id from the index
+    /*!
+      \param id the id to remove
+      \return true when the id was present
+    */
+    if ( _size == 0 ){
+      return false;
+    }
+    uint64_t h = hash( id.data(), id.size() );
+    size_t pos = probe( id.data(), id.size(), h );
+    slot& sl = _slots[pos];
+    if ( sl.state != slot::FULL ){
+      return false;
+    }
+    sl.key.clear();
+    sl.value = 0;
+    sl.state = slot::DELETED;
+    --_size;
+    return true;
+  }
+
+  FoliaElement *id_index::find( const char *id, size_t len ) const {
+    /// return the FoliaElement stored for an id
+    /*!
+      \param id the id. Need not be 0 terminated
+      \param len the length of id
+      \return the FoliaElement, or 0 when not present
+    */
+    if ( _size == 0 ){
+      return 0;
+    }
+    const slot& sl = _slots[probe( id, len, hash( id, len ) )];
+    if ( sl.state == slot::FULL ){
+      return sl.value;
+    }
+    return 0;
+  }
+
+  vector<FoliaElement*> id_index::find_prefix( const string& prefix ) const {
+    /// return all FoliaElements with an id 'under' prefix
+    /*!
+      \param prefix an id like "doc.p.3.s.7"
+      \return all FoliaElements with an id equal to prefix or starting with
+      prefix followed by a '.', sorted on id. This is a linear scan of the
+      whole index.
+    */
+    vector<pair<string,FoliaElement*>> hits;
+    for ( const auto& sl : _slots ){
+      if ( sl.state == slot::FULL
+	   && sl.key.compare( 0, prefix.size(), prefix ) == 0
+	   && ( sl.key.size() == prefix.size()
+		|| sl.key[prefix.size()] == '.' ) ){
+	hits.push_back( make_pair( sl.key, sl.value ) );
+      }
+    }
+    sort( hits.begin(), hits.end() );
+    vector<FoliaElement*> result;
+    for ( const auto& h : hits ){
+      result.push_back( h.second );
+    }
+    return result;
+  }
+
+  void id_index::clear(){
+    /// remove all ids
+    _slots.clear();
+    _size = 0;
+    _used = 0;
+  }
+
   KWargs getAttributes( const xmlNode *node ){
     KWargs atts;
     if ( node ){
@@ -572,13 +808,81 @@ namespace folia {
     return result;
   }
 
+  inline bool is_plain_ascii( UChar c ){
+    /// is c a printable ASCII character, other then space?
+    /*!
+      these are left untouched by strip_control_chars() and normalize_spaces()
+    */
+    return c > 0x20 && c < 0x7F;
+  }
+
+  static int plain_ascii_run( const UChar *buf, int pos, int len ){
+    /// find the end of a run of plain ASCII characters
+    /*!
+      \param buf the UTF16 buffer to scan
+      \param pos the start position in buf
+      \param len the length of buf
+      \return the position of the first character at or after pos that is
+      NOT plain ASCII, or len
+
+      When SSE2 is available, 8 code units are tested at once.
+    */
+#if defined(__SSE2__)
+    const __m128i low = _mm_set1_epi16( 0x20 );
+    const __m128i high = _mm_set1_epi16( 0x7F );
+    while ( pos + 8 <= len ){
+      // signed compares, so units >= 0x8000 fail the 'low' test too
+      __m128i v = _mm_loadu_si128( (const __m128i*)(buf + pos) );
+      __m128i ok = _mm_and_si128( _mm_cmpgt_epi16( v, low ),
+				  _mm_cmplt_epi16( v, high ) );
+      if ( _mm_movemask_epi8( ok ) != 0xFFFF ){
+	break;
+      }
+      pos += 8;
+    }
+#endif
+    while ( pos < len && is_plain_ascii( buf[pos] ) ){
+      ++pos;
+    }
+    return pos;
+  }
+
   icu::UnicodeString strip_control_chars( const icu::UnicodeString& input ){
+    /// remove all control characters, except newline, CR, tab and a few
+    /// others
+    /*!
+      \param input the UnicodeString to clean
+      \return the stripped string
+
+      Runs of plain ASCII are copied in bulk.
+    */
+    const int len = input.length();
+    const UChar *in = input.getBuffer();
+    int pos = plain_ascii_run( in, 0, len );
+    if ( pos == len ){
+      // nothing to strip
+      return input;
+    }
     UnicodeString result;
-    for ( int i=0; i < input.length(); ++i ){
-       if (input[i] == 0x0a || input[i] == 0x09  || input[i] == 0x0d || input[i] == 0x85 || input[i] == 0x2028 || !u_iscntrl(input[i])) { //newline/cr and tab and a few others are okay, other control characters are ignored
-          result += input[i];
-       }
+    UChar *out = result.getBuffer( len );
+    u_memcpy( out, in, pos );
+    int n = pos;
+    while ( pos < len ){
+      int end = plain_ascii_run( in, pos, len );
+      if ( end > pos ){
+	u_memcpy( out + n, in + pos, end - pos );
+	n += end - pos;
+	pos = end;
+	if ( pos == len ){
+	  break;
+	}
+      }
+      UChar c = in[pos++];
+      if ( c == 0x0a || c == 0x09  || c == 0x0d || c == 0x85 || c == 0x2028 || !u_iscntrl(c) ) { //newline/cr and tab and a few others are okay, other control characters are ignored
+	out[n++] = c;
+      }
     }
+    result.releaseBuffer( n );
     return result;
   }
 
@@ -590,29 +894,66 @@ namespace folia {
       \param input the UnicodeString to normalize
       \param replace_all_control_chars when true, substitute all control-chars
       by a space too. (the default is true)
+
+      Runs of plain ASCII are copied in bulk.
      */
+    const int len = input.length();
+    const UChar *in = input.getBuffer();
+    int pos = plain_ascii_run( in, 0, len );
+    if ( pos == len ){
+      // no spaces at all
+      return input;
+    }
     UnicodeString result;
+    UChar *out = result.getBuffer( len );
+    u_memcpy( out, in, pos );
+    int n = pos;
     bool is_space = false;
-    for ( int i=0; i < input.length(); ++i ){
-      if ( u_isspace( input[i] ) ||  (replace_all_control_chars && u_iscntrl(input[i])) ){
-	if ( is_space ){
-	  continue;
+    while ( pos < len ){
+      int end = plain_ascii_run( in, pos, len );
+      if ( end > pos ){
+	u_memcpy( out + n, in + pos, end - pos );
+	n += end - pos;
+	pos = end;
+	is_space = false;
+	if ( pos == len ){
+	  break;
+	}
+      }
+      UChar c = in[pos++];
+      if ( u_isspace( c ) ||  (replace_all_control_chars && u_iscntrl(c)) ){
+	if ( !is_space ){
+	  is_space = true;
+	  out[n++] = 0x20;
 	}
-	is_space = true;
-	result += " ";
       }
       else {
 	is_space = false;
-	result += input[i];
+	out[n++] = c;
       }
     }
+    result.releaseBuffer( n );
     result.trim(); // remove leading and trailing whitespace;
     return result;
   }
 
   bool is_norm_empty(const std::string& s) {
-      /// checks if the string is empty after normalization (strips all control characters), strings with only spaces/newslines etc are considered empty too
-      return normalize_spaces(TiCC::UnicodeFromUTF8(s)).isEmpty();
+    /// checks if the string is empty after normalization (strips all control characters), strings with only spaces/newslines etc are considered empty too
+    /*!
+      Pure ASCII input is decided on the UTF8 bytes directly: every ASCII
+      character is either plain, or a space or control character.
+    */
+    for ( const auto& c : s ){
+      unsigned char uc = (unsigned char)c;
+      if ( uc >= 0x80 ){
+	// the slow path
+	return normalize_spaces(TiCC::UnicodeFromUTF8(s)).isEmpty();
+      }
+      if ( is_plain_ascii( uc ) ){
+	return false;
+      }
+    }
+    return true;
   }
 
   string get_ISO_date() {
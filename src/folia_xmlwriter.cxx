@@ -0,0 +1,457 @@
+/*
+  Copyright (c) 2006 - 2021
+  CLST  - Radboud University
+  ILK   - Tilburg University
+
+  This file is part of libfolia
+
+  libfolia is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  libfolia is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, see <http://www.gnu.org/licenses/>.
+
+  For questions and suggestions, see:
+      https://github.com/LanguageMachines/ticcutils/issues
+  or send mail to:
+      lamasoftware (at ) science.ru.nl
+*/
+#include <string>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include "libxml/tree.h"
+#include "libfolia/folia.h"
+#include "libfolia/folia_xmlwriter.h"
+
+using namespace std;
+
+namespace folia {
+
+  /// the flush threshold of the internal buffer when writing to a stream
+  const size_t FLUSH_SIZE = 64*1024;
+  /// libxml2 uses an indentation of 2 spaces, upto 30 levels deep
+  const size_t MAX_INDENT = 30;
+  const string INDENT_STRING( 2*MAX_INDENT, ' ' );
+
+  XmlWriter::XmlWriter( ostream& os, bool format ):
+    _os(&os),
+    _out(&_own_buffer),
+    _format(format),
+    _encoding_doc(0),
+    _threads(1),
+    _source(0),
+    _flush_size(FLUSH_SIZE)
+  {
+    /// create an XmlWriter on an output stream
+    /*!
+     * \param os the stream to write to. The output is buffered internally
+     * and written in large chunks
+     * \param format produce formatted (indented) output. Default true.
+     */
+    _own_buffer.reserve( 2*FLUSH_SIZE );
+  }
+
+  XmlWriter::XmlWriter( string& result, bool format ):
+    _os(0),
+    _out(&result),
+    _format(format),
+    _encoding_doc(0),
+    _threads(1),
+    _source(0),
+    _flush_size(FLUSH_SIZE)
+  {
+    /// create an XmlWriter that appends to a string
+    /*!
+     * \param result the string to append to
+     * \param format produce formatted (indented) output. Default true.
+     */
+  }
+
+  XmlWriter::XmlWriter( string& result, const XmlWriter& context ):
+    _os(0),
+    _out(&result),
+    _format(context._format),
+    _prefix(context._prefix),
+    _open(context._open),
+    _encoding_doc(0),
+    _threads(1),
+    _source(0),
+    _flush_size(FLUSH_SIZE)
+  {
+    /// create an XmlWriter for a fragment of the output of another writer
+    /*!
+     * \param result the string to append to
+     * \param context the writer the fragment is meant for.
+     *
+     * The new writer starts in the same state as \e context: same prefix,
+     * formatting and open elements. So the output can be append()-ed to
+     * \e context later, giving exactly the same result as writing it there
+     * directly. This makes it possible to render parts of a document in
+     * separate threads. The fragment writer itself is sequential.
+     */
+  }
+
+  XmlWriter::~XmlWriter(){
+    /// destructor. flushes remaining output, if any
+    flush();
+    if ( _encoding_doc ){
+      xmlFreeDoc( _encoding_doc );
+    }
+  }
+
+  void XmlWriter::flush(){
+    /// write the buffered output to the stream, if any
+    if ( _os && !_out->empty() ){
+      _os->write( _out->data(), _out->size() );
+      _out->clear();
+    }
+  }
+
+  void XmlWriter::append( const string& fragment ){
+    /// add output produced by a fragment writer
+    /*!
+     * \param fragment the output of an XmlWriter constructed with this
+     * writer as context, in the same state as we are now.
+     */
+    *_out += fragment;
+    if ( _os && _flush_size > 0 && _out->size() > _flush_size ){
+      flush();
+    }
+  }
+
+  void XmlWriter::splice( size_t begin, size_t end ){
+    /// output a node by copying its XML from the source
+    /*!
+     * \param begin the start of the node in the source
+     * \param end the end of the node in the source
+     *
+     * The node is placed like node() would do, but its contents are copied
+     * as is, so the inner formatting is that of the source.
+     */
+    indent();
+    _out->append( *_source, begin, end - begin );
+    after_node();
+  }
+
+  void XmlWriter::indent(){
+    /// add indentation for the current level, when formatting
+    if ( !_open.empty()
+	 && _open.back().second ){
+      size_t level = min( _open.size(), MAX_INDENT );
+      _out->append( INDENT_STRING, 0, 2*level );
+    }
+  }
+
+  void XmlWriter::after_node(){
+    /// finish a node: top level nodes and formatted nodes end with a newline
+    if ( _open.empty()
+	 || _open.back().second ){
+      *_out += '\n';
+    }
+    if ( _os && _flush_size > 0 && _out->size() > _flush_size ){
+      flush();
+    }
+  }
+
+  void XmlWriter::escape_text( const char *s, size_t len ){
+    /// append text content, escaped like libxml2 does
+    const char *end = s + len;
+    const char *start = s;
+    for ( ; s < end; ++s ){
+      const char *rep;
+      switch ( *s ){
+      case '<': rep = "&lt;"; break;
+      case '>': rep = "&gt;"; break;
+      case '&': rep = "&amp;"; break;
+      case '\r': rep = "&#13;"; break;
+      default:
+	continue;
+      }
+      _out->append( start, s - start );
+      *_out += rep;
+      start = s+1;
+    }
+    _out->append( start, end - start );
+  }
+
+  void XmlWriter::escape_attribute( const char *s, size_t len ){
+    /// append an attribute value, escaped like libxml2 does
+    const char *end = s + len;
+    const char *start = s;
+    for ( ; s < end; ++s ){
+      const char *rep;
+      switch ( *s ){
+      case '<': rep = "&lt;"; break;
+      case '>': rep = "&gt;"; break;
+      case '&': rep = "&amp;"; break;
+      case '"': rep = "&quot;"; break;
+      case '\n': rep = "&#10;"; break;
+      case '\r': rep = "&#13;"; break;
+      case '\t': rep = "&#9;"; break;
+      default:
+	continue;
+      }
+      _out->append( start, s - start );
+      *_out += rep;
+      start = s+1;
+    }
+    _out->append( start, end - start );
+  }
+
+  void XmlWriter::attribute( const string& name, const string& value ){
+    /// append one attribute
+    *_out += ' ';
+    *_out += name;
+    *_out += "=\"";
+    escape_attribute( value.data(), value.size() );
+    *_out += '"';
+  }
+
+  void XmlWriter::declaration( const string& encoding ){
+    /// output the XML declaration
+    /*!
+     * \param encoding the encoding to mention. Only UTF-8 output is
+     * actually produced.
+     */
+    *_out += "<?xml version=\"1.0\" encoding=\"" + encoding + "\"?>\n";
+  }
+
+  void XmlWriter::processing_instruction( const string& name,
+					  const string& content ){
+    /// output a processing instruction
+    indent();
+    *_out += "<?" + name;
+    if ( !content.empty() ){
+      *_out += ' ';
+      *_out += content;
+    }
+    *_out += "?>";
+    after_node();
+  }
+
+  void XmlWriter::open_tag( const string& prefix, const string& tag ){
+    /// start a new tag: '<prefix:tag'
+    indent();
+    string name;
+    if ( !prefix.empty() ){
+      name = prefix + ":";
+    }
+    name += tag;
+    *_out += '<';
+    *_out += name;
+    _open.push_back( make_pair( name, false ) );
+  }
+
+  void XmlWriter::close_start( content_kind kind ){
+    /// finish the start tag of the last opened element
+    /*!
+     * \param kind what follows. Content of an EMPTY element is closed
+     * immediately, MIXED content switches of formatting for the subtree.
+     */
+    if ( kind == EMPTY ){
+      *_out += "/>";
+      _open.pop_back();
+      after_node();
+      return;
+    }
+    *_out += '>';
+    bool formatted;
+    if ( _open.size() == 1 ){
+      formatted = _format;
+    }
+    else {
+      formatted = _open[_open.size()-2].second;
+    }
+    formatted = formatted && kind == ELEMENTS;
+    _open.back().second = formatted;
+    if ( formatted ){
+      *_out += '\n';
+    }
+  }
+
+  void XmlWriter::start_element( const string& tag,
+				 const KWargs& atts,
+				 content_kind kind ){
+    /// start a FoLiA element in the output
+    /*!
+     * \param tag the (unprefixed) xml tag
+     * \param atts the attributes. These are written in the same order that
+     * addAttributes() gives them: xml:id, xml:lang and id first.
+     * \param kind what kind of content will follow. When EMPTY, the element
+     * is closed immediately and end_element() should NOT be called.
+     */
+    open_tag( _prefix, tag );
+    auto it = atts.find( "xml:id" );
+    if ( it != atts.end() ){
+      attribute( it->first, it->second );
+    }
+    it = atts.find( "lang" );
+    if ( it != atts.end() ){
+      attribute( "xml:lang", it->second );
+    }
+    it = atts.find( "id" );
+    if ( it != atts.end() ){
+      attribute( it->first, it->second );
+    }
+    for ( const auto& att : atts ){
+      if ( att.first != "xml:id"
+	   && att.first != "lang"
+	   && att.first != "id" ){
+	attribute( att.first, att.second );
+      }
+    }
+    close_start( kind );
+  }
+
+  void XmlWriter::start_node( const xmlNode *node, content_kind kind ){
+    /// start an element in the output, using the name, namespace
+    /// declarations and attributes of an xmlNode
+    /*!
+     * \param node the xmlNode to take the start tag from
+     * \param kind what kind of content will follow. When EMPTY, the element
+     * is closed immediately and end_element() should NOT be called.
+     */
+    string prefix;
+    if ( node->ns && node->ns->prefix ){
+      prefix = (const char*)node->ns->prefix;
+    }
+    open_tag( prefix, (const char*)node->name );
+    for ( const xmlNs *ns = node->nsDef; ns; ns = ns->next ){
+      if ( ns->href == 0
+	   || xmlStrEqual( ns->prefix, (const xmlChar*)"xml" ) ){
+	continue;
+      }
+      string name = "xmlns";
+      if ( ns->prefix ){
+	name += ":" + string( (const char*)ns->prefix );
+      }
+      attribute( name, (const char*)ns->href );
+    }
+    for ( const xmlAttr *a = node->properties; a; a = a->next ){
+      string name;
+      if ( a->ns && a->ns->prefix ){
+	name = string( (const char*)a->ns->prefix ) + ":";
+      }
+      name += (const char*)a->name;
+      string value;
+      if ( a->children && a->children->content ){
+	value = (const char*)a->children->content;
+      }
+      attribute( name, value );
+    }
+    close_start( kind );
+  }
+
+  void XmlWriter::end_element(){
+    /// close the last opened element
+    if ( _open.empty() ){
+      throw logic_error( "XmlWriter::end_element() without open element" );
+    }
+    bool formatted = _open.back().second;
+    string name = _open.back().first;
+    _open.pop_back();
+    if ( formatted ){
+      size_t level = min( _open.size(), MAX_INDENT );
+      _out->append( INDENT_STRING, 0, 2*level );
+    }
+    *_out += "</" + name + ">";
+    after_node();
+  }
+
+  void XmlWriter::text( const string& value ){
+    /// output text content
+    escape_text( value.data(), value.size() );
+    after_node();
+  }
+
+  void XmlWriter::cdata( const string& value ){
+    /// output a CDATA block. Like libxml2, we split at ']]>'
+    size_t start = 0;
+    size_t pos = value.find( "]]>" );
+    while ( pos != string::npos ){
+      *_out += "<![CDATA[";
+      _out->append( value, start, pos + 2 - start );
+      *_out += "]]>";
+      start = pos + 2;
+      pos = value.find( "]]>", start );
+    }
+    if ( start < value.size() || value.empty() ){
+      *_out += "<![CDATA[";
+      _out->append( value, start, string::npos );
+      *_out += "]]>";
+    }
+    after_node();
+  }
+
+  void XmlWriter::comment( const string& value ){
+    /// output an XML comment
+    indent();
+    *_out += "<!--" + value + "-->";
+    after_node();
+  }
+
+  void XmlWriter::node( xmlNode *n ){
+    /// output a complete xmlNode tree, using libxml2
+    /*!
+     * \param n the xmlNode to output. When it isn't part of an xmlDoc, it
+     * is temporarily attached to an UTF-8 document, to get the same
+     * attribute escaping as in a complete document.
+     *
+     * This is used for the small (meta)data parts that are only available
+     * as an xmlNode tree, like ForeignData.
+     */
+    indent();
+    bool detached = ( n->doc == 0 );
+    if ( detached ){
+      if ( !_encoding_doc ){
+	_encoding_doc = xmlNewDoc( (const xmlChar*)"1.0" );
+	_encoding_doc->encoding = xmlStrdup( (const xmlChar*)"UTF-8" );
+      }
+      xmlSetTreeDoc( n, _encoding_doc );
+    }
+    bool formatted = _format && ( _open.empty() || _open.back().second );
+    xmlBuffer *buf = xmlBufferCreate();
+    xmlNodeDump( buf, n->doc, n, _open.size(), formatted?1:0 );
+    _out->append( (const char*)xmlBufferContent( buf ), xmlBufferLength( buf ) );
+    xmlBufferFree( buf );
+    if ( detached ){
+      xmlSetTreeDoc( n, 0 );
+    }
+    after_node();
+  }
+
+  size_t XmlWriter::node_level() const {
+    /// the level at which node() would format a node output now
+    /*!
+     * \return the indentation level, or std::string::npos when the node
+     * would be output unformatted
+     */
+    if ( _format && ( _open.empty() || _open.back().second ) ){
+      return _open.size();
+    }
+    return string::npos;
+  }
+
+  void XmlWriter::verbatim( const string& xml ){
+    /// output a node that is already serialized
+    /*!
+     * \param xml the serialized node, as xmlNodeDump() would produce it at
+     * node_level()
+     *
+     * The node is placed like node() would do.
+     */
+    indent();
+    *_out += xml;
+    after_node();
+  }
+
+} // namespace folia
@@ -0,0 +1,149 @@
+/*
+  Copyright (c) 2006 - 2021
+  CLST  - Radboud University
+  ILK   - Tilburg University
+
+  This file is part of libfolia
+
+  libfolia is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  libfolia is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, see <http://www.gnu.org/licenses/>.
+
+  For questions and suggestions, see:
+      https://github.com/LanguageMachines/ticcutils/issues
+  or send mail to:
+      lamasoftware (at ) science.ru.nl
+
+*/
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "ticcutils/CommandLine.h"
+#include "libfolia/folia.h"
+
+using namespace std;
+
+void usage(){
+  cerr << "usage: foliaexport [options] <foliafiles>" << endl;
+  cerr << "options are" << endl;
+  cerr << "\t-h, --help\t\t This help" << endl;
+  cerr << "\t-V, --version\t\t Show versions" << endl;
+  cerr << "\t--format='fmt'\t\t conllu or tsv (default: conllu)" << endl;
+  cerr << "\t-o 'file'\t\t write to 'file' instead of to stdout" << endl;
+  cerr << "\t--upos-set='set'\t the pos set to use for UPOS (default: any)" << endl;
+  cerr << "\t--xpos-set='set'\t the pos set to use for XPOS (default: none)" << endl;
+  cerr << "\t--lemma-set='set'\t the lemma set to use (default: any)" << endl;
+  cerr << "\t--dep-set='set'\t\t the dependency set to use (default: any)" << endl;
+  cerr << "\t--textclass='class'\t the textclass to use (default: current)" << endl;
+  cerr << "\t--stream\t\t read the files sentence by sentence, using an" << endl;
+  cerr << "\t\t\t\t Engine, instead of loading them completely." << endl;
+}
+
+int main( int argc, char* argv[] ){
+  string format = "conllu";
+  string output_name;
+  string upos_set;
+  string xpos_set;
+  string lemma_set;
+  string dep_set;
+  string textclass = "current";
+  bool stream = false;
+  vector<string> fileNames;
+  try {
+    TiCC::CL_Options Opts( "hVo:",
+			   "help,version,format:,upos-set:,xpos-set:,"
+			   "lemma-set:,dep-set:,textclass:,stream" );
+    Opts.init(argc, argv );
+    if ( Opts.extract( 'h' )
+	 || Opts.extract( "help" ) ){
+      usage();
+      return EXIT_SUCCESS;
+    }
+    if ( Opts.extract( 'V' )
+	 || Opts.extract( "version" ) ){
+      cout << "foliaexport version 0.1" << endl;
+      cout << "based on [" << folia::VersionName() << "]" << endl;
+      return EXIT_SUCCESS;
+    }
+    Opts.extract( "format", format );
+    Opts.extract( 'o', output_name );
+    Opts.extract( "upos-set", upos_set );
+    Opts.extract( "xpos-set", xpos_set );
+    Opts.extract( "lemma-set", lemma_set );
+    Opts.extract( "dep-set", dep_set );
+    Opts.extract( "textclass", textclass );
+    stream = Opts.extract( "stream" );
+    if ( !Opts.empty() ){
+      cerr << "unsupported option(s): " << Opts.toString() << endl;
+      return EXIT_FAILURE;
+    }
+    if ( format != "conllu" && format != "tsv" ){
+      cerr << "unsupported format: " << format << endl;
+      usage();
+      return EXIT_FAILURE;
+    }
+    fileNames = Opts.getMassOpts();
+    if ( fileNames.empty() ){
+      cerr << "missing input file(s)" << endl;
+      usage();
+      return EXIT_FAILURE;
+    }
+  }
+  catch( exception& e ){
+    cerr << "FAIL: " << e.what() << endl;
+    exit( EXIT_FAILURE );
+  }
+  ofstream output;
+  if ( !output_name.empty() ){
+    output.open( output_name );
+    if ( !output ){
+      cerr << "unable to open output file: " << output_name << endl;
+      exit( EXIT_FAILURE );
+    }
+  }
+  ostream& os = output_name.empty() ? cout : output;
+  folia::TokenExporter exporter( format == "tsv" ? folia::TokenExporter::TSV
+				 : folia::TokenExporter::CONLLU );
+  exporter.set_upos_set( upos_set );
+  exporter.set_xpos_set( xpos_set );
+  exporter.set_lemma_set( lemma_set );
+  exporter.set_dependency_set( dep_set );
+  exporter.set_textclass( textclass );
+  int fail_count = 0;
+  for ( const auto& inputName : fileNames ){
+    try {
+      size_t count;
+      if ( stream ){
+	folia::Engine engine( inputName );
+	count = exporter.export_engine( os, engine );
+      }
+      else {
+	folia::Document doc( "file='" + inputName + "'" );
+	count = exporter.export_document( os, doc );
+      }
+      cerr << "exported " << count << " words from " << inputName << endl;
+    }
+    catch( exception& e ){
+      cerr << inputName << " failed: " << e.what() << endl;
+      ++fail_count;
+    }
+  }
+  if ( !os ){
+    cerr << "writing the output failed" << endl;
+    exit( EXIT_FAILURE );
+  }
+  if ( fail_count > 0 ){
+    exit( EXIT_FAILURE );
+  }
+  exit( EXIT_SUCCESS );
+}
@@ -0,0 +1,181 @@
+/*
+  Copyright (c) 2006 - 2021
+  CLST  - Radboud University
+  ILK   - Tilburg University
+
+  This file is part of libfolia
+
+  libfolia is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  libfolia is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, see <http://www.gnu.org/licenses/>.
+
+  For questions and suggestions, see:
+      https://github.com/LanguageMachines/ticcutils/issues
+  or send mail to:
+      lamasoftware (at ) science.ru.nl
+
+*/
+#include <iostream>
+#include <string>
+#include <vector>
+#include "ticcutils/CommandLine.h"
+#include "ticcutils/StringOps.h"
+#include "ticcutils/Unicode.h"
+#include "libfolia/folia.h"
+
+using namespace std;
+
+void usage(){
+  cerr << "usage: foliaindex [options] --index=<indexfile> <foliafiles>" << endl;
+  cerr << "   or: foliaindex [options] --index=<indexfile> --query=<term>" << endl;
+  cerr << "options are" << endl;
+  cerr << "\t-h, --help\t\t This help" << endl;
+  cerr << "\t-V, --version\t\t Show versions" << endl;
+  cerr << "\t--index='file'\t\t the index file to create or to search." << endl;
+  cerr << "\t--fields='list'\t\t a comma separated list of annotation types" << endl;
+  cerr << "\t\t\t\t to index, using 'text' for the text of the Words." << endl;
+  cerr << "\t\t\t\t Use 'type@set' to index only one set." << endl;
+  cerr << "\t\t\t\t (default: text,lemma,pos)" << endl;
+  cerr << "\t--query='term'\t\t search the index for 'term'." << endl;
+  cerr << "\t--field='name'\t\t the field to search (default: text)" << endl;
+  cerr << "\t--resolve\t\t show the text and context of every hit." << endl;
+  cerr << "\t\t\t\t This needs the indexed FoLiA files." << endl;
+}
+
+int main( int argc, char* argv[] ){
+  string index_name;
+  string fields;
+  string query;
+  string field = "text";
+  bool resolve = false;
+  vector<string> fileNames;
+  try {
+    TiCC::CL_Options Opts( "hV",
+			   "help,version,index:,fields:,query:,field:,resolve" );
+    Opts.init(argc, argv );
+    if ( Opts.extract( 'h' )
+	 || Opts.extract( "help" ) ){
+      usage();
+      return EXIT_SUCCESS;
+    }
+    if ( Opts.extract( 'V' )
+	 || Opts.extract( "version" ) ){
+      cout << "foliaindex version 0.1" << endl;
+      cout << "based on [" << folia::VersionName() << "]" << endl;
+      return EXIT_SUCCESS;
+    }
+    Opts.extract( "index", index_name );
+    Opts.extract( "fields", fields );
+    Opts.extract( "query", query );
+    Opts.extract( "field", field );
+    resolve = Opts.extract( "resolve" );
+    if ( !Opts.empty() ){
+      cerr << "unsupported option(s): " << Opts.toString() << endl;
+      return EXIT_FAILURE;
+    }
+    fileNames = Opts.getMassOpts();
+    if ( index_name.empty() ){
+      cerr << "missing --index option" << endl;
+      usage();
+      return EXIT_FAILURE;
+    }
+    if ( query.empty() && fileNames.empty() ){
+      cerr << "missing input file(s) or --query option" << endl;
+      usage();
+      return EXIT_FAILURE;
+    }
+    if ( !query.empty() && !fileNames.empty() ){
+      cerr << "--query cannot be combined with input files" << endl;
+      return EXIT_FAILURE;
+    }
+  }
+  catch( exception& e ){
+    cerr << "FAIL: " << e.what() << endl;
+    exit( EXIT_FAILURE );
+  }
+  folia::Index index;
+  if ( !query.empty() ){
+    try {
+      index.load( index_name );
+      vector<folia::posting> hits = index.lookup( field, query );
+      for ( const auto& hit : hits ){
+	cout << index.files()[hit.file] << "\t" << hit.ordinal
+	     << "\t" << hit.word_id;
+	if ( resolve ){
+	  folia::Word *w = index.resolve( hit );
+	  if ( w ){
+	    cout << "\t" << w->str();
+	    folia::FoliaElement *s = w->sentence();
+	    if ( s ){
+	      cout << "\t" << s->str();
+	    }
+	  }
+	}
+	cout << endl;
+      }
+      cerr << hits.size() << " hit(s)" << endl;
+    }
+    catch( exception& e ){
+      cerr << "query failed: " << e.what() << endl;
+      exit( EXIT_FAILURE );
+    }
+    exit( EXIT_SUCCESS );
+  }
+  if ( !fields.empty() ){
+    index.clear_fields();
+    vector<string> fv = TiCC::split_at( fields, "," );
+    for ( const auto& f : fv ){
+      string type = f;
+      string set;
+      string::size_type pos = f.find( "@" );
+      if ( pos != string::npos ){
+	type = f.substr( 0, pos );
+	set = f.substr( pos+1 );
+      }
+      try {
+	if ( type == "text" ){
+	  index.add_field( folia::BASE, set );
+	}
+	else {
+	  index.add_field( folia::stringToElementType( type ), set );
+	}
+      }
+      catch( exception& e ){
+	cerr << "invalid field: '" << f << "' " << e.what() << endl;
+	exit( EXIT_FAILURE );
+      }
+    }
+  }
+  int fail_count = 0;
+  for ( const auto& inputName : fileNames ){
+    try {
+      size_t count = index.add_file( inputName );
+      cerr << "indexed " << count << " words from " << inputName << endl;
+    }
+    catch( exception& e ){
+      cerr << inputName << " failed: " << e.what() << endl;
+      ++fail_count;
+    }
+  }
+  try {
+    index.save( index_name );
+    cerr << "saved " << index.term_count() << " terms in " << index_name << endl;
+  }
+  catch( exception& e ){
+    cerr << "saving failed: " << e.what() << endl;
+    exit( EXIT_FAILURE );
+  }
+  if ( fail_count > 0 ){
+    exit( EXIT_FAILURE );
+  }
+  exit( EXIT_SUCCESS );
+}
@@ -50,6 +50,7 @@ void usage(){
   cerr << "\t-a, --autodeclare\t Attempt to automaticly fix missing annotations." << endl;
   cerr << "\t\t\t\t (default: false)" << endl;
   cerr << "\t-x, --explicit\t\t output explicit FoLiA. (default: false)" << endl;
+  cerr << "\t--compact\t\t output without indentation. (default: false)" << endl;
   cerr << "\t--permissive.\t\t Allow some dubious constructs." << endl;
   cerr << "\t--warn\t\t\t add some extra warnings about library versions and unused" << endl;
   cerr << "\t\t\t\t annotation declarations" << endl;
@@ -70,6 +71,7 @@ int main( int argc, char* argv[] ){
   bool kanon = false;
   bool autodeclare = false;
   bool do_explicit = false;
+  bool compact = false;
   string debug;
   vector<string> fileNames;
   string command;
@@ -77,7 +79,7 @@ int main( int argc, char* argv[] ){
     TiCC::CL_Options Opts( "hVd:ax",
 			   "nochecktext,debug:,permissive,strip,output:,"
 			   "nooutput,help,fixtext,warn,version,canonical,"
-			   "KANON,explicit,autodeclare");
+			   "KANON,explicit,autodeclare,compact");
     Opts.init(argc, argv );
     if ( Opts.extract( 'h' )
 	 || Opts.extract( "help" ) ){
@@ -99,6 +101,7 @@ int main( int argc, char* argv[] ){
     }
     permissive = Opts.extract("permissive");
     do_explicit = ( Opts.extract("explicit") || Opts.extract('x') );
+    compact = Opts.extract("compact");
     warn = Opts.extract("warn");
     nooutput = Opts.extract("nooutput");
     fixtext = Opts.extract("fixtext");
@@ -154,6 +157,9 @@ int main( int argc, char* argv[] ){
   if ( do_explicit ){
     mode += ",explicit";
   }
+  if ( compact ){
+    mode += ",compact";
+  }
   if ( autodeclare ){
     mode += ",autodeclare";
   }
@@ -25,8 +25,10 @@
 
 */
 
+#include <cstdio>
 #include <iostream>
 #include <string>
+#include <sstream>
 #include <map>
 #include "ticcutils/StringOps.h"
 #include "ticcutils/Unicode.h"
@@ -37,6 +39,22 @@ using namespace icu;
 using namespace folia;
 using namespace icu;
 
+static string match_ids( const vector<vector<Word*> >& matches ){
+  /// a readable representation of a findwords() result
+  string result;
+  for ( const auto& match : matches ){
+    result += "[";
+    for ( const auto& w : match ){
+      if ( result.back() != '[' ){
+	result += " ";
+      }
+      result += ( w ? w->id() : "-" );
+    }
+    result += "]";
+  }
+  return result;
+}
+
 int main() {
   cout << "checking sanity" << endl;
   cout << "AnnotationType sanity" << endl;
@@ -152,5 +170,388 @@ int main() {
     cerr << "is_norm_empty() failed." << endl;
     return EXIT_FAILURE;
   }
+  cout << " Saving a modified Document in KEEPSOURCE mode" << endl;
+  string source = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<FoLiA xmlns=\"http://ilk.uvt.nl/folia\" xml:id=\"ks\" version=\"2.4.2\">\n"
+    "  <metadata type=\"native\">\n"
+    "    <annotations>\n"
+    "      <token-annotation/>\n"
+    "      <sentence-annotation/>\n"
+    "      <pos-annotation set=\"cgn\"/>\n"
+    "    </annotations>\n"
+    "  </metadata>\n"
+    "  <text xml:id=\"ks.text\">\n"
+    "    <s xml:id=\"ks.s.1\">\n"
+    "      <w xml:id=\"ks.w.1\"><t>Hallo</t><pos class=\"TSW\"/></w>\n"
+    "      <w xml:id=\"ks.w.2\"><t>wereld</t><pos class=\"N\"/></w>\n"
+    "    </s>\n"
+    "  </text>\n"
+    "</FoLiA>\n";
+  Document kept;
+  kept.set_keepsource( true );
+  kept.read_from_string( source );
+  Document plain;
+  plain.read_from_string( source );
+  for ( auto doc : { &kept, &plain } ){
+    doc->words()[0]->annotation<PosAnnotation>()->confidence( 0.5 );
+    doc->words()[1]->annotation<PosAnnotation>()->update_set( "cgn" );
+  }
+  Document kept_back;
+  kept_back.read_from_string( kept.toXml() );
+  Document plain_back;
+  plain_back.read_from_string( plain.toXml() );
+  if ( kept_back.xmlstring() != plain_back.xmlstring() ){
+    cerr << "KEEPSOURCE output of a modified Document differs:" << endl
+	 << kept.toXml() << endl;
+    return EXIT_FAILURE;
+  }
+  cout << " Saving in parallel" << endl;
+  string par_source = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<FoLiA xmlns=\"http://ilk.uvt.nl/folia\" xml:id=\"par\" version=\"2.4.2\">\n"
+    "  <metadata type=\"native\">\n"
+    "    <annotations>\n"
+    "      <token-annotation/>\n"
+    "      <paragraph-annotation/>\n"
+    "      <pos-annotation set=\"cgn\"/>\n"
+    "    </annotations>\n"
+    "  </metadata>\n"
+    "  <text xml:id=\"par.text\">\n";
+  for ( int i=1; i <= 50; ++i ){
+    string p_id = "par.p." + TiCC::toString( i );
+    par_source += "    <p xml:id=\"" + p_id + "\">\n"
+      "      <w xml:id=\"" + p_id + ".w.1\"><t>woord</t><pos class=\"N\"/></w>\n"
+      "      <w xml:id=\"" + p_id + ".w.2\"><t>" + TiCC::toString( i )
+      + "</t><pos class=\"TW\"/></w>\n"
+      "    </p>\n";
+  }
+  par_source += "  </text>\n</FoLiA>\n";
+  Document par_doc;
+  par_doc.read_from_string( par_source );
+  ostringstream seq_plain;
+  par_doc.save( seq_plain );
+  ostringstream seq_prefixed;
+  par_doc.save( seq_prefixed, "fl" );
+  par_doc.threads = 4;
+  ostringstream par_plain;
+  par_doc.save( par_plain );
+  ostringstream par_prefixed;
+  par_doc.save( par_prefixed, "fl" );
+  if ( par_plain.str() != seq_plain.str()
+       || par_prefixed.str() != seq_prefixed.str() ){
+    cerr << "parallel save differs from sequential save" << endl;
+    return EXIT_FAILURE;
+  }
+  cout << " Saving compressed files" << endl;
+  for ( const string& ext : { ".gz", ".bz2" } ){
+    string file_name = "simpletest.folia.xml" + ext;
+    if ( !plain.save( file_name ) ){
+      cerr << "unable to save " << file_name << endl;
+      return EXIT_FAILURE;
+    }
+    Document back;
+    back.read_from_file( file_name );
+    remove( file_name.c_str() );
+    if ( back.toXml() != plain.toXml() ){
+      cerr << "reading " << file_name << " back gives a different Document"
+	   << endl;
+      return EXIT_FAILURE;
+    }
+  }
+  cout << " Saving and loading a binary Document" << endl;
+  string bin_source = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<FoLiA xmlns=\"http://ilk.uvt.nl/folia\" xml:id=\"bin\" version=\"2.4.2\">\n"
+    "  <metadata type=\"native\">\n"
+    "    <annotations>\n"
+    "      <token-annotation/>\n"
+    "      <sentence-annotation/>\n"
+    "      <pos-annotation set=\"cgn\"/>\n"
+    "      <entity-annotation set=\"ner\"/>\n"
+    "    </annotations>\n"
+    "  </metadata>\n"
+    "  <text xml:id=\"bin.text\">\n"
+    "    <s xml:id=\"bin.s.1\">\n"
+    "      <w xml:id=\"bin.w.1\"><t>Hallo</t><pos class=\"TSW\"/></w>\n"
+    "      <w xml:id=\"bin.w.2\"><t>New</t><pos class=\"SPEC\"/></w>\n"
+    "      <w xml:id=\"bin.w.3\"><t>York</t><pos class=\"SPEC\"/></w>\n"
+    "      <entities>\n"
+    "        <entity xml:id=\"bin.e.1\" class=\"loc\">\n"
+    "          <wref id=\"bin.w.2\" t=\"New\"/>\n"
+    "          <wref id=\"bin.w.3\" t=\"York\"/>\n"
+    "        </entity>\n"
+    "      </entities>\n"
+    "    </s>\n"
+    "  </text>\n"
+    "</FoLiA>\n";
+  Document bin_doc;
+  bin_doc.read_from_string( bin_source );
+  ostringstream bin_os;
+  bin_doc.save_binary( bin_os );
+  string bin_buffer = bin_os.str();
+  Document bin_back;
+  bin_back.read_from_binary( bin_buffer );
+  if ( bin_back.toXml() != bin_doc.toXml() ){
+    cerr << "binary round trip differs:" << endl
+	 << bin_back.toXml() << endl;
+    return EXIT_FAILURE;
+  }
+  // the buffer ends with the wref to bin.w.3. Let it refer to the first
+  // element, the enclosing <text>, which must be rejected
+  string corrupt = bin_buffer;
+  corrupt.back() = 0;
+  try {
+    Document bad;
+    bad.read_from_binary( corrupt );
+    cerr << "a wref to an enclosing element was accepted" << endl;
+    return EXIT_FAILURE;
+  }
+  catch ( const XmlError& ){
+  }
+  cout << " Building and loading an Index" << endl;
+  bin_doc.save( "simpletest.folia.xml" );
+  {
+    Index idx;
+    idx.add_file( "simpletest.folia.xml" );
+    idx.save( "simpletest.fidx" );
+  }
+  Index idx;
+  idx.load( "simpletest.fidx" );
+  vector<Word*> spec = idx.resolve( idx.lookup( "pos", "SPEC" ) );
+  vector<posting> york = idx.lookup( "York" );
+  bool index_ok = spec.size() == 2
+    && spec[0]->id() == "bin.w.2"
+    && spec[1]->id() == "bin.w.3"
+    && york.size() == 1
+    && idx.resolve( york[0] ) == spec[1]
+    && idx.lookup( "pos", "N" ).empty();
+  idx.clear_cache();
+  remove( "simpletest.fidx" );
+  remove( "simpletest.folia.xml" );
+  if ( !index_ok ){
+    cerr << "Index lookup after load() failed" << endl;
+    return EXIT_FAILURE;
+  }
+  cout << " Extracting text with a TextExtractor" << endl;
+  string te_source = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<FoLiA xmlns=\"http://ilk.uvt.nl/folia\" xml:id=\"te\" version=\"2.4.2\">\n"
+    "  <metadata type=\"native\">\n"
+    "    <annotations>\n"
+    "      <token-annotation/>\n"
+    "      <paragraph-annotation/>\n"
+    "      <sentence-annotation/>\n"
+    "      <correction-annotation/>\n"
+    "    </annotations>\n"
+    "  </metadata>\n"
+    "  <text xml:id=\"te.text\">\n"
+    "    <p xml:id=\"te.p.1\">\n"
+    "      <s xml:id=\"te.s.1\">\n"
+    "        <w xml:id=\"te.w.1\" space=\"no\"><t>Hallo</t></w>\n"
+    "        <w xml:id=\"te.w.2\"><t>,</t></w>\n"
+    "        <w xml:id=\"te.w.3\">\n"
+    "          <correction xml:id=\"te.c.1\">\n"
+    "            <new><t>wereld</t></new>\n"
+    "            <original><t>wreld</t></original>\n"
+    "          </correction>\n"
+    "        </w>\n"
+    "      </s>\n"
+    "      <s xml:id=\"te.s.2\">\n"
+    "        <w xml:id=\"te.w.4\"><t>Tot</t></w>\n"
+    "        <w xml:id=\"te.w.5\"><t>ziens</t></w>\n"
+    "      </s>\n"
+    "    </p>\n"
+    "    <p xml:id=\"te.p.2\">\n"
+    "      <t>Een alinea met tekst.</t>\n"
+    "    </p>\n"
+    "  </text>\n"
+    "</FoLiA>\n";
+  Document te_doc;
+  te_doc.read_from_string( te_source );
+  TextExtractor te( te_source );
+  string te_id;
+  string te_text;
+  while ( te.next( te_id, te_text ) ){
+    string expected = TiCC::UnicodeToUTF8( te_doc[te_id]->text() );
+    if ( te_text != expected ){
+      cerr << "TextExtractor: '" << te_text << "' for " << te_id
+	   << " but text() gives '" << expected << "'" << endl;
+      return EXIT_FAILURE;
+    }
+  }
+  if ( te.count() != 2 ){
+    cerr << "TextExtractor: found " << te.count() << " paragraphs" << endl;
+    return EXIT_FAILURE;
+  }
+  cout << " Exporting to CoNLL-U" << endl;
+  string dep_source = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<FoLiA xmlns=\"http://ilk.uvt.nl/folia\" xml:id=\"dep\" version=\"2.4.2\">\n"
+    "  <metadata type=\"native\">\n"
+    "    <annotations>\n"
+    "      <token-annotation/>\n"
+    "      <sentence-annotation/>\n"
+    "      <pos-annotation set=\"ud\"/>\n"
+    "      <pos-annotation set=\"cgn\"/>\n"
+    "      <lemma-annotation set=\"lem\"/>\n"
+    "      <dependency-annotation set=\"udep\"/>\n"
+    "    </annotations>\n"
+    "  </metadata>\n"
+    "  <text xml:id=\"dep.text\">\n"
+    "    <s xml:id=\"dep.s.1\">\n"
+    "      <w xml:id=\"dep.w.1\"><t>Zij</t><pos set=\"cgn\" class=\"VNW\"/>"
+    "<pos set=\"ud\" class=\"PRON\"><feat subset=\"Person\" class=\"3\"/>"
+    "<feat subset=\"Case\" class=\"Nom\"/></pos><lemma set=\"lem\" class=\"zij\"/></w>\n"
+    "      <w xml:id=\"dep.w.2\" space=\"no\"><t>slaapt</t><pos set=\"ud\" class=\"VERB\"/>"
+    "<lemma set=\"lem\" class=\"slapen\"/></w>\n"
+    "      <w xml:id=\"dep.w.3\"><t>.</t><pos set=\"ud\" class=\"PUNCT\"/></w>\n"
+    "      <dependencies>\n"
+    "        <dependency set=\"udep\" class=\"root\"><dep><wref id=\"dep.w.2\" t=\"slaapt\"/></dep></dependency>\n"
+    "        <dependency set=\"udep\" class=\"nsubj\"><hd><wref id=\"dep.w.2\" t=\"slaapt\"/></hd>"
+    "<dep><wref id=\"dep.w.1\" t=\"Zij\"/></dep></dependency>\n"
+    "      </dependencies>\n"
+    "    </s>\n"
+    "  </text>\n"
+    "</FoLiA>\n";
+  Document dep_doc;
+  dep_doc.read_from_string( dep_source );
+  TokenExporter exporter;
+  exporter.set_upos_set( "ud" );
+  exporter.set_xpos_set( "cgn" );
+  ostringstream conllu;
+  exporter.export_document( conllu, dep_doc );
+  string expected_conllu = "# sent_id = dep.s.1\n"
+    "# text = Zij slaapt.\n"
+    "1\tZij\tzij\tPRON\tVNW\tCase=Nom|Person=3\t2\tnsubj\t_\t_\n"
+    "2\tslaapt\tslapen\tVERB\t_\t_\t0\troot\t_\tSpaceAfter=No\n"
+    "3\t.\t_\tPUNCT\t_\t_\t_\t_\t_\t_\n"
+    "\n";
+  if ( conllu.str() != expected_conllu ){
+    cerr << "CoNLL-U export differs:" << endl << conllu.str() << endl;
+    return EXIT_FAILURE;
+  }
+  cout << " Extracting word columns" << endl;
+  string col_source = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<FoLiA xmlns=\"http://ilk.uvt.nl/folia\" xml:id=\"col\" version=\"2.4.2\">\n"
+    "  <metadata type=\"native\">\n"
+    "    <annotations>\n"
+    "      <token-annotation/>\n"
+    "      <sentence-annotation/>\n"
+    "      <pos-annotation set=\"cgn\"/>\n"
+    "      <correction-annotation/>\n"
+    "    </annotations>\n"
+    "  </metadata>\n"
+    "  <text xml:id=\"col.text\">\n"
+    "    <s xml:id=\"col.s.1\">\n"
+    "      <w xml:id=\"col.w.1\"><t>caf\xC3\xA9\xF0\x9F\x98\x80</t><pos class=\"N\"/></w>\n"
+    "      <w xml:id=\"col.w.2\"><t>wereld</t>\n"
+    "        <correction xml:id=\"col.c.1\">\n"
+    "          <new><pos class=\"N\"/></new>\n"
+    "          <original><pos class=\"ADJ\"/></original>\n"
+    "        </correction>\n"
+    "      </w>\n"
+    "    </s>\n"
+    "  </text>\n"
+    "</FoLiA>\n";
+  Document col_doc;
+  col_doc.read_from_string( col_source );
+  word_columns cols;
+  cols.extract( col_doc );
+  if ( cols["length"].values[0] != 5
+       || cols["pos"].str( 0 ) != "N"
+       || cols["pos"].str( 1 ) != "N" ){
+    cerr << "word_columns: wrong length or pos: "
+	 << cols["length"].values[0] << " "
+	 << cols["pos"].str( 0 ) << " " << cols["pos"].str( 1 ) << endl;
+    return EXIT_FAILURE;
+  }
+  cout << " Searching with findwords()" << endl;
+  string fw_source = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<FoLiA xmlns=\"http://ilk.uvt.nl/folia\" xml:id=\"fw\" version=\"2.4.2\">\n"
+    "  <metadata type=\"native\">\n"
+    "    <annotations>\n"
+    "      <token-annotation/>\n"
+    "      <paragraph-annotation/>\n"
+    "      <sentence-annotation/>\n"
+    "      <pos-annotation set=\"cgn\"/>\n"
+    "    </annotations>\n"
+    "  </metadata>\n"
+    "  <text xml:id=\"fw.text\">\n"
+    "    <p xml:id=\"fw.p.1\">\n"
+    "      <s xml:id=\"fw.s.1\">\n"
+    "        <w xml:id=\"w1\"><t>Hallo</t><pos class=\"TSW\"/></w>\n"
+    "        <w xml:id=\"w2\"><t>wereld</t><pos class=\"N\"/></w>\n"
+    "        <w xml:id=\"w3\"><t>.</t><pos class=\"LET\"/></w>\n"
+    "      </s>\n"
+    "      <s xml:id=\"fw.s.2\">\n"
+    "        <w xml:id=\"w4\"><t>Dit</t><pos class=\"VNW\"/></w>\n"
+    "        <w xml:id=\"w5\"><t>is</t><pos class=\"WW\"/></w>\n"
+    "        <w xml:id=\"w6\"><t>een</t><pos class=\"LID\"/></w>\n"
+    "        <w xml:id=\"w7\"><t>test</t><pos class=\"N\"/></w>\n"
+    "        <w xml:id=\"w8\"><t>!</t><pos class=\"LET\"/></w>\n"
+    "      </s>\n"
+    "    </p>\n"
+    "    <p xml:id=\"fw.p.2\">\n"
+    "      <s xml:id=\"fw.s.3\">\n"
+    "        <w xml:id=\"w9\"><t>Tweede</t><pos class=\"ADJ\"/></w>\n"
+    "        <w xml:id=\"w10\"><t>alinea</t><pos class=\"N\"/></w>\n"
+    "      </s>\n"
+    "    </p>\n"
+    "  </text>\n"
+    "</FoLiA>\n";
+  Document fw_doc;
+  fw_doc.read_from_string( fw_source );
+  struct search_case {
+    vector<string> terms;
+    ElementType annotation;
+    string args;
+    string expected;
+  };
+  vector<search_case> searches = {
+    { {"dit","is"}, BASE, "", "[w4 w5]" },
+    { {"dit","is"}, BASE, "casesensitive='1'", "" },
+    { {"hallo","*"}, BASE, "", "[w1 w2]" },
+    { {"wereld","*","dit"}, BASE, "", "[w2 w3 w4]" },
+    { {"dit","*","!"}, BASE, "", "[w4 w5 w6 w7 w8]" },
+    { {"dit","*","!"}, BASE, "maxgapsize='2'", "" },
+    // a match is reported as soon as the term after the gap matches
+    { {"is","*","test","!"}, BASE, "", "[w5 w6 w7]" },
+    { {"*","."}, BASE, "", "[w1 w2 w3]" },
+    { {"*:1","wereld"}, BASE, "", "[w1 w2]" },
+    { {"een","*:1","!"}, BASE, "", "[w6 w7 w8]" },
+    { {"regexp('^[A-Z].*')"}, BASE, "", "[w1][w4][w9]" },
+    { {"regexp('^d.*')","is"}, BASE, "", "" },
+    { {"regexp('(?i)^d.*')","is"}, BASE, "", "[w4 w5]" },
+    { {"N"}, PosAnnotation_t, "", "[w2][w7][w10]" },
+    { {"*:1","N"}, PosAnnotation_t, "", "[w1 w2][w6 w7][w9 w10]" },
+    { {"LET","*","LID"}, PosAnnotation_t, "", "[w3 w4 w5 w6]" },
+    { {"VNW","WW","*","LET"}, PosAnnotation_t, "", "[w4 w5 w6 w7 w8]" }
+  };
+  for ( const auto& sc : searches ){
+    Pattern pat( sc.terms, sc.annotation, sc.args );
+    string found = match_ids( fw_doc.findwords( pat ) );
+    if ( found != sc.expected ){
+      cerr << "findwords() failed for";
+      for ( const auto& t : sc.terms ){
+	cerr << " " << t;
+      }
+      cerr << " {" << sc.args << "}: got '" << found
+	   << "' but expected '" << sc.expected << "'" << endl;
+      return EXIT_FAILURE;
+    }
+  }
+  string found = match_ids( fw_doc.findwords( Pattern( {"test"} ),
+					      "leftcontext='2',rightcontext='2'" ) );
+  if ( found != "[w5 w6 w7 w8 w9]" ){
+    cerr << "findwords() with context failed: got '" << found << "'" << endl;
+    return EXIT_FAILURE;
+  }
+  list<Pattern> same;
+  same.push_back( Pattern( {"Hallo","wereld"} ) );
+  same.push_back( Pattern( {"TSW","N"}, PosAnnotation_t ) );
+  list<Pattern> other;
+  other.push_back( Pattern( {"Hallo","wereld"} ) );
+  other.push_back( Pattern( {"TSW","LET"}, PosAnnotation_t ) );
+  if ( match_ids( fw_doc.findwords( same ) ) != "[w1 w2]"
+       || match_ids( fw_doc.findwords( other ) ) != "" ){
+    cerr << "findwords() with a list of Patterns failed" << endl;
+    return EXIT_FAILURE;
+  }
   return EXIT_SUCCESS;
 }